@@ -0,0 +1,102 @@
+/*
+  Copyright 2023, SINTEF Ocean
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include <benchmark/benchmark.h>
+#include <fastrtps/types/DynamicDataFactory.h>
+#include <fastrtps/types/DynamicTypeBuilder.h>
+#include <xtypes/idl/idl.hpp>
+
+#include "Converter.hpp"
+#include "fixtures.hpp"
+
+namespace {
+
+using ddsfmu::bench::Shape;
+
+/// xtypes and fast-dds instances of a generated `Bench` type
+struct ConverterFixture {
+  ConverterFixture(Shape shape, std::size_t leaves) {
+    // Builders are cached by type name, and all fixtures use the name Bench
+    ddsfmu::Converter::clear_data_structures();
+    context = eprosima::xtypes::idl::parse(ddsfmu::bench::bench_idl(shape, leaves));
+    if (!context.success) { throw std::runtime_error("Could not parse benchmark IDL"); }
+
+    const auto& type = context.module().structure("Bench");
+    xtypes_data = std::make_unique<eprosima::xtypes::DynamicData>(type);
+    ddsfmu::bench::fill_bench(xtypes_data->ref(), shape, leaves);
+
+    auto* builder = ddsfmu::Converter::create_builder(type);
+    if (!builder) { throw std::runtime_error("Could not create builder for benchmark type"); }
+    fastdds_data =
+      eprosima::fastrtps::types::DynamicDataFactory::get_instance()->create_data(builder->build());
+    ddsfmu::Converter::xtypes_to_fastdds(*xtypes_data, fastdds_data.get());
+  }
+
+  ~ConverterFixture() { ddsfmu::Converter::clear_data_structures(); }
+
+  eprosima::xtypes::idl::Context context;
+  std::unique_ptr<eprosima::xtypes::DynamicData> xtypes_data;
+  eprosima::fastrtps::types::DynamicData_ptr fastdds_data;
+};
+
+void BM_XtypesToFastdds(benchmark::State& state, Shape shape) {
+  ConverterFixture fixture(shape, static_cast<std::size_t>(state.range(0)));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+      ddsfmu::Converter::xtypes_to_fastdds(*fixture.xtypes_data, fixture.fastdds_data.get()));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_FastddsToXtypes(benchmark::State& state, Shape shape) {
+  ConverterFixture fixture(shape, static_cast<std::size_t>(state.range(0)));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+      ddsfmu::Converter::fastdds_to_xtypes(fixture.fastdds_data.get(), *fixture.xtypes_data));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+}
+
+#define DDSFMU_CONVERTER_BENCHMARK(func, shape)                                                   \
+  BENCHMARK_CAPTURE(func, shape, Shape::shape)                                                    \
+    ->RangeMultiplier(10)                                                                         \
+    ->Range(ddsfmu::bench::MinLeaves, ddsfmu::bench::MaxLeaves)
+
+// Large sequences and maps of primitives, whose fast-dds elements are reused between samples
+#define DDSFMU_CONVERTER_BENCHMARK_ELEMENTS(func, shape)                                          \
+  BENCHMARK_CAPTURE(func, shape##Elements, Shape::shape)                                          \
+    ->Arg(1000)                                                                                   \
+    ->Arg(100000)                                                                                 \
+    ->Arg(1000000)                                                                                \
+    ->Unit(benchmark::kMicrosecond)
+
+DDSFMU_CONVERTER_BENCHMARK(BM_XtypesToFastdds, Flat);
+DDSFMU_CONVERTER_BENCHMARK(BM_XtypesToFastdds, Nested);
+DDSFMU_CONVERTER_BENCHMARK(BM_XtypesToFastdds, Array);
+DDSFMU_CONVERTER_BENCHMARK(BM_XtypesToFastdds, Matrix);
+DDSFMU_CONVERTER_BENCHMARK(BM_XtypesToFastdds, Sequence);
+DDSFMU_CONVERTER_BENCHMARK(BM_XtypesToFastdds, Map);
+DDSFMU_CONVERTER_BENCHMARK(BM_XtypesToFastdds, Union);
+
+DDSFMU_CONVERTER_BENCHMARK(BM_FastddsToXtypes, Flat);
+DDSFMU_CONVERTER_BENCHMARK(BM_FastddsToXtypes, Nested);
+DDSFMU_CONVERTER_BENCHMARK(BM_FastddsToXtypes, Array);
+DDSFMU_CONVERTER_BENCHMARK(BM_FastddsToXtypes, Matrix);
+DDSFMU_CONVERTER_BENCHMARK(BM_FastddsToXtypes, Sequence);
+DDSFMU_CONVERTER_BENCHMARK(BM_FastddsToXtypes, Map);
+DDSFMU_CONVERTER_BENCHMARK(BM_FastddsToXtypes, Union);
+
+DDSFMU_CONVERTER_BENCHMARK_ELEMENTS(BM_XtypesToFastdds, Sequence);
+DDSFMU_CONVERTER_BENCHMARK_ELEMENTS(BM_XtypesToFastdds, Map);
+DDSFMU_CONVERTER_BENCHMARK_ELEMENTS(BM_FastddsToXtypes, Sequence);
+DDSFMU_CONVERTER_BENCHMARK_ELEMENTS(BM_FastddsToXtypes, Map);
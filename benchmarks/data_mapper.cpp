@@ -0,0 +1,158 @@
+/*
+  Copyright 2023, SINTEF Ocean
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include <cstdint>
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include "DataMapper.hpp"
+#include "fixtures.hpp"
+
+namespace {
+
+using ddsfmu::DataMapper;
+using ddsfmu::bench::Shape;
+
+/// Loads a flat `Bench` of the leaf type and returns the offset of its FMU inputs
+template<std::size_t Index>
+std::int32_t load_mapper(
+  DataMapper& mapper, benchmark::State& state, const std::string& leaf_type) {
+  const auto leaves = static_cast<std::size_t>(state.range(0));
+  auto resources = ddsfmu::bench::bench_resources(
+    "data_mapper_" + leaf_type + std::to_string(leaves),
+    ddsfmu::bench::bench_idl(Shape::Flat, leaves, leaf_type));
+  mapper.reset(resources);
+  return std::get<Index>(mapper.index_offsets("bench", DataMapper::Direction::Write));
+}
+
+void BM_DataMapperSetReal(benchmark::State& state) {
+  DataMapper mapper;
+  const auto offset = load_mapper<0>(mapper, state, "double");
+  const auto leaves = static_cast<std::int32_t>(state.range(0));
+  for (auto _ : state) {
+    for (std::int32_t i = 0; i < leaves; ++i) { mapper.set_double(offset + i, 1.5); }
+  }
+  state.SetItemsProcessed(state.iterations() * leaves);
+}
+
+void BM_DataMapperGetReal(benchmark::State& state) {
+  DataMapper mapper;
+  const auto offset = load_mapper<0>(mapper, state, "double");
+  const auto leaves = static_cast<std::int32_t>(state.range(0));
+  double value;
+  for (auto _ : state) {
+    for (std::int32_t i = 0; i < leaves; ++i) {
+      mapper.get_double(offset + i, value);
+      benchmark::DoNotOptimize(value);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * leaves);
+}
+
+void BM_DataMapperSetInteger(benchmark::State& state) {
+  DataMapper mapper;
+  const auto offset = load_mapper<1>(mapper, state, "int32");
+  const auto leaves = static_cast<std::int32_t>(state.range(0));
+  for (auto _ : state) {
+    for (std::int32_t i = 0; i < leaves; ++i) { mapper.set_int(offset + i, i); }
+  }
+  state.SetItemsProcessed(state.iterations() * leaves);
+}
+
+void BM_DataMapperGetInteger(benchmark::State& state) {
+  DataMapper mapper;
+  const auto offset = load_mapper<1>(mapper, state, "int32");
+  const auto leaves = static_cast<std::int32_t>(state.range(0));
+  std::int32_t value;
+  for (auto _ : state) {
+    for (std::int32_t i = 0; i < leaves; ++i) {
+      mapper.get_int(offset + i, value);
+      benchmark::DoNotOptimize(value);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * leaves);
+}
+
+void BM_DataMapperSetBoolean(benchmark::State& state) {
+  DataMapper mapper;
+  const auto offset = load_mapper<2>(mapper, state, "boolean");
+  const auto leaves = static_cast<std::int32_t>(state.range(0));
+  for (auto _ : state) {
+    for (std::int32_t i = 0; i < leaves; ++i) { mapper.set_bool(offset + i, true); }
+  }
+  state.SetItemsProcessed(state.iterations() * leaves);
+}
+
+void BM_DataMapperGetBoolean(benchmark::State& state) {
+  DataMapper mapper;
+  const auto offset = load_mapper<2>(mapper, state, "boolean");
+  const auto leaves = static_cast<std::int32_t>(state.range(0));
+  bool value;
+  for (auto _ : state) {
+    for (std::int32_t i = 0; i < leaves; ++i) {
+      mapper.get_bool(offset + i, value);
+      benchmark::DoNotOptimize(value);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * leaves);
+}
+
+void BM_DataMapperSetString(benchmark::State& state) {
+  DataMapper mapper;
+  const auto offset = load_mapper<3>(mapper, state, "string");
+  const auto leaves = static_cast<std::int32_t>(state.range(0));
+  const std::string value("a string value of moderate length");
+  for (auto _ : state) {
+    for (std::int32_t i = 0; i < leaves; ++i) { mapper.set_string(offset + i, value); }
+  }
+  state.SetItemsProcessed(state.iterations() * leaves);
+}
+
+void BM_DataMapperGetString(benchmark::State& state) {
+  DataMapper mapper;
+  const auto offset = load_mapper<3>(mapper, state, "string");
+  const auto leaves = static_cast<std::int32_t>(state.range(0));
+  for (std::int32_t i = 0; i < leaves; ++i) {
+    mapper.set_string(offset + i, "a string value of moderate length");
+  }
+  std::string value;
+  for (auto _ : state) {
+    for (std::int32_t i = 0; i < leaves; ++i) {
+      mapper.get_string(offset + i, value);
+      benchmark::DoNotOptimize(value.data());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * leaves);
+}
+
+}
+
+BENCHMARK(BM_DataMapperSetReal)
+  ->RangeMultiplier(10)
+  ->Range(ddsfmu::bench::MinLeaves, ddsfmu::bench::MaxLeaves);
+BENCHMARK(BM_DataMapperGetReal)
+  ->RangeMultiplier(10)
+  ->Range(ddsfmu::bench::MinLeaves, ddsfmu::bench::MaxLeaves);
+BENCHMARK(BM_DataMapperSetInteger)
+  ->RangeMultiplier(10)
+  ->Range(ddsfmu::bench::MinLeaves, ddsfmu::bench::MaxLeaves);
+BENCHMARK(BM_DataMapperGetInteger)
+  ->RangeMultiplier(10)
+  ->Range(ddsfmu::bench::MinLeaves, ddsfmu::bench::MaxLeaves);
+BENCHMARK(BM_DataMapperSetBoolean)
+  ->RangeMultiplier(10)
+  ->Range(ddsfmu::bench::MinLeaves, ddsfmu::bench::MaxLeaves);
+BENCHMARK(BM_DataMapperGetBoolean)
+  ->RangeMultiplier(10)
+  ->Range(ddsfmu::bench::MinLeaves, ddsfmu::bench::MaxLeaves);
+BENCHMARK(BM_DataMapperSetString)
+  ->RangeMultiplier(10)
+  ->Range(ddsfmu::bench::MinLeaves, ddsfmu::bench::MaxLeaves);
+BENCHMARK(BM_DataMapperGetString)
+  ->RangeMultiplier(10)
+  ->Range(ddsfmu::bench::MinLeaves, ddsfmu::bench::MaxLeaves);
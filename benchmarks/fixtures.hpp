@@ -0,0 +1,288 @@
+#pragma once
+
+/*
+  Copyright 2023, SINTEF Ocean
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <xtypes/xtypes.hpp>
+
+namespace ddsfmu {
+namespace bench {
+
+/// Shape of the generated benchmark type
+enum class Shape {
+  Flat,     ///< Struct with leaf members
+  Nested,   ///< Struct of structs with up to 10 leaf members each
+  Array,    ///< Struct with one array of leaves
+  Matrix,   ///< Struct with one two-dimensional array of leaves, with up to 10 columns
+  Sequence, ///< Struct with one unbounded sequence of leaves
+  Map,      ///< Struct with one map from int32 to leaves
+  Union     ///< Struct with union members
+};
+
+/// Number of leaves of benchmarked types, from 1 to 10k
+constexpr std::int64_t MinLeaves = 1;
+constexpr std::int64_t MaxLeaves = 10000;
+
+/**
+   @brief Generates IDL with the struct `Bench` of the given shape
+
+   @param [in] shape Shape of `Bench`
+   @param [in] leaves Number of leaf members, or elements for sequences and maps
+   @param [in] leaf_type IDL type of the leaves
+   @param [in] keyed If true, `Bench` gets the first member `@key int32 id`
+   @return IDL string
+*/
+inline std::string bench_idl(
+  Shape shape, std::size_t leaves, const std::string& leaf_type = "double", bool keyed = false) {
+  std::ostringstream idl;
+  std::ostringstream members;
+
+  if (keyed) { members << "  @key int32 id;\n"; }
+
+  switch (shape) {
+  case Shape::Flat:
+    for (std::size_t i = 0; i < leaves; ++i) {
+      members << "  " << leaf_type << " m" << i << ";\n";
+    }
+    break;
+  case Shape::Nested: {
+    const std::size_t group_size = std::min<std::size_t>(leaves, 10);
+    idl << "struct Group {\n";
+    for (std::size_t i = 0; i < group_size; ++i) {
+      idl << "  " << leaf_type << " m" << i << ";\n";
+    }
+    idl << "};\n\n";
+    for (std::size_t i = 0; i < std::max<std::size_t>(leaves / group_size, 1); ++i) {
+      members << "  Group g" << i << ";\n";
+    }
+    break;
+  }
+  case Shape::Array: members << "  " << leaf_type << " values[" << leaves << "];\n"; break;
+  case Shape::Matrix: {
+    const std::size_t columns = std::min<std::size_t>(leaves, 10);
+    members << "  " << leaf_type << " values[" << std::max<std::size_t>(leaves / columns, 1)
+            << "][" << columns << "];\n";
+    break;
+  }
+  case Shape::Sequence: members << "  sequence<" << leaf_type << "> values;\n"; break;
+  case Shape::Map: members << "  map<int32, " << leaf_type << "> values;\n"; break;
+  case Shape::Union:
+    idl << "union Choice switch (int32) {\n"
+        << "  case 0: " << leaf_type << " value;\n"
+        << "  case 1: int32 other;\n"
+        << "};\n\n";
+    for (std::size_t i = 0; i < leaves; ++i) { members << "  Choice m" << i << ";\n"; }
+    break;
+  }
+
+  idl << "struct Bench {\n" << members.str() << "};\n";
+  return idl.str();
+}
+
+/**
+   @brief Fills sequences and maps of `Bench` with elements
+
+   Generated types with fixed size get their elements at construction. This resizes the
+   sequence or inserts map entries, such that data of all shapes has the requested number
+   of leaves. Union members are set to their first case. Leaves must be double.
+
+   @param [in, out] data Instance of `Bench`
+   @param [in] shape Shape of `Bench`
+   @param [in] leaves Number of leaves
+*/
+inline void
+  fill_bench(eprosima::xtypes::WritableDynamicDataRef data, Shape shape, std::size_t leaves) {
+  namespace ex = eprosima::xtypes;
+  switch (shape) {
+  case Shape::Sequence: data["values"].resize(leaves); break;
+  case Shape::Map:
+    for (std::size_t i = 0; i < leaves; ++i) {
+      ex::DynamicData key(ex::primitive_type<std::int32_t>());
+      key = static_cast<std::int32_t>(i);
+      data["values"][key] = static_cast<double>(i);
+    }
+    break;
+  case Shape::Union:
+    for (std::size_t i = 0; i < leaves; ++i) {
+      data["m" + std::to_string(i)]["value"] = static_cast<double>(i);
+    }
+    break;
+  default: break;
+  }
+}
+
+/**
+   @brief Writes FMU resources with a generated IDL and ddsfmu mapping
+
+   The DDS profile is copied from the unit test resources. The `Bench` type is mapped to
+   the topic `bench` as both FMU input and output, such that written samples are received
+   over loopback.
+
+   @param [in] name Name of folder in the current working directory
+   @param [in] idl Contents of the main IDL file
+   @param [in] key_filter Whether the FMU output uses key filtering
+   @param [in] attributes Attributes of the `<ddsfmu>` node, e.g. `reset="hard"`
+   @return Path to the resources folder
+*/
+inline std::filesystem::path bench_resources(
+  const std::string& name, const std::string& idl, bool key_filter = false,
+  const std::string& attributes = "") {
+  namespace fs = std::filesystem;
+  auto resources = fs::current_path() / "bench_resources" / name / "resources";
+  fs::remove_all(resources);
+  fs::create_directories(resources / "config" / "idl");
+  fs::create_directories(resources / "config" / "dds");
+
+  fs::copy_file(
+    fs::path(DDSFMU_TEST_RESOURCES) / "config" / "dds" / "dds_profile.xml",
+    resources / "config" / "dds" / "dds_profile.xml");
+
+  std::ofstream(resources / "config" / "idl" / "dds-fmu.idl") << idl;
+  std::ofstream(resources / "config" / "dds" / "ddsfmu_mapping.xml")
+    << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    << "<ddsfmu " << attributes << ">\n"
+    << "  <fmu_in topic=\"bench\" type=\"Bench\" />\n"
+    << "  <fmu_out topic=\"bench\" type=\"Bench\" key_filter=\"" << std::boolalpha << key_filter
+    << "\" />\n"
+    << "</ddsfmu>\n";
+
+  return resources;
+}
+
+/**
+   @brief Writes FMU resources of the shipped example with the topic `Roundtrip`
+
+   The DDS profile and IDL are copied from the example configuration of the FMU, and
+   `idl::Signal` is mapped to the topic `Roundtrip` as both FMU input and output, with key
+   filtering as in the shipped mapping.
+
+   @param [in] name Name of folder in the current working directory
+   @param [in] attributes Attributes of the `<ddsfmu>` node, e.g. `transport="local"`
+   @return Path to the resources folder
+*/
+inline std::filesystem::path
+  roundtrip_resources(const std::string& name, const std::string& attributes = "") {
+  namespace fs = std::filesystem;
+  auto resources = fs::current_path() / "bench_resources" / name / "resources";
+  fs::remove_all(resources);
+  fs::create_directories(resources / "config" / "idl");
+  fs::create_directories(resources / "config" / "dds");
+
+  fs::copy_file(
+    fs::path(DDSFMU_EXAMPLE_CONFIG) / "dds_profile.xml",
+    resources / "config" / "dds" / "dds_profile.xml");
+  fs::copy_file(
+    fs::path(DDSFMU_EXAMPLE_IDL) / "dds-fmu.idl", resources / "config" / "idl" / "dds-fmu.idl");
+
+  std::ofstream(resources / "config" / "dds" / "ddsfmu_mapping.xml")
+    << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    << "<ddsfmu " << attributes << ">\n"
+    << "  <fmu_in topic=\"Roundtrip\" type=\"idl::Signal\" />\n"
+    << "  <fmu_out topic=\"Roundtrip\" type=\"idl::Signal\" key_filter=\"true\" />\n"
+    << "</ddsfmu>\n";
+
+  return resources;
+}
+
+/**
+   @brief Writes FMU resources with many topics of a small type over UDP only
+
+   The IDL has `struct Small { double value; };`, mapped to the topics `t0` to `t<n-1>` as FMU
+   inputs, or as FMU outputs. The DDS profile disables intra-process and shared memory
+   delivery and has the flow controller `ddsfmu_batch`, which sends queued samples every
+   millisecond. Samples between two participants of one process are thus sent as UDP
+   datagrams, which can be counted. Fast-dds keeps the first profiles loaded by a process,
+   so this only takes effect if no other resources were loaded before.
+
+   @param [in] name Name of folder in the current working directory
+   @param [in] topics Number of topics
+   @param [in] inputs Whether topics are FMU inputs, otherwise they are FMU outputs
+   @param [in] attributes Attributes of the `<ddsfmu>` node, e.g. `publish_mode="asynchronous"`
+   @return Path to the resources folder
+*/
+inline std::filesystem::path topics_resources(
+  const std::string& name, std::size_t topics, bool inputs, const std::string& attributes = "") {
+  namespace fs = std::filesystem;
+  auto resources = fs::current_path() / "bench_resources" / name / "resources";
+  fs::remove_all(resources);
+  fs::create_directories(resources / "config" / "idl");
+  fs::create_directories(resources / "config" / "dds");
+
+  std::ofstream(resources / "config" / "dds" / "dds_profile.xml")
+    << R"(<?xml version="1.0" encoding="UTF-8"?>
+<dds xmlns="http://www.eprosima.com/XMLSchemas/fastRTPS_Profiles">
+  <library_settings>
+    <intraprocess_delivery>OFF</intraprocess_delivery>
+  </library_settings>
+  <profiles>
+    <transport_descriptors>
+      <transport_descriptor>
+        <transport_id>udp</transport_id>
+        <type>UDPv4</type>
+      </transport_descriptor>
+    </transport_descriptors>
+    <participant profile_name="dds-fmu-default">
+      <domainId>0</domainId>
+      <rtps>
+        <name>dds-fmu</name>
+        <userTransports>
+          <transport_id>udp</transport_id>
+        </userTransports>
+        <useBuiltinTransports>false</useBuiltinTransports>
+        <flow_controller_descriptor_list>
+          <flow_controller_descriptor>
+            <name>ddsfmu_batch</name>
+            <scheduler>FIFO</scheduler>
+            <max_bytes_per_period>1000000</max_bytes_per_period>
+            <period_ms>1</period_ms>
+          </flow_controller_descriptor>
+        </flow_controller_descriptor_list>
+      </rtps>
+    </participant>
+    <publisher profile_name="dds-fmu-default">
+      <qos>
+        <reliability>
+          <kind>BEST_EFFORT</kind>
+        </reliability>
+      </qos>
+    </publisher>
+    <subscriber profile_name="dds-fmu-default">
+      <qos>
+        <reliability>
+          <kind>BEST_EFFORT</kind>
+        </reliability>
+      </qos>
+    </subscriber>
+  </profiles>
+</dds>
+)";
+
+  std::ofstream(resources / "config" / "idl" / "dds-fmu.idl")
+    << "struct Small {\n  double value;\n};\n";
+
+  std::ofstream mapping(resources / "config" / "dds" / "ddsfmu_mapping.xml");
+  mapping << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+          << "<ddsfmu " << attributes << ">\n";
+  for (std::size_t i = 0; i < topics; ++i) {
+    mapping << "  <" << (inputs ? "fmu_in" : "fmu_out") << " topic=\"t" << i
+            << "\" type=\"Small\" />\n";
+  }
+  mapping << "</ddsfmu>\n";
+
+  return resources;
+}
+
+}
+}
@@ -0,0 +1,145 @@
+/*
+  Copyright 2023, SINTEF Ocean
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <cppfmu_cs.hpp>
+
+#include "auxiliaries.hpp"
+#include "fixtures.hpp"
+
+/*
+  These benchmarks go through the FMI C API, as a co-simulation master would. The benchmark
+  executable is linked with the same sources as the dds-fmu module.
+*/
+
+namespace {
+
+using ddsfmu::bench::Shape;
+
+void fmi_logger(fmi2ComponentEnvironment, fmi2String, fmi2Status, fmi2String, fmi2String, ...) {}
+
+const fmi2CallbackFunctions callbacks = {fmi_logger, std::calloc, std::free, nullptr, nullptr};
+
+/// Resources, GUID and resource URI of an FMU with a flat `Bench` of doubles
+struct FmuFixture {
+  FmuFixture(const benchmark::State& state, const std::string& attributes = "")
+      : leaves(static_cast<std::size_t>(state.range(0))) {
+    auto name = "fmu_instance_" + std::to_string(leaves);
+    if (!attributes.empty()) {
+      name += "_" + std::to_string(std::hash<std::string>{}(attributes));
+    }
+
+    resources = ddsfmu::bench::bench_resources(
+      name, ddsfmu::bench::bench_idl(Shape::Flat, leaves), false, attributes);
+    guid = ddsfmu::config::generate_uuid(
+      ddsfmu::config::get_uuid_files(resources.parent_path(), true));
+#ifdef _WIN32
+    uri = "file:///" + resources.generic_string();
+#else
+    uri = "file://" + resources.generic_string();
+#endif
+  }
+
+  fmi2Component instantiate() const {
+    fmi2Component component = fmi2Instantiate(
+      "bench", fmi2CoSimulation, guid.c_str(), uri.c_str(), &callbacks, fmi2False, fmi2False);
+    if (!component) { throw std::runtime_error("Could not instantiate dds-fmu"); }
+    return component;
+  }
+
+  /// Instantiates and initializes the FMU
+  fmi2Component initialize() const {
+    fmi2Component component = instantiate();
+    fmi2SetupExperiment(component, fmi2False, 0.0, 0.0, fmi2False, 0.0);
+    fmi2EnterInitializationMode(component);
+    fmi2ExitInitializationMode(component);
+    return component;
+  }
+
+  std::size_t leaves;
+  std::filesystem::path resources;
+  std::string guid;
+  std::string uri;
+};
+
+void BM_FmuInstanceDoStep(benchmark::State& state) {
+  FmuFixture fixture(state);
+  fmi2Component component = fixture.initialize();
+
+  // Outputs are enumerated before inputs
+  std::vector<fmi2ValueReference> outputs(fixture.leaves), inputs(fixture.leaves);
+  for (std::size_t i = 0; i < fixture.leaves; ++i) {
+    outputs[i] = static_cast<fmi2ValueReference>(i);
+    inputs[i] = static_cast<fmi2ValueReference>(fixture.leaves + i);
+  }
+  std::vector<fmi2Real> values(fixture.leaves, 1.0);
+
+  fmi2Real time = 0.0;
+  const fmi2Real step = 0.01;
+  for (auto _ : state) {
+    fmi2SetReal(component, inputs.data(), inputs.size(), values.data());
+    fmi2DoStep(component, time, step, fmi2True);
+    fmi2GetReal(component, outputs.data(), outputs.size(), values.data());
+    time += step;
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+
+  fmi2Terminate(component);
+  fmi2FreeInstance(component);
+}
+
+void BM_FmuInstanceInstantiate(benchmark::State& state) {
+  FmuFixture fixture(state);
+  for (auto _ : state) {
+    fmi2Component component = fixture.initialize();
+    fmi2FreeInstance(component);
+  }
+}
+
+void BM_FmuInstanceReset(benchmark::State& state, const std::string& attributes) {
+  FmuFixture fixture(state, attributes);
+  fmi2Component component = fixture.initialize();
+  for (auto _ : state) {
+    fmi2Reset(component);
+
+    state.PauseTiming();
+    fmi2SetupExperiment(component, fmi2False, 0.0, 0.0, fmi2False, 0.0);
+    fmi2EnterInitializationMode(component);
+    fmi2ExitInitializationMode(component);
+    state.ResumeTiming();
+  }
+  fmi2FreeInstance(component);
+}
+
+}
+
+BENCHMARK(BM_FmuInstanceDoStep)
+  ->RangeMultiplier(10)
+  ->Range(ddsfmu::bench::MinLeaves, ddsfmu::bench::MaxLeaves)
+  ->UseRealTime();
+BENCHMARK(BM_FmuInstanceInstantiate)
+  ->RangeMultiplier(10)
+  ->Range(ddsfmu::bench::MinLeaves, ddsfmu::bench::MaxLeaves)
+  ->Unit(benchmark::kMillisecond)
+  ->UseRealTime();
+BENCHMARK_CAPTURE(BM_FmuInstanceReset, Soft, std::string("reset=\"soft\""))
+  ->RangeMultiplier(10)
+  ->Range(ddsfmu::bench::MinLeaves, ddsfmu::bench::MaxLeaves)
+  ->Unit(benchmark::kMillisecond)
+  ->UseRealTime();
+BENCHMARK_CAPTURE(BM_FmuInstanceReset, Hard, std::string("reset=\"hard\""))
+  ->RangeMultiplier(10)
+  ->Range(ddsfmu::bench::MinLeaves, ddsfmu::bench::MaxLeaves)
+  ->Unit(benchmark::kMillisecond)
+  ->UseRealTime();
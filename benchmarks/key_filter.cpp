@@ -0,0 +1,89 @@
+/*
+  Copyright 2023, SINTEF Ocean
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include <benchmark/benchmark.h>
+#include <fastdds/dds/core/LoanableSequence.hpp>
+#include <fastdds/rtps/common/SerializedPayload.h>
+#include <fastrtps/types/DynamicDataFactory.h>
+#include <fastrtps/types/DynamicPubSubType.h>
+#include <fastrtps/types/DynamicTypeBuilder.h>
+#include <xtypes/idl/idl.hpp>
+
+#include "Converter.hpp"
+#include "CustomKeyFilter.hpp"
+#include "fixtures.hpp"
+
+namespace {
+
+using ddsfmu::bench::Shape;
+
+/**
+   Evaluates a serialized sample of a keyed flat `Bench`. The argument selects whether the
+   key of the sample matches the filter, such that both accepted and rejected samples are
+   measured.
+*/
+void BM_CustomKeyFilterEvaluate(benchmark::State& state, bool matching) {
+  namespace etypes = eprosima::fastrtps::types;
+  const auto leaves = static_cast<std::size_t>(state.range(0));
+
+  ddsfmu::Converter::clear_data_structures();
+  auto context =
+    eprosima::xtypes::idl::parse(ddsfmu::bench::bench_idl(Shape::Flat, leaves, "double", true));
+  if (!context.success) { throw std::runtime_error("Could not parse benchmark IDL"); }
+  const auto& type = context.module().structure("Bench");
+  ddsfmu::Converter::register_xtype("Bench", type);
+
+  etypes::DynamicType_ptr dyn_type = ddsfmu::Converter::create_builder(type)->build();
+  etypes::DynamicPubSubType pubsub_type(dyn_type);
+  etypes::DynamicData_ptr sample(etypes::DynamicDataFactory::get_instance()->create_data(dyn_type));
+
+  eprosima::xtypes::DynamicData xtypes_sample(type);
+  xtypes_sample["id"] = std::int32_t(matching ? 7 : 8);
+  ddsfmu::Converter::xtypes_to_fastdds(xtypes_sample, sample.get());
+
+  eprosima::fastrtps::rtps::SerializedPayload_t payload(
+    pubsub_type.getSerializedSizeProvider(sample.get())());
+  pubsub_type.serialize(sample.get(), &payload);
+
+  // Reader GUID and key value as the filter parameters from DynamicPubSub
+  eprosima::fastrtps::rtps::GUID_t reader_guid;
+  reader_guid.guidPrefix.value[0] = 1;
+  reader_guid.entityId.value[3] = 7;
+  std::ostringstream guid;
+  guid << reader_guid;
+  const std::string guid_str = guid.str();
+  const std::string key_str = "7";
+
+  eprosima::fastdds::dds::LoanableSequence<const char*> parameters(2);
+  parameters.length(2);
+  parameters[0] = guid_str.c_str();
+  parameters[1] = key_str.c_str();
+
+  ddsfmu::detail::CustomKeyFilter filter(&pubsub_type, "Bench", parameters);
+  eprosima::fastdds::dds::IContentFilter::FilterSampleInfo info;
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(filter.evaluate(payload, info, reader_guid));
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * payload.length);
+
+  ddsfmu::Converter::clear_data_structures();
+}
+
+}
+
+BENCHMARK_CAPTURE(BM_CustomKeyFilterEvaluate, Accepted, true)
+  ->RangeMultiplier(10)
+  ->Range(ddsfmu::bench::MinLeaves, ddsfmu::bench::MaxLeaves);
+BENCHMARK_CAPTURE(BM_CustomKeyFilterEvaluate, Rejected, false)
+  ->RangeMultiplier(10)
+  ->Range(ddsfmu::bench::MinLeaves, ddsfmu::bench::MaxLeaves);
@@ -0,0 +1,242 @@
+/*
+  Copyright 2023, SINTEF Ocean
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <benchmark/benchmark.h>
+#include <fastrtps/xmlparser/XMLProfileManager.h>
+
+#include "DataMapper.hpp"
+#include "DynamicPubSub.hpp"
+#include "fixtures.hpp"
+
+namespace {
+
+using ddsfmu::bench::Shape;
+
+/// DataMapper and DynamicPubSub with `Bench` as both FMU input and output on one topic
+struct LoopbackFixture {
+  explicit LoopbackFixture(const benchmark::State& state) {
+    const auto leaves = static_cast<std::size_t>(state.range(0));
+    auto resources = ddsfmu::bench::bench_resources(
+      "pubsub_" + std::to_string(leaves), ddsfmu::bench::bench_idl(Shape::Flat, leaves));
+    mapper.reset(resources);
+    pubsub.reset(resources, &mapper);
+    pubsub.init_key_filters();
+
+    // Let the writer and reader match before measuring
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  }
+
+  ddsfmu::DataMapper mapper;
+  ddsfmu::DynamicPubSub pubsub;
+};
+
+/// Number of topics of the many topics benchmark
+constexpr std::size_t ManyTopics = 500;
+
+/// Publisher of many small topics and a subscriber of all of them in a second participant
+struct ManyTopicsFixture {
+  explicit ManyTopicsFixture(const benchmark::State& state) {
+    const bool async = state.range(0) != 0;
+    auto inputs = ddsfmu::bench::topics_resources(
+      std::string("topics_in_") + (async ? "async" : "sync"), ManyTopics, true,
+      async ? R"(publish_mode="asynchronous" flow_controller="ddsfmu_batch")" : "");
+    auto outputs = ddsfmu::bench::topics_resources("topics_out", ManyTopics, false);
+    publisher_mapper.reset(inputs);
+    publisher.reset(inputs, &publisher_mapper);
+    subscriber_mapper.reset(outputs);
+    subscriber.reset(outputs, &subscriber_mapper);
+    subscriber.init_key_filters();
+
+    // Let all writers and readers match before measuring
+    std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+  }
+
+  ddsfmu::DataMapper publisher_mapper, subscriber_mapper;
+  ddsfmu::DynamicPubSub publisher, subscriber;
+};
+
+/**
+   FMU input and output of the shipped `Roundtrip` example in two participants, over UDPv4 or
+   shared memory as selected by the attribute `transport`. Intra-process delivery is disabled
+   while the fixture lives, such that samples go through the transport.
+*/
+struct RoundtripFixture {
+  explicit RoundtripFixture(const benchmark::State& state) {
+    namespace xml = eprosima::fastrtps::xmlparser;
+    const bool shm = state.range(0) != 0;
+    m_settings = xml::XMLProfileManager::library_settings();
+    auto settings = m_settings;
+    settings.intraprocess_delivery = eprosima::fastrtps::INTRAPROCESS_OFF;
+    xml::XMLProfileManager::library_settings(settings);
+
+    auto resources = ddsfmu::bench::roundtrip_resources(
+      std::string("roundtrip_") + (shm ? "local" : "udpv4"),
+      std::string("transport=\"") + (shm ? "local" : "udpv4") + "\" localhost_only=\"true\"");
+    mapper.reset(resources);
+    pubsub.reset(resources, &mapper);
+    pubsub.init_key_filters();
+
+    // Let the writer and reader match before measuring
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  }
+
+  ~RoundtripFixture() {
+    eprosima::fastrtps::xmlparser::XMLProfileManager::library_settings(m_settings);
+  }
+
+  ddsfmu::DataMapper mapper;
+  ddsfmu::DynamicPubSub pubsub;
+
+private:
+  eprosima::fastrtps::LibrarySettingsAttributes m_settings;
+};
+
+/// Longest wait for a sample in the roundtrip benchmark
+constexpr std::chrono::seconds RoundtripTimeout(1);
+
+/// UDP datagrams sent by the host so far, from /proc/net/snmp, or zero if not available
+std::uint64_t udp_datagrams_sent() {
+  std::ifstream snmp("/proc/net/snmp");
+  std::string header, values;
+  // Lines come in pairs of names and values for each protocol
+  while (std::getline(snmp, header) && std::getline(snmp, values)) {
+    if (header.rfind("Udp:", 0) != 0) { continue; }
+    std::istringstream names(header), numbers(values);
+    std::string name, number;
+    while (names >> name && numbers >> number) {
+      if (name == "OutDatagrams") { return std::stoull(number); }
+    }
+  }
+  return 0;
+}
+
+/**
+   Latency of one sample of `Roundtrip` from write() until take() has received it, over
+   UDPv4 on the loopback interface or over shared memory. The example DDS profile must be the
+   first loaded, e.g. with --benchmark_filter=Roundtrip, since fast-dds keeps the first loaded
+   profile, but the transports are set by the mapping in either case. The benchmark fails if
+   a sample is not received within RoundtripTimeout, e.g. if it was lost with best effort QoS.
+*/
+void BM_DynamicPubSubRoundtripLatency(benchmark::State& state) {
+  RoundtripFixture fixture(state);
+  auto& sent = fixture.mapper.data_ref("Roundtrip", ddsfmu::DataMapper::Direction::Write);
+  auto& received = fixture.mapper.data_ref("Roundtrip", ddsfmu::DataMapper::Direction::Read);
+  double value = 0.0;
+  for (auto _ : state) {
+    value += 1.0;
+    sent["value"] = value;
+    fixture.pubsub.write();
+    const auto deadline = std::chrono::steady_clock::now() + RoundtripTimeout;
+    do {
+      fixture.pubsub.take();
+    } while (received["value"].value<double>() != value
+             && std::chrono::steady_clock::now() < deadline);
+
+    if (received["value"].value<double>() != value) {
+      state.SkipWithError("Sample not received before timeout");
+      break;
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_DynamicPubSubWrite(benchmark::State& state) {
+  LoopbackFixture fixture(state);
+  for (auto _ : state) {
+    fixture.pubsub.write();
+
+    state.PauseTiming();
+    fixture.pubsub.take(); // Keep reader history from growing
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_DynamicPubSubTake(benchmark::State& state) {
+  LoopbackFixture fixture(state);
+  for (auto _ : state) {
+    state.PauseTiming();
+    fixture.pubsub.write();
+    state.ResumeTiming();
+
+    fixture.pubsub.take();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_DynamicPubSubWriteTake(benchmark::State& state) {
+  LoopbackFixture fixture(state);
+  for (auto _ : state) {
+    fixture.pubsub.write();
+    fixture.pubsub.take();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/**
+   Publishes 500 small topics per step, synchronously or through the flow controller, and
+   counts the UDP datagrams sent. Each step includes a pause for the flow controller to send,
+   and CPU time is that of the whole process, such that the sending thread is included. The
+   datagram count is host-wide and includes discovery traffic. Run this benchmark alone, e.g.
+   with --benchmark_filter=ManyTopics, since fast-dds keeps the first loaded DDS profile.
+   Otherwise the flow controller is missing, and the asynchronous case fails.
+*/
+void BM_DynamicPubSubManyTopics(benchmark::State& state) {
+  std::unique_ptr<ManyTopicsFixture> fixture;
+  try {
+    fixture = std::make_unique<ManyTopicsFixture>(state);
+  } catch (const std::runtime_error& e) {
+    state.SkipWithError(e.what());
+    return;
+  }
+
+  std::uint64_t datagrams = 0;
+  for (auto _ : state) {
+    const auto before = udp_datagrams_sent();
+    fixture->publisher.write();
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    datagrams += udp_datagrams_sent() - before;
+
+    state.PauseTiming();
+    fixture->subscriber.take(); // Keep reader histories from growing
+    state.ResumeTiming();
+  }
+  state.counters["datagrams"] =
+    benchmark::Counter(static_cast<double>(datagrams), benchmark::Counter::kAvgIterations);
+  state.SetItemsProcessed(state.iterations() * ManyTopics);
+}
+
+}
+
+BENCHMARK(BM_DynamicPubSubManyTopics)
+  ->ArgName("async")
+  ->Arg(0)
+  ->Arg(1)
+  ->MeasureProcessCPUTime()
+  ->UseRealTime();
+BENCHMARK(BM_DynamicPubSubRoundtripLatency)->ArgName("shm")->Arg(0)->Arg(1)->UseRealTime();
+BENCHMARK(BM_DynamicPubSubWrite)
+  ->RangeMultiplier(10)
+  ->Range(ddsfmu::bench::MinLeaves, ddsfmu::bench::MaxLeaves)
+  ->UseRealTime();
+BENCHMARK(BM_DynamicPubSubTake)
+  ->RangeMultiplier(10)
+  ->Range(ddsfmu::bench::MinLeaves, ddsfmu::bench::MaxLeaves)
+  ->UseRealTime();
+BENCHMARK(BM_DynamicPubSubWriteTake)
+  ->RangeMultiplier(10)
+  ->Range(ddsfmu::bench::MinLeaves, ddsfmu::bench::MaxLeaves)
+  ->UseRealTime();
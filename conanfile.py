@@ -22,12 +22,16 @@ class DdsFmuConan(ConanFile):
     options = {
         "fPIC": [True, False],
         "with_tools": [True, False],
-        "with_doc": [True, False]
+        "with_doc": [True, False],
+        "with_benchmarks": [True, False],
+        "with_tracing": [True, False]
     }
     default_options = {
         "fPIC": True,
         "with_tools": True,
-        "with_doc": False
+        "with_doc": False,
+        "with_benchmarks": False,
+        "with_tracing": True
     }
 
     @property
@@ -89,6 +93,8 @@ class DdsFmuConan(ConanFile):
         if self._with_tests:
             self.tool_requires("fmu-compliance-checker/2.0.4@sintef/stable")
             self.test_requires("gtest/1.13.0")
+        if self.options.with_benchmarks:
+            self.test_requires("benchmark/1.8.3")
         if self.options.with_doc:
             self.tool_requires("doxygen/1.9.4")
             if self.settings.os == "Windows":
@@ -98,6 +104,8 @@ class DdsFmuConan(ConanFile):
         tc = CMakeToolchain(self)
         tc.variables["DDSFMU_WITH_TOOLS"] = self.options.with_tools
         tc.variables["DDSFMU_WITH_DOC"] = self.options.with_doc
+        tc.variables["DDSFMU_WITH_BENCHMARKS"] = self.options.with_benchmarks
+        tc.variables["DDSFMU_WITH_TRACING"] = self.options.with_tracing
         tc.generate()
 
         deps = CMakeDeps(self)
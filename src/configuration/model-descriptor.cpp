@@ -86,7 +86,9 @@ void write_model_description(
 
 void name_generator(std::string& name, const eprosima::xtypes::DynamicData::ReadableNode& rnode) {
   std::string member_name;
-  bool is_array = rnode.type().kind() == eprosima::xtypes::TypeKind::ARRAY_TYPE;
+  // Elements of sequences are indexed like elements of arrays
+  bool is_array = rnode.type().kind() == eprosima::xtypes::TypeKind::ARRAY_TYPE
+                  || rnode.type().kind() == eprosima::xtypes::TypeKind::SEQUENCE_TYPE;
 
   std::string from_name = (rnode.from_member() ? rnode.from_member()->name() : std::string());
   /*std::cout << "[" << rnode.type().name() << "]: ";
@@ -100,9 +102,11 @@ void name_generator(std::string& name, const eprosima::xtypes::DynamicData::Read
   // Determine name to give:
   if (rnode.from_member()) { member_name = rnode.from_member()->name(); }
 
-  // Parent is array
+  // Parent is array or sequence
   if (
-    rnode.has_parent() && rnode.parent().type().kind() == eprosima::xtypes::TypeKind::ARRAY_TYPE) {
+    rnode.has_parent()
+    && (rnode.parent().type().kind() == eprosima::xtypes::TypeKind::ARRAY_TYPE
+        || rnode.parent().type().kind() == eprosima::xtypes::TypeKind::SEQUENCE_TYPE)) {
     member_name += "[" + std::to_string(rnode.from_index()) + "]";
   }
 
@@ -26,6 +26,7 @@ namespace config {
 
    Internally, this function recursively calls itself to find all ancestors of a node.
    The convention used is '.' for members and '[i]', with i being zero-indexed array notation.
+   Elements of sequences are named like elements of arrays.
 
 */
 void name_generator(std::string& name, const eprosima::xtypes::DynamicData::ReadableNode& rnode);
@@ -0,0 +1,242 @@
+/*
+  Copyright 2023, SINTEF Ocean
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "qos-profiles.hpp"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+#include <rapidxml/rapidxml.hpp>
+
+#include "model-descriptor.hpp"
+
+namespace ddsfmu {
+namespace config {
+
+namespace {
+
+  namespace ex = eprosima::xtypes;
+
+  inline std::size_t align(std::size_t position, std::size_t alignment) {
+    return (position + alignment - 1) / alignment * alignment;
+  }
+
+  /// CDR size of primitives and enumerations, or zero for other types
+  std::size_t primitive_size(const ex::DynamicType& type) {
+    switch (type.kind()) {
+    case ex::TypeKind::BOOLEAN_TYPE:
+    case ex::TypeKind::CHAR_8_TYPE:
+    case ex::TypeKind::INT_8_TYPE:
+    case ex::TypeKind::UINT_8_TYPE: return 1;
+    case ex::TypeKind::INT_16_TYPE:
+    case ex::TypeKind::UINT_16_TYPE:
+    case ex::TypeKind::CHAR_16_TYPE: return 2;
+    case ex::TypeKind::INT_32_TYPE:
+    case ex::TypeKind::UINT_32_TYPE:
+    case ex::TypeKind::FLOAT_32_TYPE:
+    case ex::TypeKind::WIDE_CHAR_TYPE:
+    case ex::TypeKind::ENUMERATION_TYPE: return 4;
+    case ex::TypeKind::INT_64_TYPE:
+    case ex::TypeKind::UINT_64_TYPE:
+    case ex::TypeKind::FLOAT_64_TYPE: return 8;
+    case ex::TypeKind::FLOAT_128_TYPE: return 16;
+    default: return 0;
+    }
+  }
+
+  /// Position after serializing count elements at position, or std::nullopt if unbounded
+  std::optional<std::size_t>
+    serialize(const ex::DynamicType& type, std::size_t position, std::size_t count = 1) {
+    if (count == 0) { return position; }
+
+    if (const std::size_t size = primitive_size(type)) {
+      // Contiguous primitives are only aligned before the first one
+      return align(position, std::min<std::size_t>(size, 8)) + size * count;
+    }
+
+    std::optional<std::size_t> end = position;
+    for (std::size_t i = 0; i < count && end; ++i) {
+      switch (type.kind()) {
+      case ex::TypeKind::ALIAS_TYPE:
+        end = serialize(static_cast<const ex::AliasType&>(type).rget(), *end);
+        break;
+      case ex::TypeKind::STRING_TYPE: {
+        const auto bounds = static_cast<const ex::StringType&>(type).bounds();
+        if (bounds == 0) { return std::nullopt; }
+        end = align(*end, 4) + 4 + bounds + 1; // Length, characters and terminator
+        break;
+      }
+      case ex::TypeKind::WSTRING_TYPE: {
+        const auto bounds = static_cast<const ex::WStringType&>(type).bounds();
+        if (bounds == 0) { return std::nullopt; }
+        end = align(*end, 4) + 4 + 4 * bounds;
+        break;
+      }
+      case ex::TypeKind::ARRAY_TYPE: {
+        const auto& array = static_cast<const ex::ArrayType&>(type);
+        end = serialize(array.content_type(), *end, array.dimension());
+        break;
+      }
+      case ex::TypeKind::SEQUENCE_TYPE: {
+        const auto& sequence = static_cast<const ex::SequenceType&>(type);
+        if (sequence.bounds() == 0) { return std::nullopt; }
+        end = serialize(sequence.content_type(), align(*end, 4) + 4, sequence.bounds());
+        break;
+      }
+      case ex::TypeKind::MAP_TYPE: {
+        const auto& map = static_cast<const ex::MapType&>(type);
+        if (map.bounds() == 0) { return std::nullopt; }
+        const auto& pair = static_cast<const ex::PairType&>(map.content_type());
+        end = align(*end, 4) + 4;
+        for (std::size_t entry = 0; entry < map.bounds() && end; ++entry) {
+          end = serialize(pair.first(), *end);
+          if (end) { end = serialize(pair.second(), *end); }
+        }
+        break;
+      }
+      case ex::TypeKind::STRUCTURE_TYPE: {
+        const auto& structure = static_cast<const ex::StructType&>(type);
+        for (std::size_t member = 0; member < structure.members().size() && end; ++member) {
+          end = serialize(structure.member(member).type(), *end);
+        }
+        break;
+      }
+      case ex::TypeKind::UNION_TYPE: {
+        const auto& union_type = static_cast<const ex::UnionType&>(type);
+        const auto cases = serialize(union_type.discriminator(), *end);
+        if (!cases) { return std::nullopt; }
+        std::size_t largest = *cases;
+        for (const std::string& name : union_type.get_case_members()) {
+          const auto case_end = serialize(union_type.member(name).type(), *cases);
+          if (!case_end) { return std::nullopt; }
+          largest = std::max(largest, *case_end);
+        }
+        end = largest;
+        break;
+      }
+      default: return std::nullopt;
+      }
+    }
+    return end;
+  }
+
+  /// QoS of a topic kind
+  struct KindQos {
+    std::size_t depth;
+    const char* reliability;
+    const char* durability;
+  };
+
+  KindQos kind_qos(TopicKind kind) {
+    switch (kind) {
+    case TopicKind::State: return {1, "BEST_EFFORT", "VOLATILE"};
+    case TopicKind::Event: return {32, "RELIABLE", "VOLATILE"};
+    case TopicKind::Command: return {1, "RELIABLE", "TRANSIENT_LOCAL"};
+    }
+    throw std::logic_error("Unknown topic kind");
+  }
+
+  const char* kind_name(TopicKind kind) {
+    switch (kind) {
+    case TopicKind::State: return "state";
+    case TopicKind::Event: return "event";
+    case TopicKind::Command: return "command";
+    }
+    throw std::logic_error("Unknown topic kind");
+  }
+
+}
+
+std::optional<std::size_t> max_serialized_size(const eprosima::xtypes::DynamicType& type) {
+  constexpr std::size_t EncapsulationHeader = 4;
+  auto end = serialize(type, 0);
+  if (!end) { return std::nullopt; }
+  return EncapsulationHeader + *end;
+}
+
+TopicKind parse_topic_kind(const std::string& value) {
+  if (value == "state") { return TopicKind::State; }
+  if (value == "event") { return TopicKind::Event; }
+  if (value == "command") { return TopicKind::Command; }
+  throw std::runtime_error("Attribute 'kind' must be 'state', 'event' or 'command'");
+}
+
+std::string generate_qos_profiles(
+  const std::vector<TopicProfile>& profiles, const std::set<std::string>& existing) {
+  std::ostringstream xml;
+  xml << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+      << "<!-- Generated by the dds-fmu repacker from hints in ddsfmu_mapping.xml -->\n"
+      << "<dds xmlns=\"http://www.eprosima.com/XMLSchemas/fastRTPS_Profiles\">\n"
+      << "<profiles>\n";
+
+  for (const auto& profile : profiles) {
+    const char* entity = profile.writer ? "data_writer" : "data_reader";
+    if (existing.count(std::string(entity) + ":" + profile.topic)) { continue; }
+
+    const KindQos qos = kind_qos(profile.kind);
+    xml << "\n  <!-- kind=\"" << kind_name(profile.kind) << "\", max serialized size: ";
+    if (profile.max_size) {
+      xml << *profile.max_size << " bytes -->\n";
+    } else {
+      xml << "unbounded -->\n";
+    }
+    xml << "  <" << entity << " profile_name=\"" << profile.topic << "\">\n"
+        << "    <topic>\n"
+        << "      <historyQos>\n"
+        << "        <kind>KEEP_LAST</kind>\n"
+        << "        <depth>" << qos.depth << "</depth>\n"
+        << "      </historyQos>\n"
+        << "      <resourceLimitsQos>\n"
+        << "        <max_samples_per_instance>" << qos.depth << "</max_samples_per_instance>\n"
+        << "        <allocated_samples>" << qos.depth << "</allocated_samples>\n"
+        << "      </resourceLimitsQos>\n"
+        << "    </topic>\n"
+        << "    <qos>\n"
+        << "      <reliability>\n"
+        << "        <kind>" << qos.reliability << "</kind>\n"
+        << "      </reliability>\n"
+        << "      <durability>\n"
+        << "        <kind>" << qos.durability << "</kind>\n"
+        << "      </durability>\n"
+        << "    </qos>\n"
+        << "    <historyMemoryPolicy>"
+        << (profile.max_size ? "PREALLOCATED" : "PREALLOCATED_WITH_REALLOC")
+        << "</historyMemoryPolicy>\n"
+        << "  </" << entity << ">\n";
+  }
+
+  xml << "</profiles>\n"
+      << "</dds>\n";
+  return xml.str();
+}
+
+std::set<std::string> qos_profile_names(const std::filesystem::path& dds_profile) {
+  std::set<std::string> names;
+  if (!std::filesystem::exists(dds_profile)) { return names; }
+
+  rapidxml::xml_document<> doc;
+  std::vector<char> buffer;
+  load_template_xml(doc, dds_profile, buffer);
+
+  // Profiles are either in <dds><profiles> or in a root <profiles>
+  auto profiles = doc.first_node("profiles");
+  if (auto dds = doc.first_node("dds")) { profiles = dds->first_node("profiles"); }
+  if (!profiles) { return names; }
+
+  for (const char* entity : {"data_writer", "data_reader"}) {
+    for (auto* node = profiles->first_node(entity); node; node = node->next_sibling(entity)) {
+      if (auto name = node->first_attribute("profile_name")) {
+        names.insert(std::string(entity) + ":" + name->value());
+      }
+    }
+  }
+  return names;
+}
+
+}
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+/*
+  Copyright 2023, SINTEF Ocean
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <xtypes/xtypes.hpp>
+
+namespace ddsfmu {
+namespace config {
+
+/**
+   @brief Maximum serialized size of a type in CDR, including the encapsulation header
+
+   Alignment padding is accounted for as in fast-dds, which aligns primitives to their size,
+   at most 8 bytes, relative to the end of the encapsulation header. Unions are sized by
+   their largest case.
+
+   @param [in] type Type of a topic
+   @return Size in bytes, or std::nullopt if the type has unbounded strings, sequences or
+   maps, or members of unsupported kinds
+*/
+std::optional<std::size_t> max_serialized_size(const eprosima::xtypes::DynamicType& type);
+
+/// Kind of data of a topic, given by the attribute `kind` in the ddsfmu mapping
+enum class TopicKind {
+  State,   ///< Periodic state, where only the latest sample matters
+  Event,   ///< Sporadic samples, each of which must be delivered
+  Command, ///< Latest sample must be delivered, also to late joiners
+};
+
+/**
+   @brief Parses the value of the attribute `kind`
+
+   @param [in] value One of `state`, `event` or `command`
+   @return Topic kind
+*/
+TopicKind parse_topic_kind(const std::string& value);
+
+/// DataWriter or DataReader profile to generate for a topic
+struct TopicProfile {
+  std::string topic;                   ///< Topic name, which is the profile name
+  TopicKind kind;                      ///< QoS hint of the topic
+  bool writer;                         ///< DataWriter if true, otherwise DataReader
+  std::optional<std::size_t> max_size; ///< See max_serialized_size()
+};
+
+/**
+   @brief Generates fast-dds XML profiles for topics with a `kind` hint
+
+   Each topic gets a `<data_writer>` or `<data_reader>` profile named after the topic, as
+   looked up by DynamicPubSub. History depth, reliability and durability follow the kind:
+
+   - state: KEEP_LAST 1, BEST_EFFORT, VOLATILE
+   - event: KEEP_LAST 32, RELIABLE, VOLATILE
+   - command: KEEP_LAST 1, RELIABLE, TRANSIENT_LOCAL
+
+   Resource limits are sized to the history depth. Types with a maximum serialized size get
+   the PREALLOCATED memory policy, such that payloads never reallocate, while unbounded types
+   get PREALLOCATED_WITH_REALLOC.
+
+   @param [in] profiles Profiles to generate
+   @param [in] existing Names of profiles of the same entity kind to skip, as defined by the
+   user in dds_profile.xml. Entries are prefixed by `data_writer:` or `data_reader:`.
+   @return XML document as string, which fast-dds loads in addition to dds_profile.xml
+*/
+std::string generate_qos_profiles(
+  const std::vector<TopicProfile>& profiles, const std::set<std::string>& existing = {});
+
+/**
+   @brief Lists the names of DataWriter and DataReader profiles in a fast-dds XML file
+
+   @param [in] dds_profile Path to fast-dds XML profiles
+   @return Profile names prefixed by `data_writer:` or `data_reader:`
+*/
+std::set<std::string> qos_profile_names(const std::filesystem::path& dds_profile);
+
+/// File name of generated profiles, next to dds_profile.xml
+constexpr const char* GeneratedProfiles = "ddsfmu_profiles.xml";
+
+}
+}
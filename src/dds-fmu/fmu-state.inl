@@ -0,0 +1,118 @@
+/*
+  Copyright 2023, SINTEF Ocean
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+/*
+  FMU state functions for dds-fmu.
+
+  cppfmu reports the FMU state functions as unsupported. At configure time, the build
+  renames these in a copy of cppfmu's fmi_functions.cpp and includes this file at the end
+  of it, such that the functions below have access to cppfmu's Component.
+
+  An FMU state is a std::vector<std::uint8_t> holding the bytes of
+  ddsfmu::FmuInstance::GetFMUstate(). Serialization therefore copies the bytes as is.
+*/
+
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <vector>
+
+#include "FmuInstance.hpp"
+
+namespace {
+
+typedef std::vector<std::uint8_t> DdsFmuState;
+
+ddsfmu::FmuInstance& dds_fmu_instance(fmi2Component c) {
+  auto* slave = reinterpret_cast<Component*>(c)->slave.get();
+  auto* instance = dynamic_cast<ddsfmu::FmuInstance*>(slave);
+  if (!instance) { throw std::logic_error("FMU state requested for unknown slave instance"); }
+  return *instance;
+}
+
+fmi2Status dds_fmu_state_error(fmi2Component c, const std::exception& e) {
+  reinterpret_cast<Component*>(c)->logger.Log(fmi2Error, "", "%s", e.what());
+  return fmi2Error;
+}
+
+}
+
+extern "C" {
+
+fmi2Status fmi2GetFMUstate(fmi2Component c, fmi2FMUstate* state) {
+  try {
+    // Reuse an existing state, such that repeated snapshots do not allocate
+    std::unique_ptr<DdsFmuState> created;
+    auto* snapshot = static_cast<DdsFmuState*>(*state);
+    if (!snapshot) {
+      created = std::make_unique<DdsFmuState>();
+      snapshot = created.get();
+    }
+    dds_fmu_instance(c).GetFMUstate(*snapshot);
+    created.release();
+    *state = snapshot;
+    return fmi2OK;
+  } catch (const std::exception& e) { return dds_fmu_state_error(c, e); }
+}
+
+fmi2Status fmi2SetFMUstate(fmi2Component c, fmi2FMUstate state) {
+  try {
+    if (!state) { throw std::invalid_argument("fmi2SetFMUstate got null state"); }
+    const auto* snapshot = static_cast<const DdsFmuState*>(state);
+    dds_fmu_instance(c).SetFMUstate(snapshot->data(), snapshot->size());
+    return fmi2OK;
+  } catch (const std::exception& e) { return dds_fmu_state_error(c, e); }
+}
+
+fmi2Status fmi2FreeFMUstate(fmi2Component, fmi2FMUstate* state) {
+  if (state) {
+    delete static_cast<DdsFmuState*>(*state);
+    *state = nullptr;
+  }
+  return fmi2OK;
+}
+
+fmi2Status fmi2SerializedFMUstateSize(fmi2Component c, fmi2FMUstate state, size_t* size) {
+  try {
+    if (!state) { throw std::invalid_argument("fmi2SerializedFMUstateSize got null state"); }
+    *size = static_cast<const DdsFmuState*>(state)->size();
+    return fmi2OK;
+  } catch (const std::exception& e) { return dds_fmu_state_error(c, e); }
+}
+
+fmi2Status fmi2SerializeFMUstate(
+  fmi2Component c, fmi2FMUstate state, fmi2Byte serializedState[], size_t size) {
+  try {
+    if (!state) { throw std::invalid_argument("fmi2SerializeFMUstate got null state"); }
+    const auto* snapshot = static_cast<const DdsFmuState*>(state);
+    if (size < snapshot->size()) {
+      throw std::invalid_argument("Buffer for serialized FMU state is too small");
+    }
+    std::memcpy(serializedState, snapshot->data(), snapshot->size());
+    return fmi2OK;
+  } catch (const std::exception& e) { return dds_fmu_state_error(c, e); }
+}
+
+fmi2Status fmi2DeSerializeFMUstate(
+  fmi2Component c, const fmi2Byte serializedState[], size_t size, fmi2FMUstate* state) {
+  try {
+    std::unique_ptr<DdsFmuState> created;
+    auto* snapshot = static_cast<DdsFmuState*>(*state);
+    if (!snapshot) {
+      created = std::make_unique<DdsFmuState>();
+      snapshot = created.get();
+    }
+    const auto* bytes = reinterpret_cast<const std::uint8_t*>(serializedState);
+    snapshot->assign(bytes, bytes + size);
+    created.release();
+    *state = snapshot;
+    return fmi2OK;
+  } catch (const std::exception& e) { return dds_fmu_state_error(c, e); }
+}
+
+}
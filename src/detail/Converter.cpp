@@ -1,7 +1,13 @@
 /*
  * Copyright 2019 - present Proyectos y Sistemas de Mantenimiento SL (eProsima).
  *
- * There are no functional changes done in dds-fmu, only changing namespace and formatting.
+ * This implementation is based on https://github.com/eProsima/FastDDS-SH/blob/main/src/Conversion.cpp
+ * Modifications in dds-fmu, besides namespace and formatting:
+ * - Conversions take xtypes data references, such that data stores of an arena are converted.
+ * - Bounded sequences of data stores are kept at their bound, with lengths passed per call.
+ * - Arrays of primitives are copied in one pass.
+ * - Elements of sequences and maps of primitives are reused between samples.
+ * - Unused string streams are removed.
  *
  * Licensed under the Apache License, Version 2.0 (the "License");
  * you may not use this file except in compliance with the License.
@@ -19,6 +25,8 @@
 
 #include "Converter.hpp"
 
+#include <algorithm>
+#include <cstring>
 #include <sstream>
 #include <stack>
 
@@ -48,6 +56,35 @@ std::map<std::string, ::xtypes::DynamicType::Ptr> Converter::m_types;
 std::map<std::string, DynamicPubSubType*> Converter::m_registered_types;
 std::map<std::string, DynamicTypeBuilder_ptr> Converter::m_builders;
 
+namespace {
+
+  /// Assigns an element of a bounded sequence in place, or appends it otherwise
+  template <typename T>
+  void store_element(
+    ::xtypes::WritableDynamicDataRef& to, uint32_t idx, bool in_place, const T& value) {
+    if (in_place) {
+      to[idx].value<T>(value);
+    } else {
+      to.push(value);
+    }
+  }
+
+  /// Calls set(value, id) for count contiguous values of type T, with flat ids from first
+  template <typename T, typename Set>
+  void read_values(const std::uint8_t* data, std::size_t count, MemberId first, Set set) {
+    const T* values = reinterpret_cast<const T*>(data);
+    for (std::size_t i = 0; i < count; ++i) { set(values[i], first + static_cast<MemberId>(i)); }
+  }
+
+  /// Calls get(value, id) for count contiguous values of type T, with flat ids from first
+  template <typename T, typename Get>
+  void write_values(std::uint8_t* data, std::size_t count, MemberId first, Get get) {
+    T* values = reinterpret_cast<T*>(data);
+    for (std::size_t i = 0; i < count; ++i) { get(values[i], first + static_cast<MemberId>(i)); }
+  }
+
+}
+
 // Static member initialization
 //utils::Logger Converter::logger_("is::sh::FastDDS::Converter");
 
@@ -109,17 +146,211 @@ void Converter::set_primitive_data(
   }
 }
 
+bool Converter::is_primitive_element(const ::xtypes::DynamicType& type) {
+  if (type.is_primitive_type()) { return true; }
+  // Enumerations are copied as uint32, which is their size unless bit bound otherwise
+  return type.is_enumerated_type() && type.memory_size() == sizeof(uint32_t);
+}
+
+const ::xtypes::DynamicType* Converter::primitive_array_element(const ::xtypes::DynamicType& type) {
+  const ::xtypes::DynamicType* element = &resolve_type(type);
+  while (element->kind() == ::xtypes::TypeKind::ARRAY_TYPE) {
+    element = &resolve_type(static_cast<const ::xtypes::ArrayType*>(element)->content_type());
+  }
+  return is_primitive_element(*element) ? element : nullptr;
+}
+
+bool Converter::set_primitive_values(
+  const ::xtypes::DynamicType& element, const std::uint8_t* data, std::size_t count,
+  DynamicData* to, MemberId first) {
+  switch (element.kind()) {
+  case ::xtypes::TypeKind::BOOLEAN_TYPE:
+    read_values<bool>(
+      data, count, first, [to](bool v, MemberId id) { to->set_bool_value(v, id); });
+    break;
+  case ::xtypes::TypeKind::CHAR_8_TYPE:
+    read_values<char>(
+      data, count, first, [to](char v, MemberId id) { to->set_char8_value(v, id); });
+    break;
+  case ::xtypes::TypeKind::CHAR_16_TYPE:
+    read_values<char16_t>(data, count, first, [to](char16_t v, MemberId id) {
+      to->set_char16_value(static_cast<wchar_t>(v), id);
+    });
+    break;
+  case ::xtypes::TypeKind::WIDE_CHAR_TYPE:
+    read_values<wchar_t>(
+      data, count, first, [to](wchar_t v, MemberId id) { to->set_char16_value(v, id); });
+    break;
+  case ::xtypes::TypeKind::UINT_8_TYPE:
+    // Builders of 8-bit integers are byte builders
+    read_values<uint8_t>(
+      data, count, first, [to](uint8_t v, MemberId id) { to->set_byte_value(v, id); });
+    break;
+  case ::xtypes::TypeKind::INT_8_TYPE:
+    read_values<int8_t>(data, count, first, [to](int8_t v, MemberId id) {
+      to->set_byte_value(static_cast<rtps::octet>(v), id);
+    });
+    break;
+  case ::xtypes::TypeKind::INT_16_TYPE:
+    read_values<int16_t>(
+      data, count, first, [to](int16_t v, MemberId id) { to->set_int16_value(v, id); });
+    break;
+  case ::xtypes::TypeKind::UINT_16_TYPE:
+    read_values<uint16_t>(
+      data, count, first, [to](uint16_t v, MemberId id) { to->set_uint16_value(v, id); });
+    break;
+  case ::xtypes::TypeKind::INT_32_TYPE:
+    read_values<int32_t>(
+      data, count, first, [to](int32_t v, MemberId id) { to->set_int32_value(v, id); });
+    break;
+  case ::xtypes::TypeKind::UINT_32_TYPE:
+    read_values<uint32_t>(
+      data, count, first, [to](uint32_t v, MemberId id) { to->set_uint32_value(v, id); });
+    break;
+  case ::xtypes::TypeKind::INT_64_TYPE:
+    read_values<int64_t>(
+      data, count, first, [to](int64_t v, MemberId id) { to->set_int64_value(v, id); });
+    break;
+  case ::xtypes::TypeKind::UINT_64_TYPE:
+    read_values<uint64_t>(
+      data, count, first, [to](uint64_t v, MemberId id) { to->set_uint64_value(v, id); });
+    break;
+  case ::xtypes::TypeKind::FLOAT_32_TYPE:
+    read_values<float>(
+      data, count, first, [to](float v, MemberId id) { to->set_float32_value(v, id); });
+    break;
+  case ::xtypes::TypeKind::FLOAT_64_TYPE:
+    read_values<double>(
+      data, count, first, [to](double v, MemberId id) { to->set_float64_value(v, id); });
+    break;
+  case ::xtypes::TypeKind::FLOAT_128_TYPE:
+    read_values<long double>(
+      data, count, first, [to](long double v, MemberId id) { to->set_float128_value(v, id); });
+    break;
+  case ::xtypes::TypeKind::ENUMERATION_TYPE:
+    if (element.memory_size() != sizeof(uint32_t)) { return false; }
+    read_values<uint32_t>(
+      data, count, first, [to](uint32_t v, MemberId id) { to->set_enum_value(v, id); });
+    break;
+  default: return false;
+  }
+  return true;
+}
+
+bool Converter::get_primitive_values(
+  DynamicData* from, MemberId first, const ::xtypes::DynamicType& element, std::uint8_t* data,
+  std::size_t count) {
+  switch (element.kind()) {
+  case ::xtypes::TypeKind::BOOLEAN_TYPE:
+    write_values<bool>(
+      data, count, first, [from](bool& v, MemberId id) { from->get_bool_value(v, id); });
+    break;
+  case ::xtypes::TypeKind::CHAR_8_TYPE:
+    write_values<char>(
+      data, count, first, [from](char& v, MemberId id) { from->get_char8_value(v, id); });
+    break;
+  case ::xtypes::TypeKind::CHAR_16_TYPE:
+    write_values<char16_t>(data, count, first, [from](char16_t& v, MemberId id) {
+      wchar_t value = 0;
+      from->get_char16_value(value, id);
+      v = static_cast<char16_t>(value);
+    });
+    break;
+  case ::xtypes::TypeKind::WIDE_CHAR_TYPE:
+    write_values<wchar_t>(
+      data, count, first, [from](wchar_t& v, MemberId id) { from->get_char16_value(v, id); });
+    break;
+  case ::xtypes::TypeKind::UINT_8_TYPE:
+    write_values<uint8_t>(
+      data, count, first, [from](uint8_t& v, MemberId id) { from->get_byte_value(v, id); });
+    break;
+  case ::xtypes::TypeKind::INT_8_TYPE:
+    write_values<int8_t>(data, count, first, [from](int8_t& v, MemberId id) {
+      rtps::octet value = 0;
+      from->get_byte_value(value, id);
+      v = static_cast<int8_t>(value);
+    });
+    break;
+  case ::xtypes::TypeKind::INT_16_TYPE:
+    write_values<int16_t>(
+      data, count, first, [from](int16_t& v, MemberId id) { from->get_int16_value(v, id); });
+    break;
+  case ::xtypes::TypeKind::UINT_16_TYPE:
+    write_values<uint16_t>(
+      data, count, first, [from](uint16_t& v, MemberId id) { from->get_uint16_value(v, id); });
+    break;
+  case ::xtypes::TypeKind::INT_32_TYPE:
+    write_values<int32_t>(
+      data, count, first, [from](int32_t& v, MemberId id) { from->get_int32_value(v, id); });
+    break;
+  case ::xtypes::TypeKind::UINT_32_TYPE:
+    write_values<uint32_t>(
+      data, count, first, [from](uint32_t& v, MemberId id) { from->get_uint32_value(v, id); });
+    break;
+  case ::xtypes::TypeKind::INT_64_TYPE:
+    write_values<int64_t>(
+      data, count, first, [from](int64_t& v, MemberId id) { from->get_int64_value(v, id); });
+    break;
+  case ::xtypes::TypeKind::UINT_64_TYPE:
+    write_values<uint64_t>(
+      data, count, first, [from](uint64_t& v, MemberId id) { from->get_uint64_value(v, id); });
+    break;
+  case ::xtypes::TypeKind::FLOAT_32_TYPE:
+    write_values<float>(
+      data, count, first, [from](float& v, MemberId id) { from->get_float32_value(v, id); });
+    break;
+  case ::xtypes::TypeKind::FLOAT_64_TYPE:
+    write_values<double>(
+      data, count, first, [from](double& v, MemberId id) { from->get_float64_value(v, id); });
+    break;
+  case ::xtypes::TypeKind::FLOAT_128_TYPE:
+    write_values<long double>(data, count, first, [from](long double& v, MemberId id) {
+      from->get_float128_value(v, id);
+    });
+    break;
+  case ::xtypes::TypeKind::ENUMERATION_TYPE:
+    if (element.memory_size() != sizeof(uint32_t)) { return false; }
+    write_values<uint32_t>(
+      data, count, first, [from](uint32_t& v, MemberId id) { from->get_enum_value(v, id); });
+    break;
+  default: return false;
+  }
+  return true;
+}
+
+bool Converter::set_primitive_array(::xtypes::ReadableDynamicDataRef from, DynamicData* to) {
+  const ::xtypes::DynamicType* element = primitive_array_element(from.type());
+  if (!element) { return false; }
+
+  const std::size_t count = from.type().memory_size() / element->memory_size();
+  const auto* data = reinterpret_cast<const std::uint8_t*>(from.instance_id());
+  return set_primitive_values(*element, data, count, to, 0);
+}
+
+bool Converter::set_primitive_array(DynamicData* from, ::xtypes::WritableDynamicDataRef to) {
+  const ::xtypes::DynamicType* element = primitive_array_element(to.type());
+  if (!element) { return false; }
+
+  const std::size_t count = to.type().memory_size() / element->memory_size();
+  auto* data = reinterpret_cast<std::uint8_t*>(to.instance_id());
+  return get_primitive_values(from, 0, *element, data, count);
+}
+
 void Converter::set_array_data(
   eprosima::xtypes::ReadableDynamicDataRef from, DynamicData* to,
-  const std::vector<uint32_t>& indexes) {
+  const std::vector<uint32_t>& indexes, const SequenceLengths* lengths) {
+  // Arrays of primitives are copied in one pass, starting from the outermost dimension
+  if (indexes.empty() && set_primitive_array(from, to)) { return; }
+
   const ::xtypes::ArrayType& type = static_cast<const ::xtypes::ArrayType&>(from.type());
   const ::xtypes::DynamicType& inner_type = resolve_type(type.content_type());
   DynamicDataFactory* factory = DynamicDataFactory::get_instance();
   MemberId id;
 
+  std::vector<uint32_t> new_indexes = indexes;
+  new_indexes.push_back(0);
   for (uint32_t idx = 0; idx < from.size(); ++idx) {
-    std::vector<uint32_t> new_indexes = indexes;
-    new_indexes.push_back(idx);
+    new_indexes.back() = idx;
     switch (inner_type.kind()) {
     case ::xtypes::TypeKind::BOOLEAN_TYPE:
       id = to->get_array_index(new_indexes);
@@ -191,7 +422,7 @@ void Converter::set_array_data(
       to->set_enum_value(from[idx].value<uint32_t>(), id);
       break;
     case ::xtypes::TypeKind::ARRAY_TYPE: {
-      set_array_data(from[idx], to, new_indexes);
+      set_array_data(from[idx], to, new_indexes, lengths);
       break;
     }
     case ::xtypes::TypeKind::SEQUENCE_TYPE: {
@@ -199,7 +430,7 @@ void Converter::set_array_data(
       DynamicTypeBuilder_ptr builder = get_builder(from[idx].type()); // The inner sequence builder
       DynamicTypeBuilder* builder_ptr = static_cast<DynamicTypeBuilder*>(builder.get());
       DynamicData* seq_data = factory->create_data(builder_ptr->build());
-      set_sequence_data(from[idx], seq_data);
+      set_sequence_data(from[idx], seq_data, lengths);
       to->set_complex_value(seq_data, id);
       break;
     }
@@ -208,7 +439,7 @@ void Converter::set_array_data(
       DynamicTypeBuilder_ptr builder = get_builder(from[idx].type()); // The inner map builder
       DynamicTypeBuilder* builder_ptr = static_cast<DynamicTypeBuilder*>(builder.get());
       DynamicData* seq_data = factory->create_data(builder_ptr->build());
-      set_map_data(from[idx], seq_data);
+      set_map_data(from[idx], seq_data, lengths);
       to->set_complex_value(seq_data, id);
       break;
     }
@@ -217,7 +448,7 @@ void Converter::set_array_data(
       DynamicTypeBuilder_ptr builder = get_builder(from[idx].type()); // The inner struct builder
       DynamicTypeBuilder* builder_ptr = static_cast<DynamicTypeBuilder*>(builder.get());
       DynamicData* st_data = factory->create_data(builder_ptr->build());
-      set_struct_data(from[idx], st_data);
+      set_struct_data(from[idx], st_data, lengths);
       to->set_complex_value(st_data, id);
       break;
     }
@@ -226,7 +457,7 @@ void Converter::set_array_data(
       DynamicTypeBuilder_ptr builder = get_builder(from[idx].type()); // The inner struct builder
       DynamicTypeBuilder* builder_ptr = static_cast<DynamicTypeBuilder*>(builder.get());
       DynamicData* st_data = factory->create_data(builder_ptr->build());
-      set_union_data(from[idx], st_data);
+      set_union_data(from[idx], st_data, lengths);
       to->set_complex_value(st_data, id);
       break;
     }
@@ -238,14 +469,37 @@ void Converter::set_array_data(
   }
 }
 
-void Converter::set_sequence_data(eprosima::xtypes::ReadableDynamicDataRef from, DynamicData* to) {
+void Converter::set_sequence_data(
+  eprosima::xtypes::ReadableDynamicDataRef from, DynamicData* to,
+  const SequenceLengths* lengths) {
   const ::xtypes::SequenceType& type = static_cast<const ::xtypes::SequenceType&>(from.type());
+  const ::xtypes::DynamicType& content_type = resolve_type(type.content_type());
   MemberId id;
   DynamicDataFactory* factory = DynamicDataFactory::get_instance();
+
+  // Bounded sequences of data stores have a length separate from their size
+  std::size_t length = from.size();
+  if (const std::uint32_t* registered = sequence_length(lengths, from.instance_id())) {
+    length = std::min<std::size_t>(*registered, length);
+  }
+
+  if (is_primitive_element(content_type)) {
+    // Elements of the previous sample are kept and overwritten, such that only a change of
+    // length allocates or frees fast-dds elements
+    uint32_t items = to->get_item_count();
+    while (items > length) { to->remove_sequence_data(--items); }
+    for (; items < length; ++items) { to->insert_sequence_data(id); }
+    if (length > 0) {
+      const auto* data = reinterpret_cast<const std::uint8_t*>(from[0].instance_id());
+      set_primitive_values(content_type, data, length, to, 0);
+    }
+    return;
+  }
+
   to->clear_all_values();
-  for (uint32_t idx = 0; idx < from.size(); ++idx) {
+  for (uint32_t idx = 0; idx < length; ++idx) {
     to->insert_sequence_data(id);
-    switch (resolve_type(type.content_type()).kind()) {
+    switch (content_type.kind()) {
     case ::xtypes::TypeKind::BOOLEAN_TYPE: to->set_bool_value(from[idx].value<bool>(), id); break;
     case ::xtypes::TypeKind::CHAR_8_TYPE: to->set_char8_value(from[idx].value<char>(), id); break;
     case ::xtypes::TypeKind::CHAR_16_TYPE:
@@ -300,7 +554,7 @@ void Converter::set_sequence_data(eprosima::xtypes::ReadableDynamicDataRef from,
       DynamicTypeBuilder_ptr builder = get_builder(from[idx].type()); // The inner array builder
       DynamicTypeBuilder* builder_ptr = static_cast<DynamicTypeBuilder*>(builder.get());
       DynamicData* array_data = factory->create_data(builder_ptr->build());
-      set_array_data(from[idx], array_data, std::vector<uint32_t>());
+      set_array_data(from[idx], array_data, std::vector<uint32_t>(), lengths);
       to->set_complex_value(array_data, id);
       break;
     }
@@ -308,7 +562,7 @@ void Converter::set_sequence_data(eprosima::xtypes::ReadableDynamicDataRef from,
       DynamicTypeBuilder_ptr builder = get_builder(from[idx].type()); // The inner sequence builder
       DynamicTypeBuilder* builder_ptr = static_cast<DynamicTypeBuilder*>(builder.get());
       DynamicData* seq_data = factory->create_data(builder_ptr->build());
-      set_sequence_data(from[idx], seq_data);
+      set_sequence_data(from[idx], seq_data, lengths);
       to->set_complex_value(seq_data, id);
       break;
     }
@@ -316,7 +570,7 @@ void Converter::set_sequence_data(eprosima::xtypes::ReadableDynamicDataRef from,
       DynamicTypeBuilder_ptr builder = get_builder(from[idx].type()); // The inner map builder
       DynamicTypeBuilder* builder_ptr = static_cast<DynamicTypeBuilder*>(builder.get());
       DynamicData* seq_data = factory->create_data(builder_ptr->build());
-      set_map_data(from[idx], seq_data);
+      set_map_data(from[idx], seq_data, lengths);
       to->set_complex_value(seq_data, id);
       break;
     }
@@ -324,7 +578,7 @@ void Converter::set_sequence_data(eprosima::xtypes::ReadableDynamicDataRef from,
       DynamicTypeBuilder_ptr builder = get_builder(from[idx].type()); // The inner struct builder
       DynamicTypeBuilder* builder_ptr = static_cast<DynamicTypeBuilder*>(builder.get());
       DynamicData* st_data = factory->create_data(builder_ptr->build());
-      set_struct_data(from[idx], st_data);
+      set_struct_data(from[idx], st_data, lengths);
       to->set_complex_value(st_data, id);
       break;
     }
@@ -332,7 +586,7 @@ void Converter::set_sequence_data(eprosima::xtypes::ReadableDynamicDataRef from,
       DynamicTypeBuilder_ptr builder = get_builder(from[idx].type()); // The inner union builder
       DynamicTypeBuilder* builder_ptr = static_cast<DynamicTypeBuilder*>(builder.get());
       DynamicData* st_data = factory->create_data(builder_ptr->build());
-      set_union_data(from[idx], st_data);
+      set_union_data(from[idx], st_data, lengths);
       to->set_complex_value(st_data, id);
       break;
     }
@@ -344,24 +598,52 @@ void Converter::set_sequence_data(eprosima::xtypes::ReadableDynamicDataRef from,
   }
 }
 
-void Converter::set_map_data(eprosima::xtypes::ReadableDynamicDataRef from, DynamicData* to) {
+void Converter::set_map_data(
+  eprosima::xtypes::ReadableDynamicDataRef from, DynamicData* to,
+  const SequenceLengths* lengths) {
   const ::xtypes::MapType& type = static_cast<const ::xtypes::MapType&>(from.type());
   const ::xtypes::PairType& pair_type = static_cast<const ::xtypes::PairType&>(type.content_type());
+  const ::xtypes::DynamicType& key_type = resolve_type(pair_type.first());
+  const ::xtypes::DynamicType& value_type = resolve_type(pair_type.second());
   MemberId id_key;
   MemberId id_value;
   DynamicDataFactory* factory = DynamicDataFactory::get_instance();
+
+  if (
+    is_primitive_element(key_type) && is_primitive_element(value_type)
+    && to->get_item_count() == from.size()) {
+    // Samples commonly have the same keys in the same order as the previous sample, then
+    // only values are updated in place. Keys and values have alternating member ids.
+    alignas(long double) std::uint8_t key[sizeof(long double)];
+    MemberId key_id = 0;
+    bool same_keys = true;
+    for (::xtypes::ReadableDynamicDataRef pair : from) {
+      const auto* key_data = reinterpret_cast<const std::uint8_t*>(pair[0].instance_id());
+      get_primitive_values(to, key_id, key_type, key, 1);
+      if (std::memcmp(key, key_data, key_type.memory_size()) != 0) {
+        same_keys = false;
+        break;
+      }
+      const auto* value_data = reinterpret_cast<const std::uint8_t*>(pair[1].instance_id());
+      set_primitive_values(value_type, value_data, 1, to, key_id + 1);
+      key_id += 2;
+    }
+    if (same_keys) { return; }
+  }
   to->clear_all_values();
 
   DynamicTypeBuilder_ptr key_builder = get_builder(pair_type.first());
   DynamicTypeBuilder_ptr value_builder = get_builder(pair_type.second());
+  DynamicType_ptr key_dynamic_type = key_builder->build();
+  DynamicType_ptr value_dynamic_type = value_builder->build();
 
   for (::xtypes::ReadableDynamicDataRef pair : from) {
     // Convert key
-    DynamicData* key_data = factory->create_data(key_builder->build());
+    DynamicData* key_data = factory->create_data(key_dynamic_type);
     ::xtypes::ReadableDynamicDataRef key = pair[0];
     MemberId id = MEMBER_ID_INVALID;
 
-    switch (resolve_type(pair_type.first()).kind()) {
+    switch (key_type.kind()) {
     case ::xtypes::TypeKind::BOOLEAN_TYPE: key_data->set_bool_value(key, id); break;
     case ::xtypes::TypeKind::CHAR_8_TYPE: key_data->set_char8_value(key, id); break;
     case ::xtypes::TypeKind::CHAR_16_TYPE:
@@ -392,7 +674,7 @@ void Converter::set_map_data(eprosima::xtypes::ReadableDynamicDataRef from, Dyna
       DynamicTypeBuilder_ptr builder = get_builder(key.type()); // The inner array builder
       DynamicTypeBuilder* builder_ptr = static_cast<DynamicTypeBuilder*>(builder.get());
       DynamicData* array_data = factory->create_data(builder_ptr->build());
-      set_array_data(key, array_data, std::vector<uint32_t>());
+      set_array_data(key, array_data, std::vector<uint32_t>(), lengths);
       key_data->set_complex_value(array_data, id);
       break;
     }
@@ -400,7 +682,7 @@ void Converter::set_map_data(eprosima::xtypes::ReadableDynamicDataRef from, Dyna
       DynamicTypeBuilder_ptr builder = get_builder(key.type()); // The inner map builder
       DynamicTypeBuilder* builder_ptr = static_cast<DynamicTypeBuilder*>(builder.get());
       DynamicData* seq_data = factory->create_data(builder_ptr->build());
-      set_map_data(key, seq_data);
+      set_map_data(key, seq_data, lengths);
       key_data->set_complex_value(seq_data, id);
       break;
     }
@@ -408,7 +690,7 @@ void Converter::set_map_data(eprosima::xtypes::ReadableDynamicDataRef from, Dyna
       DynamicTypeBuilder_ptr builder = get_builder(key.type()); // The inner sequence builder
       DynamicTypeBuilder* builder_ptr = static_cast<DynamicTypeBuilder*>(builder.get());
       DynamicData* seq_data = factory->create_data(builder_ptr->build());
-      set_sequence_data(key, seq_data);
+      set_sequence_data(key, seq_data, lengths);
       key_data->set_complex_value(seq_data, id);
       break;
     }
@@ -416,7 +698,7 @@ void Converter::set_map_data(eprosima::xtypes::ReadableDynamicDataRef from, Dyna
       DynamicTypeBuilder_ptr builder = get_builder(key.type()); // The inner struct builder
       DynamicTypeBuilder* builder_ptr = static_cast<DynamicTypeBuilder*>(builder.get());
       DynamicData* st_data = factory->create_data(builder_ptr->build());
-      set_struct_data(key, st_data);
+      set_struct_data(key, st_data, lengths);
       key_data->set_complex_value(st_data, id);
       break;
     }
@@ -424,7 +706,7 @@ void Converter::set_map_data(eprosima::xtypes::ReadableDynamicDataRef from, Dyna
       DynamicTypeBuilder_ptr builder = get_builder(key.type()); // The inner struct builder
       DynamicTypeBuilder* builder_ptr = static_cast<DynamicTypeBuilder*>(builder.get());
       DynamicData* st_data = factory->create_data(builder_ptr->build());
-      set_union_data(key, st_data);
+      set_union_data(key, st_data, lengths);
       key_data->set_complex_value(st_data, id);
       break;
     }
@@ -436,10 +718,10 @@ void Converter::set_map_data(eprosima::xtypes::ReadableDynamicDataRef from, Dyna
 
     // Convert data
     id = MEMBER_ID_INVALID;
-    DynamicData* value_data = factory->create_data(value_builder->build());
+    DynamicData* value_data = factory->create_data(value_dynamic_type);
     ::xtypes::ReadableDynamicDataRef value = pair[1];
 
-    switch (resolve_type(pair_type.second()).kind()) {
+    switch (value_type.kind()) {
     case ::xtypes::TypeKind::BOOLEAN_TYPE: value_data->set_bool_value(value, id); break;
     case ::xtypes::TypeKind::CHAR_8_TYPE: value_data->set_char8_value(value, id); break;
     case ::xtypes::TypeKind::CHAR_16_TYPE:
@@ -467,23 +749,23 @@ void Converter::set_map_data(eprosima::xtypes::ReadableDynamicDataRef from, Dyna
       value_data->set_enum_value(value.value<uint32_t>(), id);
       break;
     case ::xtypes::TypeKind::ARRAY_TYPE: {
-      set_array_data(value, value_data, std::vector<uint32_t>());
+      set_array_data(value, value_data, std::vector<uint32_t>(), lengths);
       break;
     }
     case ::xtypes::TypeKind::MAP_TYPE: {
-      set_map_data(value, value_data);
+      set_map_data(value, value_data, lengths);
       break;
     }
     case ::xtypes::TypeKind::SEQUENCE_TYPE: {
-      set_sequence_data(value, value_data);
+      set_sequence_data(value, value_data, lengths);
       break;
     }
     case ::xtypes::TypeKind::STRUCTURE_TYPE: {
-      set_struct_data(value, value_data);
+      set_struct_data(value, value_data, lengths);
       break;
     }
     case ::xtypes::TypeKind::UNION_TYPE: {
-      set_union_data(value, value_data);
+      set_union_data(value, value_data, lengths);
       break;
     }
     default: {
@@ -497,11 +779,13 @@ void Converter::set_map_data(eprosima::xtypes::ReadableDynamicDataRef from, Dyna
   }
 }
 
-bool Converter::xtypes_to_fastdds(const ::xtypes::DynamicData& input, DynamicData* output) {
+bool Converter::xtypes_to_fastdds(
+  const ::xtypes::ReadableDynamicDataRef& input, DynamicData* output,
+  const SequenceLengths* lengths) {
   if (input.type().kind() == ::xtypes::TypeKind::STRUCTURE_TYPE) {
-    return set_struct_data(input, output);
+    return set_struct_data(input, output, lengths);
   } else if (input.type().kind() == ::xtypes::TypeKind::UNION_TYPE) {
-    return set_union_data(input, output);
+    return set_union_data(input, output, lengths);
   }
 
   /*logger_ << utils::Logger::Level::ERROR
@@ -511,8 +795,8 @@ bool Converter::xtypes_to_fastdds(const ::xtypes::DynamicData& input, DynamicDat
 }
 
 bool Converter::set_struct_data(
-  eprosima::xtypes::ReadableDynamicDataRef input, DynamicData* output) {
-  std::stringstream ss;
+  eprosima::xtypes::ReadableDynamicDataRef input, DynamicData* output,
+  const SequenceLengths* lengths) {
 
   const ::xtypes::StructType& type = static_cast<const ::xtypes::StructType&>(input.type());
 
@@ -542,31 +826,31 @@ bool Converter::set_struct_data(
     }
     case ::xtypes::TypeKind::ARRAY_TYPE: {
       DynamicData* array_data = output->loan_value(id);
-      set_array_data(input[member.name()], array_data, std::vector<uint32_t>());
+      set_array_data(input[member.name()], array_data, std::vector<uint32_t>(), lengths);
       output->return_loaned_value(array_data);
       break;
     }
     case ::xtypes::TypeKind::SEQUENCE_TYPE: {
       DynamicData* seq_data = output->loan_value(id);
-      set_sequence_data(input[member.name()], seq_data);
+      set_sequence_data(input[member.name()], seq_data, lengths);
       output->return_loaned_value(seq_data);
       break;
     }
     case ::xtypes::TypeKind::MAP_TYPE: {
       DynamicData* seq_data = output->loan_value(id);
-      set_map_data(input[member.name()], seq_data);
+      set_map_data(input[member.name()], seq_data, lengths);
       output->return_loaned_value(seq_data);
       break;
     }
     case ::xtypes::TypeKind::STRUCTURE_TYPE: {
       DynamicData* st_data = output->loan_value(id);
-      set_struct_data(input[member.name()], st_data);
+      set_struct_data(input[member.name()], st_data, lengths);
       output->return_loaned_value(st_data);
       break;
     }
     case ::xtypes::TypeKind::UNION_TYPE: {
       DynamicData* st_data = output->loan_value(id);
-      set_union_data(input[member.name()], st_data);
+      set_union_data(input[member.name()], st_data, lengths);
       output->return_loaned_value(st_data);
       break;
     }
@@ -579,8 +863,8 @@ bool Converter::set_struct_data(
 }
 
 bool Converter::set_union_data(
-  eprosima::xtypes::ReadableDynamicDataRef input, DynamicData* output) {
-  std::stringstream ss;
+  eprosima::xtypes::ReadableDynamicDataRef input, DynamicData* output,
+  const SequenceLengths* lengths) {
 
   // Discriminator
   switch (resolve_type(input.d().type()).kind()) {
@@ -653,31 +937,31 @@ bool Converter::set_union_data(
   }
   case ::xtypes::TypeKind::ARRAY_TYPE: {
     DynamicData* array_data = output->loan_value(id);
-    set_array_data(input[member.name()], array_data, std::vector<uint32_t>());
+    set_array_data(input[member.name()], array_data, std::vector<uint32_t>(), lengths);
     output->return_loaned_value(array_data);
     break;
   }
   case ::xtypes::TypeKind::SEQUENCE_TYPE: {
     DynamicData* seq_data = output->loan_value(id);
-    set_sequence_data(input[member.name()], seq_data);
+    set_sequence_data(input[member.name()], seq_data, lengths);
     output->return_loaned_value(seq_data);
     break;
   }
   case ::xtypes::TypeKind::STRUCTURE_TYPE: {
     DynamicData* st_data = output->loan_value(id);
-    set_struct_data(input[member.name()], st_data);
+    set_struct_data(input[member.name()], st_data, lengths);
     output->return_loaned_value(st_data);
     break;
   }
   case ::xtypes::TypeKind::MAP_TYPE: {
     DynamicData* st_data = output->loan_value(id);
-    set_map_data(input[member.name()], st_data);
+    set_map_data(input[member.name()], st_data, lengths);
     output->return_loaned_value(st_data);
     break;
   }
   case ::xtypes::TypeKind::UNION_TYPE: {
     DynamicData* st_data = output->loan_value(id);
-    set_union_data(input[member.name()], st_data);
+    set_union_data(input[member.name()], st_data, lengths);
     output->return_loaned_value(st_data);
     break;
   }
@@ -689,143 +973,198 @@ bool Converter::set_union_data(
 }
 
 void Converter::set_sequence_data(
-  const DynamicData* c_from, eprosima::xtypes::WritableDynamicDataRef to) {
+  const DynamicData* c_from, eprosima::xtypes::WritableDynamicDataRef to,
+  const SequenceLengths* lengths) {
   const ::xtypes::SequenceType& type = static_cast<const ::xtypes::SequenceType&>(to.type());
+  const ::xtypes::DynamicType& content_type = resolve_type(type.content_type());
   DynamicData* from = const_cast<DynamicData*>(c_from);
 
-  for (uint32_t idx = 0; idx < c_from->get_item_count(); ++idx) {
+  // Bounded sequences of data stores are kept at their bound and updated in place
+  std::uint32_t* length = sequence_length(lengths, to.instance_id());
+  const bool in_place = length != nullptr;
+  uint32_t count = c_from->get_item_count();
+  if (in_place) {
+    count = std::min(count, static_cast<uint32_t>(to.size()));
+    *length = count;
+  }
+
+  if (is_primitive_element(content_type)) {
+    // Sequences only shrink by reconstruction, otherwise their memory is reused
+    if (!in_place && to.size() != count) {
+      if (to.size() > count) {
+        auto* instance = reinterpret_cast<std::uint8_t*>(to.instance_id());
+        type.destroy_instance(instance);
+        type.construct_instance(instance);
+      }
+      to.resize(count);
+    }
+    if (count > 0) {
+      auto* data = reinterpret_cast<std::uint8_t*>(to[0].instance_id());
+      get_primitive_values(from, 0, content_type, data, count);
+    }
+    return;
+  }
+
+  if (!in_place && to.size() > 0) {
+    // Elements are appended, so previous ones are removed
+    auto* instance = reinterpret_cast<std::uint8_t*>(to.instance_id());
+    type.destroy_instance(instance);
+    type.construct_instance(instance);
+  }
+
+  for (uint32_t idx = 0; idx < count; ++idx) {
     MemberId id = idx;
     ResponseCode ret = ResponseCode::RETCODE_ERROR;
 
-    switch (resolve_type(type.content_type()).kind()) {
+    switch (content_type.kind()) {
     case ::xtypes::TypeKind::BOOLEAN_TYPE: {
       bool value;
       ret = from->get_bool_value(value, id);
-      to.push(value);
+      store_element(to, idx, in_place, value);
     } break;
     case ::xtypes::TypeKind::CHAR_8_TYPE: {
       char value;
       ret = from->get_char8_value(value, id);
-      to.push(value);
+      store_element(to, idx, in_place, value);
     } break;
     case ::xtypes::TypeKind::CHAR_16_TYPE:
     case ::xtypes::TypeKind::WIDE_CHAR_TYPE: {
       wchar_t value;
       ret = from->get_char16_value(value, id);
-      to.push(value);
+      store_element(to, idx, in_place, value);
     } break;
     case ::xtypes::TypeKind::UINT_8_TYPE: {
       uint8_t value;
       ret = from->get_uint8_value(value, id);
-      to.push(value);
+      store_element(to, idx, in_place, value);
     } break;
     case ::xtypes::TypeKind::INT_8_TYPE: {
       int8_t value;
       ret = from->get_int8_value(value, id);
-      to.push(value);
+      store_element(to, idx, in_place, value);
     } break;
     case ::xtypes::TypeKind::INT_16_TYPE: {
       int16_t value;
       ret = from->get_int16_value(value, id);
-      to.push(value);
+      store_element(to, idx, in_place, value);
     } break;
     case ::xtypes::TypeKind::UINT_16_TYPE: {
       uint16_t value;
       ret = from->get_uint16_value(value, id);
-      to.push(value);
+      store_element(to, idx, in_place, value);
     } break;
     case ::xtypes::TypeKind::INT_32_TYPE: {
       int32_t value;
       ret = from->get_int32_value(value, id);
-      to.push(value);
+      store_element(to, idx, in_place, value);
     } break;
     case ::xtypes::TypeKind::UINT_32_TYPE: {
       uint32_t value;
       ret = from->get_uint32_value(value, id);
-      to.push(value);
+      store_element(to, idx, in_place, value);
     } break;
     case ::xtypes::TypeKind::INT_64_TYPE: {
       int64_t value;
       ret = from->get_int64_value(value, id);
-      to.push(value);
+      store_element(to, idx, in_place, value);
     } break;
     case ::xtypes::TypeKind::UINT_64_TYPE: {
       uint64_t value;
       ret = from->get_uint64_value(value, id);
-      to.push(value);
+      store_element(to, idx, in_place, value);
     } break;
     case ::xtypes::TypeKind::FLOAT_32_TYPE: {
       float value;
       ret = from->get_float32_value(value, id);
-      to.push(value);
+      store_element(to, idx, in_place, value);
     } break;
     case ::xtypes::TypeKind::FLOAT_64_TYPE: {
       double value;
       ret = from->get_float64_value(value, id);
-      to.push(value);
+      store_element(to, idx, in_place, value);
     } break;
     case ::xtypes::TypeKind::FLOAT_128_TYPE: {
       long double value;
       ret = from->get_float128_value(value, id);
-      to.push(value);
+      store_element(to, idx, in_place, value);
     } break;
     case ::xtypes::TypeKind::STRING_TYPE: {
       std::string value;
       ret = from->get_string_value(value, id);
-      to.push(value);
+      store_element(to, idx, in_place, value);
     } break;
     case ::xtypes::TypeKind::WSTRING_TYPE: {
       std::wstring value;
       ret = from->get_wstring_value(value, id);
-      to.push(value);
+      store_element(to, idx, in_place, value);
     } break;
     case ::xtypes::TypeKind::ENUMERATION_TYPE: {
       uint32_t value;
       ret = from->get_enum_value(value, id);
-      to.push(value);
+      store_element(to, idx, in_place, value);
     } break;
     case ::xtypes::TypeKind::ARRAY_TYPE: {
       DynamicData* array = from->loan_value(id);
-      ::xtypes::DynamicData xtypes_array(type.content_type());
-      set_array_data(array, xtypes_array.ref(), std::vector<uint32_t>());
+      if (in_place) {
+        set_array_data(array, to[idx], std::vector<uint32_t>(), lengths);
+      } else {
+        ::xtypes::DynamicData xtypes_array(type.content_type());
+        set_array_data(array, xtypes_array.ref(), std::vector<uint32_t>(), lengths);
+        to.push(xtypes_array);
+      }
       from->return_loaned_value(array);
-      to.push(xtypes_array);
       ret = ResponseCode::RETCODE_OK;
       break;
     }
     case ::xtypes::TypeKind::SEQUENCE_TYPE: {
       DynamicData* seq = from->loan_value(id);
-      ::xtypes::DynamicData xtypes_seq(type.content_type());
-      set_sequence_data(seq, xtypes_seq.ref());
+      if (in_place) {
+        set_sequence_data(seq, to[idx], lengths);
+      } else {
+        ::xtypes::DynamicData xtypes_seq(type.content_type());
+        set_sequence_data(seq, xtypes_seq.ref(), lengths);
+        to.push(xtypes_seq);
+      }
       from->return_loaned_value(seq);
-      to.push(xtypes_seq);
       ret = ResponseCode::RETCODE_OK;
       break;
     }
     case ::xtypes::TypeKind::MAP_TYPE: {
       DynamicData* seq = from->loan_value(id);
-      ::xtypes::DynamicData xtypes_map(type.content_type());
-      set_map_data(seq, xtypes_map.ref());
+      if (in_place) {
+        set_map_data(seq, to[idx], lengths);
+      } else {
+        ::xtypes::DynamicData xtypes_map(type.content_type());
+        set_map_data(seq, xtypes_map.ref(), lengths);
+        to.push(xtypes_map);
+      }
       from->return_loaned_value(seq);
-      to.push(xtypes_map);
       ret = ResponseCode::RETCODE_OK;
       break;
     }
     case ::xtypes::TypeKind::STRUCTURE_TYPE: {
       DynamicData* st = from->loan_value(id);
-      ::xtypes::DynamicData xtypes_st(type.content_type());
-      set_struct_data(st, xtypes_st.ref());
+      if (in_place) {
+        set_struct_data(st, to[idx], lengths);
+      } else {
+        ::xtypes::DynamicData xtypes_st(type.content_type());
+        set_struct_data(st, xtypes_st.ref(), lengths);
+        to.push(xtypes_st);
+      }
       from->return_loaned_value(st);
-      to.push(xtypes_st);
       ret = ResponseCode::RETCODE_OK;
       break;
     }
     case ::xtypes::TypeKind::UNION_TYPE: {
       DynamicData* st = from->loan_value(id);
-      ::xtypes::DynamicData xtypes_union(type.content_type());
-      set_union_data(st, xtypes_union.ref());
+      if (in_place) {
+        set_union_data(st, to[idx], lengths);
+      } else {
+        ::xtypes::DynamicData xtypes_union(type.content_type());
+        set_union_data(st, xtypes_union.ref(), lengths);
+        to.push(xtypes_union);
+      }
       from->return_loaned_value(st);
-      to.push(xtypes_union);
       ret = ResponseCode::RETCODE_OK;
       break;
     }
@@ -843,7 +1182,8 @@ void Converter::set_sequence_data(
 }
 
 void Converter::set_map_data(
-  const DynamicData* c_from, eprosima::xtypes::WritableDynamicDataRef to) {
+  const DynamicData* c_from, eprosima::xtypes::WritableDynamicDataRef to,
+  const SequenceLengths* lengths) {
   const ::xtypes::MapType& map_type = static_cast<const ::xtypes::MapType&>(to.type());
   const ::xtypes::PairType& pair_type =
     static_cast<const ::xtypes::PairType&>(map_type.content_type());
@@ -851,313 +1191,333 @@ void Converter::set_map_data(
   const ::xtypes::DynamicType& value_type = pair_type.second();
   DynamicData* from = const_cast<DynamicData*>(c_from);
 
-  for (uint32_t idx = 0; idx < c_from->get_item_count(); ++idx) {
-    MemberId key_id = idx * 2;
-    MemberId value_id = key_id + 1;
-    ResponseCode ret = ResponseCode::RETCODE_ERROR;
-
-    ::xtypes::DynamicData key_data(key_type);
-    ::xtypes::DynamicData value_data(value_type);
+  const uint32_t count = c_from->get_item_count();
+  // Entries are reused between samples. Keys of the previous sample that are missing in
+  // this sample show as a size mismatch, and the map is then rebuilt.
+  ::xtypes::DynamicData key_data(key_type);
+  ::xtypes::DynamicData value_data(value_type);
+  bool rebuild = to.size() > count;
+  while (true) {
+    if (rebuild) {
+      auto* instance = reinterpret_cast<std::uint8_t*>(to.instance_id());
+      map_type.destroy_instance(instance);
+      map_type.construct_instance(instance);
+    }
+
+    for (uint32_t idx = 0; idx < count; ++idx) {
+      MemberId key_id = idx * 2;
+      MemberId value_id = key_id + 1;
+      ResponseCode ret = ResponseCode::RETCODE_ERROR;
+
+      // Key
+      switch (resolve_type(key_type).kind()) {
+      case ::xtypes::TypeKind::BOOLEAN_TYPE: {
+        bool value;
+        ret = from->get_bool_value(value, key_id);
+        key_data = value;
+      } break;
+      case ::xtypes::TypeKind::CHAR_8_TYPE: {
+        char value;
+        ret = from->get_char8_value(value, key_id);
+        key_data = value;
+      } break;
+      case ::xtypes::TypeKind::CHAR_16_TYPE:
+      case ::xtypes::TypeKind::WIDE_CHAR_TYPE: {
+        wchar_t value;
+        ret = from->get_char16_value(value, key_id);
+        key_data = value;
+      } break;
+      case ::xtypes::TypeKind::UINT_8_TYPE: {
+        uint8_t value;
+        ret = from->get_uint8_value(value, key_id);
+        key_data = value;
+      } break;
+      case ::xtypes::TypeKind::INT_8_TYPE: {
+        int8_t value;
+        ret = from->get_int8_value(value, key_id);
+        key_data = value;
+      } break;
+      case ::xtypes::TypeKind::INT_16_TYPE: {
+        int16_t value;
+        ret = from->get_int16_value(value, key_id);
+        key_data = value;
+      } break;
+      case ::xtypes::TypeKind::UINT_16_TYPE: {
+        uint16_t value;
+        ret = from->get_uint16_value(value, key_id);
+        key_data = value;
+      } break;
+      case ::xtypes::TypeKind::INT_32_TYPE: {
+        int32_t value;
+        ret = from->get_int32_value(value, key_id);
+        key_data = value;
+      } break;
+      case ::xtypes::TypeKind::UINT_32_TYPE: {
+        uint32_t value;
+        ret = from->get_uint32_value(value, key_id);
+        key_data = value;
+      } break;
+      case ::xtypes::TypeKind::INT_64_TYPE: {
+        int64_t value;
+        ret = from->get_int64_value(value, key_id);
+        key_data = value;
+      } break;
+      case ::xtypes::TypeKind::UINT_64_TYPE: {
+        uint64_t value;
+        ret = from->get_uint64_value(value, key_id);
+        key_data = value;
+      } break;
+      case ::xtypes::TypeKind::FLOAT_32_TYPE: {
+        float value;
+        ret = from->get_float32_value(value, key_id);
+        key_data = value;
+      } break;
+      case ::xtypes::TypeKind::FLOAT_64_TYPE: {
+        double value;
+        ret = from->get_float64_value(value, key_id);
+        key_data = value;
+      } break;
+      case ::xtypes::TypeKind::FLOAT_128_TYPE: {
+        long double value;
+        ret = from->get_float128_value(value, key_id);
+        key_data = value;
+      } break;
+      case ::xtypes::TypeKind::STRING_TYPE: {
+        std::string value;
+        ret = from->get_string_value(value, key_id);
+        key_data = value;
+      } break;
+      case ::xtypes::TypeKind::WSTRING_TYPE: {
+        std::wstring value;
+        ret = from->get_wstring_value(value, key_id);
+        key_data = value;
+      } break;
+      case ::xtypes::TypeKind::ENUMERATION_TYPE: {
+        uint32_t value;
+        ret = from->get_enum_value(value, key_id);
+        key_data = value;
+      } break;
+      case ::xtypes::TypeKind::ARRAY_TYPE: {
+        DynamicData* array = from->loan_value(key_id);
+        ::xtypes::DynamicData xtypes_array(key_type);
+        set_array_data(array, xtypes_array.ref(), std::vector<uint32_t>(), lengths);
+        from->return_loaned_value(array);
+        key_data = xtypes_array;
+        ret = ResponseCode::RETCODE_OK;
+        break;
+      }
+      case ::xtypes::TypeKind::SEQUENCE_TYPE: {
+        DynamicData* seq = from->loan_value(key_id);
+        ::xtypes::DynamicData xtypes_seq(key_type);
+        set_sequence_data(seq, xtypes_seq.ref(), lengths);
+        from->return_loaned_value(seq);
+        key_data = xtypes_seq;
+        ret = ResponseCode::RETCODE_OK;
+        break;
+      }
+      case ::xtypes::TypeKind::MAP_TYPE: {
+        DynamicData* seq = from->loan_value(key_id);
+        ::xtypes::DynamicData xtypes_map(key_type);
+        set_map_data(seq, xtypes_map.ref(), lengths);
+        from->return_loaned_value(seq);
+        key_data = xtypes_map;
+        ret = ResponseCode::RETCODE_OK;
+        break;
+      }
+      case ::xtypes::TypeKind::STRUCTURE_TYPE: {
+        DynamicData* st = from->loan_value(key_id);
+        ::xtypes::DynamicData xtypes_st(key_type);
+        set_struct_data(st, xtypes_st.ref(), lengths);
+        from->return_loaned_value(st);
+        key_data = xtypes_st;
+        ret = ResponseCode::RETCODE_OK;
+        break;
+      }
+      case ::xtypes::TypeKind::UNION_TYPE: {
+        DynamicData* st = from->loan_value(key_id);
+        ::xtypes::DynamicData xtypes_union(key_type);
+        set_union_data(st, xtypes_union.ref(), lengths);
+        from->return_loaned_value(st);
+        key_data = xtypes_union;
+        ret = ResponseCode::RETCODE_OK;
+        break;
+      }
+      default: {
+        /*logger_ << utils::Logger::Level::ERROR
+                          << "Unexpected data type: '" << key_type.name() << "'" << std::endl;*/
+      }
+      }
 
-    // Key
-    switch (resolve_type(key_type).kind()) {
-    case ::xtypes::TypeKind::BOOLEAN_TYPE: {
-      bool value;
-      ret = from->get_bool_value(value, key_id);
-      key_data = value;
-    } break;
-    case ::xtypes::TypeKind::CHAR_8_TYPE: {
-      char value;
-      ret = from->get_char8_value(value, key_id);
-      key_data = value;
-    } break;
-    case ::xtypes::TypeKind::CHAR_16_TYPE:
-    case ::xtypes::TypeKind::WIDE_CHAR_TYPE: {
-      wchar_t value;
-      ret = from->get_char16_value(value, key_id);
-      key_data = value;
-    } break;
-    case ::xtypes::TypeKind::UINT_8_TYPE: {
-      uint8_t value;
-      ret = from->get_uint8_value(value, key_id);
-      key_data = value;
-    } break;
-    case ::xtypes::TypeKind::INT_8_TYPE: {
-      int8_t value;
-      ret = from->get_int8_value(value, key_id);
-      key_data = value;
-    } break;
-    case ::xtypes::TypeKind::INT_16_TYPE: {
-      int16_t value;
-      ret = from->get_int16_value(value, key_id);
-      key_data = value;
-    } break;
-    case ::xtypes::TypeKind::UINT_16_TYPE: {
-      uint16_t value;
-      ret = from->get_uint16_value(value, key_id);
-      key_data = value;
-    } break;
-    case ::xtypes::TypeKind::INT_32_TYPE: {
-      int32_t value;
-      ret = from->get_int32_value(value, key_id);
-      key_data = value;
-    } break;
-    case ::xtypes::TypeKind::UINT_32_TYPE: {
-      uint32_t value;
-      ret = from->get_uint32_value(value, key_id);
-      key_data = value;
-    } break;
-    case ::xtypes::TypeKind::INT_64_TYPE: {
-      int64_t value;
-      ret = from->get_int64_value(value, key_id);
-      key_data = value;
-    } break;
-    case ::xtypes::TypeKind::UINT_64_TYPE: {
-      uint64_t value;
-      ret = from->get_uint64_value(value, key_id);
-      key_data = value;
-    } break;
-    case ::xtypes::TypeKind::FLOAT_32_TYPE: {
-      float value;
-      ret = from->get_float32_value(value, key_id);
-      key_data = value;
-    } break;
-    case ::xtypes::TypeKind::FLOAT_64_TYPE: {
-      double value;
-      ret = from->get_float64_value(value, key_id);
-      key_data = value;
-    } break;
-    case ::xtypes::TypeKind::FLOAT_128_TYPE: {
-      long double value;
-      ret = from->get_float128_value(value, key_id);
-      key_data = value;
-    } break;
-    case ::xtypes::TypeKind::STRING_TYPE: {
-      std::string value;
-      ret = from->get_string_value(value, key_id);
-      key_data = value;
-    } break;
-    case ::xtypes::TypeKind::WSTRING_TYPE: {
-      std::wstring value;
-      ret = from->get_wstring_value(value, key_id);
-      key_data = value;
-    } break;
-    case ::xtypes::TypeKind::ENUMERATION_TYPE: {
-      uint32_t value;
-      ret = from->get_enum_value(value, key_id);
-      key_data = value;
-    } break;
-    case ::xtypes::TypeKind::ARRAY_TYPE: {
-      DynamicData* array = from->loan_value(key_id);
-      ::xtypes::DynamicData xtypes_array(key_type);
-      set_array_data(array, xtypes_array.ref(), std::vector<uint32_t>());
-      from->return_loaned_value(array);
-      key_data = xtypes_array;
-      ret = ResponseCode::RETCODE_OK;
-      break;
-    }
-    case ::xtypes::TypeKind::SEQUENCE_TYPE: {
-      DynamicData* seq = from->loan_value(key_id);
-      ::xtypes::DynamicData xtypes_seq(key_type);
-      set_sequence_data(seq, xtypes_seq.ref());
-      from->return_loaned_value(seq);
-      key_data = xtypes_seq;
-      ret = ResponseCode::RETCODE_OK;
-      break;
-    }
-    case ::xtypes::TypeKind::MAP_TYPE: {
-      DynamicData* seq = from->loan_value(key_id);
-      ::xtypes::DynamicData xtypes_map(key_type);
-      set_map_data(seq, xtypes_map.ref());
-      from->return_loaned_value(seq);
-      key_data = xtypes_map;
-      ret = ResponseCode::RETCODE_OK;
-      break;
-    }
-    case ::xtypes::TypeKind::STRUCTURE_TYPE: {
-      DynamicData* st = from->loan_value(key_id);
-      ::xtypes::DynamicData xtypes_st(key_type);
-      set_struct_data(st, xtypes_st.ref());
-      from->return_loaned_value(st);
-      key_data = xtypes_st;
-      ret = ResponseCode::RETCODE_OK;
-      break;
-    }
-    case ::xtypes::TypeKind::UNION_TYPE: {
-      DynamicData* st = from->loan_value(key_id);
-      ::xtypes::DynamicData xtypes_union(key_type);
-      set_union_data(st, xtypes_union.ref());
-      from->return_loaned_value(st);
-      key_data = xtypes_union;
-      ret = ResponseCode::RETCODE_OK;
-      break;
-    }
-    default: {
-      /*logger_ << utils::Logger::Level::ERROR
-                        << "Unexpected data type: '" << key_type.name() << "'" << std::endl;*/
-    }
-    }
+      // Value
+      switch (resolve_type(value_type).kind()) {
+      case ::xtypes::TypeKind::BOOLEAN_TYPE: {
+        bool value;
+        ret = from->get_bool_value(value, value_id);
+        value_data = value;
+      } break;
+      case ::xtypes::TypeKind::CHAR_8_TYPE: {
+        char value;
+        ret = from->get_char8_value(value, value_id);
+        value_data = value;
+      } break;
+      case ::xtypes::TypeKind::CHAR_16_TYPE:
+      case ::xtypes::TypeKind::WIDE_CHAR_TYPE: {
+        wchar_t value;
+        ret = from->get_char16_value(value, value_id);
+        value_data = value;
+      } break;
+      case ::xtypes::TypeKind::UINT_8_TYPE: {
+        uint8_t value;
+        ret = from->get_uint8_value(value, value_id);
+        value_data = value;
+      } break;
+      case ::xtypes::TypeKind::INT_8_TYPE: {
+        int8_t value;
+        ret = from->get_int8_value(value, value_id);
+        value_data = value;
+      } break;
+      case ::xtypes::TypeKind::INT_16_TYPE: {
+        int16_t value;
+        ret = from->get_int16_value(value, value_id);
+        value_data = value;
+      } break;
+      case ::xtypes::TypeKind::UINT_16_TYPE: {
+        uint16_t value;
+        ret = from->get_uint16_value(value, value_id);
+        value_data = value;
+      } break;
+      case ::xtypes::TypeKind::INT_32_TYPE: {
+        int32_t value;
+        ret = from->get_int32_value(value, value_id);
+        value_data = value;
+      } break;
+      case ::xtypes::TypeKind::UINT_32_TYPE: {
+        uint32_t value;
+        ret = from->get_uint32_value(value, value_id);
+        value_data = value;
+      } break;
+      case ::xtypes::TypeKind::INT_64_TYPE: {
+        int64_t value;
+        ret = from->get_int64_value(value, value_id);
+        value_data = value;
+      } break;
+      case ::xtypes::TypeKind::UINT_64_TYPE: {
+        uint64_t value;
+        ret = from->get_uint64_value(value, value_id);
+        value_data = value;
+      } break;
+      case ::xtypes::TypeKind::FLOAT_32_TYPE: {
+        float value;
+        ret = from->get_float32_value(value, value_id);
+        value_data = value;
+      } break;
+      case ::xtypes::TypeKind::FLOAT_64_TYPE: {
+        double value;
+        ret = from->get_float64_value(value, value_id);
+        value_data = value;
+      } break;
+      case ::xtypes::TypeKind::FLOAT_128_TYPE: {
+        long double value;
+        ret = from->get_float128_value(value, value_id);
+        value_data = value;
+      } break;
+      case ::xtypes::TypeKind::STRING_TYPE: {
+        std::string value;
+        ret = from->get_string_value(value, value_id);
+        value_data = value;
+      } break;
+      case ::xtypes::TypeKind::WSTRING_TYPE: {
+        std::wstring value;
+        ret = from->get_wstring_value(value, value_id);
+        value_data = value;
+      } break;
+      case ::xtypes::TypeKind::ENUMERATION_TYPE: {
+        uint32_t value;
+        ret = from->get_enum_value(value, value_id);
+        value_data = value;
+      } break;
+      case ::xtypes::TypeKind::ARRAY_TYPE: {
+        DynamicData* array = from->loan_value(value_id);
+        ::xtypes::DynamicData xtypes_array(value_type);
+        set_array_data(array, xtypes_array.ref(), std::vector<uint32_t>(), lengths);
+        from->return_loaned_value(array);
+        value_data = xtypes_array;
+        ret = ResponseCode::RETCODE_OK;
+        break;
+      }
+      case ::xtypes::TypeKind::SEQUENCE_TYPE: {
+        DynamicData* seq = from->loan_value(value_id);
+        ::xtypes::DynamicData xtypes_seq(value_type);
+        set_sequence_data(seq, xtypes_seq.ref(), lengths);
+        from->return_loaned_value(seq);
+        value_data = xtypes_seq;
+        ret = ResponseCode::RETCODE_OK;
+        break;
+      }
+      case ::xtypes::TypeKind::MAP_TYPE: {
+        DynamicData* seq = from->loan_value(value_id);
+        ::xtypes::DynamicData xtypes_map(value_type);
+        set_map_data(seq, xtypes_map.ref(), lengths);
+        from->return_loaned_value(seq);
+        value_data = xtypes_map;
+        ret = ResponseCode::RETCODE_OK;
+        break;
+      }
+      case ::xtypes::TypeKind::STRUCTURE_TYPE: {
+        DynamicData* st = from->loan_value(value_id);
+        ::xtypes::DynamicData xtypes_st(value_type);
+        set_struct_data(st, xtypes_st.ref(), lengths);
+        from->return_loaned_value(st);
+        value_data = xtypes_st;
+        ret = ResponseCode::RETCODE_OK;
+        break;
+      }
+      case ::xtypes::TypeKind::UNION_TYPE: {
+        DynamicData* st = from->loan_value(value_id);
+        ::xtypes::DynamicData xtypes_union(value_type);
+        set_union_data(st, xtypes_union.ref(), lengths);
+        from->return_loaned_value(st);
+        value_data = xtypes_union;
+        ret = ResponseCode::RETCODE_OK;
+        break;
+      }
+      default: {
+        /*logger_ << utils::Logger::Level::ERROR
+                          << "Unexpected data type: '" << value_type.name() << "'" << std::endl;*/
+      }
+      }
 
-    // Value
-    switch (resolve_type(value_type).kind()) {
-    case ::xtypes::TypeKind::BOOLEAN_TYPE: {
-      bool value;
-      ret = from->get_bool_value(value, value_id);
-      value_data = value;
-    } break;
-    case ::xtypes::TypeKind::CHAR_8_TYPE: {
-      char value;
-      ret = from->get_char8_value(value, value_id);
-      value_data = value;
-    } break;
-    case ::xtypes::TypeKind::CHAR_16_TYPE:
-    case ::xtypes::TypeKind::WIDE_CHAR_TYPE: {
-      wchar_t value;
-      ret = from->get_char16_value(value, value_id);
-      value_data = value;
-    } break;
-    case ::xtypes::TypeKind::UINT_8_TYPE: {
-      uint8_t value;
-      ret = from->get_uint8_value(value, value_id);
-      value_data = value;
-    } break;
-    case ::xtypes::TypeKind::INT_8_TYPE: {
-      int8_t value;
-      ret = from->get_int8_value(value, value_id);
-      value_data = value;
-    } break;
-    case ::xtypes::TypeKind::INT_16_TYPE: {
-      int16_t value;
-      ret = from->get_int16_value(value, value_id);
-      value_data = value;
-    } break;
-    case ::xtypes::TypeKind::UINT_16_TYPE: {
-      uint16_t value;
-      ret = from->get_uint16_value(value, value_id);
-      value_data = value;
-    } break;
-    case ::xtypes::TypeKind::INT_32_TYPE: {
-      int32_t value;
-      ret = from->get_int32_value(value, value_id);
-      value_data = value;
-    } break;
-    case ::xtypes::TypeKind::UINT_32_TYPE: {
-      uint32_t value;
-      ret = from->get_uint32_value(value, value_id);
-      value_data = value;
-    } break;
-    case ::xtypes::TypeKind::INT_64_TYPE: {
-      int64_t value;
-      ret = from->get_int64_value(value, value_id);
-      value_data = value;
-    } break;
-    case ::xtypes::TypeKind::UINT_64_TYPE: {
-      uint64_t value;
-      ret = from->get_uint64_value(value, value_id);
-      value_data = value;
-    } break;
-    case ::xtypes::TypeKind::FLOAT_32_TYPE: {
-      float value;
-      ret = from->get_float32_value(value, value_id);
-      value_data = value;
-    } break;
-    case ::xtypes::TypeKind::FLOAT_64_TYPE: {
-      double value;
-      ret = from->get_float64_value(value, value_id);
-      value_data = value;
-    } break;
-    case ::xtypes::TypeKind::FLOAT_128_TYPE: {
-      long double value;
-      ret = from->get_float128_value(value, value_id);
-      value_data = value;
-    } break;
-    case ::xtypes::TypeKind::STRING_TYPE: {
-      std::string value;
-      ret = from->get_string_value(value, value_id);
-      value_data = value;
-    } break;
-    case ::xtypes::TypeKind::WSTRING_TYPE: {
-      std::wstring value;
-      ret = from->get_wstring_value(value, value_id);
-      value_data = value;
-    } break;
-    case ::xtypes::TypeKind::ENUMERATION_TYPE: {
-      uint32_t value;
-      ret = from->get_enum_value(value, value_id);
-      value_data = value;
-    } break;
-    case ::xtypes::TypeKind::ARRAY_TYPE: {
-      DynamicData* array = from->loan_value(value_id);
-      ::xtypes::DynamicData xtypes_array(value_type);
-      set_array_data(array, xtypes_array.ref(), std::vector<uint32_t>());
-      from->return_loaned_value(array);
-      value_data = xtypes_array;
-      ret = ResponseCode::RETCODE_OK;
-      break;
-    }
-    case ::xtypes::TypeKind::SEQUENCE_TYPE: {
-      DynamicData* seq = from->loan_value(value_id);
-      ::xtypes::DynamicData xtypes_seq(value_type);
-      set_sequence_data(seq, xtypes_seq.ref());
-      from->return_loaned_value(seq);
-      value_data = xtypes_seq;
-      ret = ResponseCode::RETCODE_OK;
-      break;
-    }
-    case ::xtypes::TypeKind::MAP_TYPE: {
-      DynamicData* seq = from->loan_value(value_id);
-      ::xtypes::DynamicData xtypes_map(value_type);
-      set_map_data(seq, xtypes_map.ref());
-      from->return_loaned_value(seq);
-      value_data = xtypes_map;
-      ret = ResponseCode::RETCODE_OK;
-      break;
-    }
-    case ::xtypes::TypeKind::STRUCTURE_TYPE: {
-      DynamicData* st = from->loan_value(value_id);
-      ::xtypes::DynamicData xtypes_st(value_type);
-      set_struct_data(st, xtypes_st.ref());
-      from->return_loaned_value(st);
-      value_data = xtypes_st;
-      ret = ResponseCode::RETCODE_OK;
-      break;
-    }
-    case ::xtypes::TypeKind::UNION_TYPE: {
-      DynamicData* st = from->loan_value(value_id);
-      ::xtypes::DynamicData xtypes_union(value_type);
-      set_union_data(st, xtypes_union.ref());
-      from->return_loaned_value(st);
-      value_data = xtypes_union;
-      ret = ResponseCode::RETCODE_OK;
-      break;
-    }
-    default: {
-      /*logger_ << utils::Logger::Level::ERROR
-                        << "Unexpected data type: '" << value_type.name() << "'" << std::endl;*/
-    }
-    }
+      if (ret != ResponseCode::RETCODE_OK) {
+        /*logger_ << utils::Logger::Level::ERROR
+                      << "Error parsing from dynamic type '" << to.type().name() << "'"
+                      << std::endl;*/
+      }
 
-    if (ret != ResponseCode::RETCODE_OK) {
-      /*logger_ << utils::Logger::Level::ERROR
-                    << "Error parsing from dynamic type '" << to.type().name() << "'" << std::endl;*/
+      // Add entry
+      to[key_data] = value_data;
     }
 
-    // Add entry
-    to[key_data] = value_data;
+    if (rebuild || to.size() == count) { break; }
+    rebuild = true;
   }
 }
 
 void Converter::set_array_data(
   const DynamicData* c_from, eprosima::xtypes::WritableDynamicDataRef to,
-  const std::vector<uint32_t>& indexes) {
+  const std::vector<uint32_t>& indexes, const SequenceLengths* lengths) {
+  DynamicData* from = const_cast<DynamicData*>(c_from);
+
+  // Arrays of primitives are copied in one pass, starting from the outermost dimension
+  if (indexes.empty() && set_primitive_array(from, to)) { return; }
+
   const ::xtypes::ArrayType& type = static_cast<const ::xtypes::ArrayType&>(to.type());
   const ::xtypes::DynamicType& inner_type = type.content_type();
-  DynamicData* from = const_cast<DynamicData*>(c_from);
   MemberId id;
 
+  std::vector<uint32_t> new_indexes = indexes;
+  new_indexes.push_back(0);
   for (uint32_t idx = 0; idx < type.dimension(); ++idx) {
-    std::vector<uint32_t> new_indexes = indexes;
-    new_indexes.push_back(idx);
+    new_indexes.back() = idx;
     ResponseCode ret = ResponseCode::RETCODE_ERROR;
     switch (resolve_type(inner_type).kind()) {
     case ::xtypes::TypeKind::BOOLEAN_TYPE: {
@@ -1264,9 +1624,7 @@ void Converter::set_array_data(
       to[idx].value<uint32_t>(value);
     } break;
     case ::xtypes::TypeKind::ARRAY_TYPE: {
-      ::xtypes::DynamicData xtypes_array(type.content_type());
-      set_array_data(from, xtypes_array.ref(), new_indexes);
-      to[idx] = xtypes_array;
+      set_array_data(from, to[idx], new_indexes, lengths);
       ret = ResponseCode::RETCODE_OK;
       break;
     }
@@ -1274,7 +1632,7 @@ void Converter::set_array_data(
       id = from->get_array_index(new_indexes);
       DynamicData* seq = from->loan_value(id);
       ::xtypes::DynamicData xtypes_seq(type.content_type());
-      set_sequence_data(seq, xtypes_seq.ref());
+      set_sequence_data(seq, xtypes_seq.ref(), lengths);
       from->return_loaned_value(seq);
       to[idx] = xtypes_seq;
       ret = ResponseCode::RETCODE_OK;
@@ -1284,7 +1642,7 @@ void Converter::set_array_data(
       id = from->get_array_index(new_indexes);
       DynamicData* seq = from->loan_value(id);
       ::xtypes::DynamicData xtypes_map(type.content_type());
-      set_map_data(seq, xtypes_map.ref());
+      set_map_data(seq, xtypes_map.ref(), lengths);
       from->return_loaned_value(seq);
       to[idx] = xtypes_map;
       ret = ResponseCode::RETCODE_OK;
@@ -1294,7 +1652,7 @@ void Converter::set_array_data(
       id = from->get_array_index(new_indexes);
       DynamicData* st = from->loan_value(id);
       ::xtypes::DynamicData xtypes_st(type.content_type());
-      set_struct_data(st, xtypes_st.ref());
+      set_struct_data(st, xtypes_st.ref(), lengths);
       from->return_loaned_value(st);
       to[idx] = xtypes_st;
       ret = ResponseCode::RETCODE_OK;
@@ -1304,7 +1662,7 @@ void Converter::set_array_data(
       id = from->get_array_index(new_indexes);
       DynamicData* st = from->loan_value(id);
       ::xtypes::DynamicData xtypes_union(type.content_type());
-      set_union_data(st, xtypes_union.ref());
+      set_union_data(st, xtypes_union.ref(), lengths);
       from->return_loaned_value(st);
       to[idx] = xtypes_union;
       ret = ResponseCode::RETCODE_OK;
@@ -1324,11 +1682,13 @@ void Converter::set_array_data(
 }
 
 // TODO: Can we receive a type without members as root?
-bool Converter::fastdds_to_xtypes(const DynamicData* c_input, ::xtypes::DynamicData& output) {
+bool Converter::fastdds_to_xtypes(
+  const DynamicData* c_input, ::xtypes::WritableDynamicDataRef& output,
+  const SequenceLengths* lengths) {
   if (output.type().kind() == ::xtypes::TypeKind::STRUCTURE_TYPE) {
-    return set_struct_data(c_input, output.ref());
+    return set_struct_data(c_input, output.ref(), lengths);
   } else if (output.type().kind() == ::xtypes::TypeKind::UNION_TYPE) {
-    return set_union_data(c_input, output.ref());
+    return set_union_data(c_input, output.ref(), lengths);
   }
 
   /*logger_ << utils::Logger::Level::ERROR
@@ -1347,8 +1707,8 @@ eprosima::fastrtps::types::TypeKind
 }
 
 bool Converter::set_struct_data(
-  const DynamicData* c_input, eprosima::xtypes::WritableDynamicDataRef output) {
-  std::stringstream ss;
+  const DynamicData* c_input, eprosima::xtypes::WritableDynamicDataRef output,
+  const SequenceLengths* lengths) {
   uint32_t id = 0;
   uint32_t i = 0;
   eprosima::fastrtps::types::MemberDescriptor descriptor;
@@ -1477,19 +1837,19 @@ bool Converter::set_struct_data(
         }
         case types::TK_ARRAY: {
           DynamicData* array = input->loan_value(id);
-          set_array_data(array, output[descriptor.get_name()], std::vector<uint32_t>());
+          set_array_data(array, output[descriptor.get_name()], std::vector<uint32_t>(), lengths);
           input->return_loaned_value(array);
           break;
         }
         case types::TK_SEQUENCE: {
           DynamicData* seq = input->loan_value(id);
-          set_sequence_data(seq, output[descriptor.get_name()]);
+          set_sequence_data(seq, output[descriptor.get_name()], lengths);
           input->return_loaned_value(seq);
           break;
         }
         case types::TK_MAP: {
           DynamicData* seq = input->loan_value(id);
-          set_map_data(seq, output[descriptor.get_name()]);
+          set_map_data(seq, output[descriptor.get_name()], lengths);
           input->return_loaned_value(seq);
           break;
         }
@@ -1497,7 +1857,7 @@ bool Converter::set_struct_data(
           DynamicData* nested_msg_dds = input->loan_value(id);
 
           if (nested_msg_dds != nullptr) {
-            if (set_struct_data(nested_msg_dds, output[descriptor.get_name()])) {
+            if (set_struct_data(nested_msg_dds, output[descriptor.get_name()], lengths)) {
               ret = ResponseCode::RETCODE_OK;
             }
             input->return_loaned_value(nested_msg_dds);
@@ -1508,7 +1868,7 @@ bool Converter::set_struct_data(
           DynamicData* nested_msg_dds = input->loan_value(id);
 
           if (nested_msg_dds != nullptr) {
-            if (set_union_data(nested_msg_dds, output[descriptor.get_name()])) {
+            if (set_union_data(nested_msg_dds, output[descriptor.get_name()], lengths)) {
               ret = ResponseCode::RETCODE_OK;
             }
             input->return_loaned_value(nested_msg_dds);
@@ -1536,8 +1896,8 @@ bool Converter::set_struct_data(
 }
 
 bool Converter::set_union_data(
-  const DynamicData* c_input, eprosima::xtypes::WritableDynamicDataRef output) {
-  std::stringstream ss;
+  const DynamicData* c_input, eprosima::xtypes::WritableDynamicDataRef output,
+  const SequenceLengths* lengths) {
   eprosima::fastrtps::types::MemberDescriptor descriptor;
 
   // We promise to not modify it, but we need it non-const, so we can call loan_value freely.
@@ -1652,19 +2012,19 @@ bool Converter::set_union_data(
     }
     case types::TK_ARRAY: {
       DynamicData* array = input->loan_value(id);
-      set_array_data(array, output[descriptor.get_name()], std::vector<uint32_t>());
+      set_array_data(array, output[descriptor.get_name()], std::vector<uint32_t>(), lengths);
       input->return_loaned_value(array);
       break;
     }
     case types::TK_SEQUENCE: {
       DynamicData* seq = input->loan_value(id);
-      set_sequence_data(seq, output[descriptor.get_name()]);
+      set_sequence_data(seq, output[descriptor.get_name()], lengths);
       input->return_loaned_value(seq);
       break;
     }
     case types::TK_MAP: {
       DynamicData* seq = input->loan_value(id);
-      set_map_data(seq, output[descriptor.get_name()]);
+      set_map_data(seq, output[descriptor.get_name()], lengths);
       input->return_loaned_value(seq);
       break;
     }
@@ -1672,7 +2032,7 @@ bool Converter::set_union_data(
       DynamicData* nested_msg_dds = input->loan_value(id);
 
       if (nested_msg_dds != nullptr) {
-        if (set_struct_data(nested_msg_dds, output[descriptor.get_name()])) {
+        if (set_struct_data(nested_msg_dds, output[descriptor.get_name()], lengths)) {
           ret = ResponseCode::RETCODE_OK;
         }
         input->return_loaned_value(nested_msg_dds);
@@ -1683,7 +2043,7 @@ bool Converter::set_union_data(
       DynamicData* nested_msg_dds = input->loan_value(id);
 
       if (nested_msg_dds != nullptr) {
-        if (set_union_data(nested_msg_dds, output[descriptor.get_name()])) {
+        if (set_union_data(nested_msg_dds, output[descriptor.get_name()], lengths)) {
           ret = ResponseCode::RETCODE_OK;
         }
         input->return_loaned_value(nested_msg_dds);
@@ -4,7 +4,11 @@
  * Copyright 2019 - present Proyectos y Sistemas de Mantenimiento SL (eProsima).
  *
  * This implementation is based on https://github.com/eProsima/FastDDS-SH/blob/main/src/Conversion.hpp
- * There are no functional changes done in dds-fmu, only changing namespace and formatting.
+ * Modifications in dds-fmu, besides namespace and formatting:
+ * - Conversions take xtypes data references, such that data stores of an arena are converted.
+ * - Bounded sequences of data stores are kept at their bound, with lengths passed per call.
+ * - Arrays of primitives are copied in one pass.
+ * - Elements of sequences and maps of primitives are reused between samples.
  *
  * Licensed under the Apache License, Version 2.0 (the "License");
  *
@@ -12,6 +16,8 @@
  *
  */
 
+#include <cstddef>
+#include <cstdint>
 #include <map>
 #include <vector>
 
@@ -29,6 +35,18 @@ namespace ddsfmu {
    @brief Class with functions to convert between xtypes::DynamicData and fast-dds DynamicData
 */
 struct Converter {
+  /**
+     @brief Lengths of bounded sequences kept at their bound, by sequence instance
+
+     Bounded sequences mapped to FMU variables are kept at their bound in the data store,
+     such that their elements never move. Their length is kept separately by the DataMapper
+     that owns the data store: only the first `length` elements are converted to fast-dds,
+     and received samples are converted in place, updating the length. Elements beyond the
+     length keep their previous values. Instances are given by
+     xtypes::ReadableDynamicDataRef::instance_id().
+  */
+  typedef std::map<std::size_t, std::uint32_t*> SequenceLengths;
+
   /**
        @brief Converts from xtypes to fastdds DynamicData
 
@@ -37,10 +55,12 @@ struct Converter {
 
        @param [in] input xtypes DynamicData reference
        @param [out] output fastdds DynamicData pointer
+       @param [in] lengths Lengths of bounded sequences of the input, or nullptr
        @return Boolean on result of operation
     */
   static bool xtypes_to_fastdds(
-    const eprosima::xtypes::DynamicData& input, eprosima::fastrtps::types::DynamicData* output);
+    const eprosima::xtypes::ReadableDynamicDataRef& input,
+    eprosima::fastrtps::types::DynamicData* output, const SequenceLengths* lengths = nullptr);
 
   /**
        @brief Converts from fastdds to xtypes DynamicData
@@ -50,10 +70,13 @@ struct Converter {
 
        @param [in] input fastdds DynamicData pointer
        @param [out] output xtypes DynamicData reference
+       @param [in] lengths Lengths of bounded sequences of the output, which are updated, or
+       nullptr
        @return Boolean on result of operation
     */
   static bool fastdds_to_xtypes(
-    const eprosima::fastrtps::types::DynamicData* input, eprosima::xtypes::DynamicData& output);
+    const eprosima::fastrtps::types::DynamicData* input,
+    eprosima::xtypes::WritableDynamicDataRef& output, const SequenceLengths* lengths = nullptr);
 
   /**
        @brief  Retrieve a dynamic data instance given type name
@@ -164,6 +187,13 @@ private:
   static std::map<std::string, eprosima::fastrtps::types::DynamicPubSubType*> m_registered_types;
   static std::map<std::string, eprosima::fastrtps::types::DynamicTypeBuilder_ptr> m_builders;
 
+  /// Length of a sequence instance kept at its bound, or nullptr
+  static std::uint32_t* sequence_length(const SequenceLengths* lengths, std::size_t instance) {
+    if (!lengths) { return nullptr; }
+    auto found = lengths->find(instance);
+    return found == lengths->end() ? nullptr : found->second;
+  }
+
   static const eprosima::xtypes::DynamicType&
     resolve_type(const eprosima::xtypes::DynamicType& type);
   static eprosima::fastrtps::types::TypeKind
@@ -171,6 +201,46 @@ private:
   static eprosima::fastrtps::types::DynamicTypeBuilder_ptr
     get_builder(const eprosima::xtypes::DynamicType& type);
 
+  /// Whether elements of a type are copied by set_primitive_values() and get_primitive_values()
+  static bool is_primitive_element(const eprosima::xtypes::DynamicType& type);
+
+  /// Element type of an array of primitives or enumerations of any dimensions, or nullptr
+  static const eprosima::xtypes::DynamicType*
+    primitive_array_element(const eprosima::xtypes::DynamicType& type);
+
+  /**
+     @brief Copies contiguous xtypes primitives to fast-dds elements with consecutive ids
+
+     @param [in] element Resolved element type
+     @param [in] data Memory of the first element
+     @param [in] count Number of elements
+     @param [in] to fast-dds array or sequence, which already has the elements
+     @param [in] first Member id of the first element
+     @return False if the element type is not supported, and nothing was copied
+  */
+  static bool set_primitive_values(
+    const eprosima::xtypes::DynamicType& element, const std::uint8_t* data, std::size_t count,
+    eprosima::fastrtps::types::DynamicData* to, eprosima::fastrtps::types::MemberId first);
+
+  /// Copies fast-dds elements with consecutive ids to contiguous xtypes primitives
+  static bool get_primitive_values(
+    eprosima::fastrtps::types::DynamicData* from, eprosima::fastrtps::types::MemberId first,
+    const eprosima::xtypes::DynamicType& element, std::uint8_t* data, std::size_t count);
+
+  /**
+     @brief Copies all elements of an array of primitives in one pass over its memory
+
+     xtypes arrays of primitives are contiguous in row-major order, which is also the order
+     of the flat member ids of fast-dds arrays. Elements of different width, i.e. wide
+     characters, are converted element-wise.
+
+     @return False if the array is not an array of primitives, and nothing was copied
+  */
+  static bool set_primitive_array(
+    eprosima::xtypes::ReadableDynamicDataRef from, eprosima::fastrtps::types::DynamicData* to);
+  static bool set_primitive_array(
+    eprosima::fastrtps::types::DynamicData* from, eprosima::xtypes::WritableDynamicDataRef to);
+
   static void get_array_specs(
     const eprosima::xtypes::ArrayType& array,
     std::pair<std::vector<uint32_t>, eprosima::fastrtps::types::DynamicTypeBuilder_ptr>& result);
@@ -184,34 +254,38 @@ private:
     eprosima::xtypes::ReadableDynamicDataRef from, eprosima::fastrtps::types::DynamicData* to,
     eprosima::fastrtps::types::MemberId id);
   static void set_sequence_data(
-    eprosima::xtypes::ReadableDynamicDataRef from, eprosima::fastrtps::types::DynamicData* to);
+    eprosima::xtypes::ReadableDynamicDataRef from, eprosima::fastrtps::types::DynamicData* to,
+    const SequenceLengths* lengths);
   static void set_map_data(
-    eprosima::xtypes::ReadableDynamicDataRef from, eprosima::fastrtps::types::DynamicData* to);
+    eprosima::xtypes::ReadableDynamicDataRef from, eprosima::fastrtps::types::DynamicData* to,
+    const SequenceLengths* lengths);
   static void set_array_data(
     eprosima::xtypes::ReadableDynamicDataRef from, eprosima::fastrtps::types::DynamicData* to,
-    const std::vector<uint32_t>& indexes);
+    const std::vector<uint32_t>& indexes, const SequenceLengths* lengths);
   static bool set_struct_data(
-    eprosima::xtypes::ReadableDynamicDataRef input, eprosima::fastrtps::types::DynamicData* output);
+    eprosima::xtypes::ReadableDynamicDataRef input, eprosima::fastrtps::types::DynamicData* output,
+    const SequenceLengths* lengths);
   static bool set_union_data(
-    eprosima::xtypes::ReadableDynamicDataRef input, eprosima::fastrtps::types::DynamicData* output);
+    eprosima::xtypes::ReadableDynamicDataRef input, eprosima::fastrtps::types::DynamicData* output,
+    const SequenceLengths* lengths);
 
 
   // FastDDS Dynamic Data -> xtypes Dynamic Data
   static void set_sequence_data(
     const eprosima::fastrtps::types::DynamicData* from,
-    eprosima::xtypes::WritableDynamicDataRef to);
+    eprosima::xtypes::WritableDynamicDataRef to, const SequenceLengths* lengths);
   static void set_map_data(
     const eprosima::fastrtps::types::DynamicData* from,
-    eprosima::xtypes::WritableDynamicDataRef to);
+    eprosima::xtypes::WritableDynamicDataRef to, const SequenceLengths* lengths);
   static void set_array_data(
     const eprosima::fastrtps::types::DynamicData* from, eprosima::xtypes::WritableDynamicDataRef to,
-    const std::vector<uint32_t>& indexes);
+    const std::vector<uint32_t>& indexes, const SequenceLengths* lengths);
   static bool set_struct_data(
     const eprosima::fastrtps::types::DynamicData* input,
-    eprosima::xtypes::WritableDynamicDataRef output);
+    eprosima::xtypes::WritableDynamicDataRef output, const SequenceLengths* lengths);
   static bool set_union_data(
     const eprosima::fastrtps::types::DynamicData* input,
-    eprosima::xtypes::WritableDynamicDataRef output);
+    eprosima::xtypes::WritableDynamicDataRef output, const SequenceLengths* lengths);
 };
 
 }
@@ -16,14 +16,18 @@ namespace detail {
     if (std::string(parameters[0]) == "|GUID UNKNOWN|") {
       return false;
     } else {
-      auto a_member = member_types.insert_or_assign(
-        parameters[0], std::make_unique<FilterMemberType>(data_type, type_name));
+      // Key values of an already registered reader are updated in place
+      auto a_member = member_types.find(parameters[0]);
+      if (a_member == member_types.end()) {
+        auto new_member = std::make_unique<FilterMemberType>(data_type, type_name);
+        a_member = member_types.emplace(parameters[0], std::move(new_member)).first;
+      }
 
       // parameters[key_member] must be cast from std::string to member type
       std::int32_t key_member = 1;
 
       std::ostringstream oss;
-      a_member.first->second->key_data.for_each(
+      a_member->second->key_data.for_each(
         [&](eprosima::xtypes::DynamicData::WritableNode& node) {
           bool is_leaf = (node.type().is_primitive_type() || node.type().is_enumerated_type());
           bool is_string = node.type().kind() == eprosima::xtypes::TypeKind::STRING_TYPE;
@@ -98,7 +102,7 @@ namespace detail {
             }
           }
         });
-      a_member.first->second->key_count = key_member - 1;
+      a_member->second->key_count = key_member - 1;
       //std::cout << oss.str();
     }
     return true;
@@ -107,6 +111,9 @@ namespace detail {
   bool CustomKeyFilter::evaluate(
     const SerializedPayload& payload, const FilterSampleInfo&,
     const GUID_t& reader_guid) const {
+    DDSFMU_TRACE_SCOPE(
+      "filter.evaluate", m_trace_instance.load(std::memory_order_relaxed),
+      m_trace_topic.load(std::memory_order_relaxed));
     std::ostringstream guid;
     guid << reader_guid; // The only useful identifier for a data reader
 
@@ -133,7 +140,13 @@ namespace detail {
         bool ok_conversion =
           ddsfmu::Converter::fastdds_to_xtypes(member_type->dyn_data, member_type->sample_data);
         if (!ok_conversion) { return false; }
-        return member_type->compare_keys(); // Key comparison is done here
+        bool accepted = member_type->compare_keys(); // Key comparison is done here
+        if (!accepted) { m_rejected.fetch_add(1, std::memory_order_relaxed); }
+        DDSFMU_TRACE_INSTANT(
+          accepted ? "filter.accept" : "filter.reject",
+          m_trace_instance.load(std::memory_order_relaxed),
+          m_trace_topic.load(std::memory_order_relaxed));
+        return accepted;
       }
 
     } catch (const std::out_of_range& e) {
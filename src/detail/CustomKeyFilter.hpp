@@ -7,6 +7,8 @@
   file, You can obtain one at http://mozilla.org/MPL/2.0/.
 */
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
@@ -20,6 +22,7 @@
 #include <xtypes/xtypes.hpp>
 
 #include "Converter.hpp"
+#include "Tracer.hpp"
 
 namespace ddsfmu {
 namespace detail {
@@ -99,6 +102,9 @@ struct FilterMemberType {
 class CustomKeyFilter : public eprosima::fastdds::dds::IContentFilter {
 private:
   std::map<std::string, std::unique_ptr<FilterMemberType>> member_types;
+  mutable std::atomic<std::uint64_t> m_rejected{0}; ///< Samples with non-matching keys
+  std::atomic<std::uint32_t> m_trace_instance{TraceEvent::NoInstance}; ///< Of trace events
+  std::atomic<std::uint32_t> m_trace_topic{TraceEvent::NoTopic}; ///< Topic id of trace events
 
 public:
   /**
@@ -121,13 +127,15 @@ public:
      @param [in] guid Reader GUID
      @return Boolean whether it is registered or not
   */
-  inline bool has_reader_GUID(const std::string& guid) {
+  inline bool has_reader_GUID(const std::string& guid) const {
     return static_cast<bool>(member_types.count(guid));
   }
 
   /**
      @brief Registers a new data type with associated dynamic data type pointer
 
+     If the reader GUID is already registered, only its key values are updated.
+
      @param [in] data_type Dynamic data type to be registered
      @param [in] type_name Name of type to be registered
      @param [in] parameters List of string parameters [Reader GUID | "|GUID UNKNOWN|", key1, .., keyN]
@@ -150,6 +158,26 @@ public:
   bool evaluate(
     const SerializedPayload& payload, const FilterSampleInfo& sample_info,
     const GUID_t& reader_guid) const override;
+
+  /**
+     @brief Number of samples rejected due to non-matching keys
+
+     Evaluation runs on fast-dds threads, so the count is atomic.
+
+     @return Total number of rejected samples since construction
+  */
+  inline std::uint64_t rejected() const { return m_rejected.load(std::memory_order_relaxed); }
+
+  /**
+     @brief Sets the instance and topic identifiers of filter events in the trace, see Tracer
+
+     @param [in] instance Identifier of the DynamicPubSub in the trace
+     @param [in] topic Data store index of the reader
+  */
+  inline void set_trace_topic(std::uint32_t instance, std::uint32_t topic) {
+    m_trace_instance.store(instance, std::memory_order_relaxed);
+    m_trace_topic.store(topic, std::memory_order_relaxed);
+  }
 };
 
 }
@@ -7,6 +7,7 @@
   file, You can obtain one at http://mozilla.org/MPL/2.0/.
 */
 
+#include <set>
 #include <string>
 
 #include <fastdds/dds/topic/IContentFilter.hpp>
@@ -34,7 +35,7 @@ public:
     @brief Create a ContentFilteredTopic using this factory.
 
     Updating the filter will not delete the old one. Once a reader is added, it cannot be
-    removed.
+    removed, but its key values are updated with new filter parameters.
 
     @param filter_class_name Custom filter name
     @param type_name Data type name
@@ -63,6 +64,7 @@ public:
     if (filter_instance == nullptr) {
       try {
         filter_instance = new CustomKeyFilter(data_type, type_name, filter_parameters);
+        m_filters.insert(dynamic_cast<CustomKeyFilter*>(filter_instance));
       } catch (const std::runtime_error& err) {
         std::cerr << err.what() << std::endl;
         return ReturnCode_t::RETCODE_BAD_PARAMETER;
@@ -73,10 +75,8 @@ public:
       try {
         CustomKeyFilter* instance = dynamic_cast<CustomKeyFilter*>(filter_instance);
 
-        // Only adds a reader once. Once added, changing filter_parameters has not effect
-        if (!instance->has_reader_GUID(filter_parameters[0])) {
-          instance->add_type(data_type, type_name, filter_parameters);
-        }
+        // Adds the reader once, subsequent calls update its key values
+        instance->add_type(data_type, type_name, filter_parameters);
       } catch (const std::runtime_error& err) {
         std::cerr << err.what() << std::endl;
         return ReturnCode_t::RETCODE_BAD_PARAMETER;
@@ -104,9 +104,27 @@ public:
       return ReturnCode_t::RETCODE_BAD_PARAMETER;
     }
 
-    delete (dynamic_cast<CustomKeyFilter*>(filter_instance));
+    auto* instance = dynamic_cast<CustomKeyFilter*>(filter_instance);
+    m_filters.erase(instance);
+    delete instance;
     return ReturnCode_t::RETCODE_OK;
   }
+
+  /**
+     @brief Finds the filter instance that a reader has been registered with
+
+     @param [in] reader_guid GUID of the DataReader as string
+     @return Pointer to filter instance, or nullptr if the reader is not registered
+  */
+  CustomKeyFilter* find_filter(const std::string& reader_guid) const {
+    for (auto* filter : m_filters) {
+      if (filter->has_reader_GUID(reader_guid)) { return filter; }
+    }
+    return nullptr;
+  }
+
+private:
+  std::set<CustomKeyFilter*> m_filters; ///< Instances created and not yet deleted
 };
 
 }
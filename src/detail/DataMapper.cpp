@@ -7,16 +7,146 @@
 
 #include "DataMapper.hpp"
 
+#include <algorithm>
+#include <cstring>
 #include <functional>
+#include <string>
 #include <vector>
 
 #include <rapidxml/rapidxml.hpp>
 
+#include "Converter.hpp"
 #include "SignalDistributor.hpp" // resolve_type
 #include "model-descriptor.hpp"
 
 namespace ddsfmu {
 
+namespace {
+
+  void save_instance(
+    std::vector<std::uint8_t>& state, const eprosima::xtypes::ReadableDynamicDataRef& data) {
+    namespace ex = eprosima::xtypes;
+    const ex::DynamicType& type = data.type();
+
+    if (detail::is_plain_type(type)) {
+      detail::append_bytes(
+        state, reinterpret_cast<const std::uint8_t*>(data.instance_id()), type.memory_size());
+      return;
+    }
+
+    switch (type.kind()) {
+    case ex::TypeKind::STRING_TYPE: {
+      const std::string& str = data.value<std::string>();
+      detail::append_value(state, static_cast<std::uint32_t>(str.size()));
+      detail::append_bytes(state, str.data(), str.size());
+      break;
+    }
+    case ex::TypeKind::WSTRING_TYPE: {
+      const std::wstring& str = data.value<std::wstring>();
+      detail::append_value(state, static_cast<std::uint32_t>(str.size()));
+      detail::append_bytes(state, str.data(), str.size() * sizeof(wchar_t));
+      break;
+    }
+    case ex::TypeKind::ARRAY_TYPE:
+      for (std::size_t i = 0; i < data.size(); ++i) { save_instance(state, data[i]); }
+      break;
+    case ex::TypeKind::SEQUENCE_TYPE:
+      detail::append_value(state, static_cast<std::uint32_t>(data.size()));
+      for (std::size_t i = 0; i < data.size(); ++i) { save_instance(state, data[i]); }
+      break;
+    case ex::TypeKind::STRUCTURE_TYPE:
+      for (const ex::Member& member : static_cast<const ex::StructType&>(type).members()) {
+        save_instance(state, data[member.name()]);
+      }
+      break;
+    default: break; // maps and unions are not mapped to FMU variables
+    }
+  }
+
+  void load_instance(detail::StateReader& state, eprosima::xtypes::WritableDynamicDataRef data) {
+    namespace ex = eprosima::xtypes;
+    const ex::DynamicType& type = data.type();
+
+    if (detail::is_plain_type(type)) {
+      std::memcpy(
+        reinterpret_cast<std::uint8_t*>(data.instance_id()), state.take(type.memory_size()),
+        type.memory_size());
+      return;
+    }
+
+    switch (type.kind()) {
+    case ex::TypeKind::STRING_TYPE: {
+      const auto length = state.read<std::uint32_t>();
+      const auto* chars = reinterpret_cast<const char*>(state.take(length));
+      data.value<std::string>(std::string(chars, length));
+      break;
+    }
+    case ex::TypeKind::WSTRING_TYPE: {
+      const auto length = state.read<std::uint32_t>();
+      std::wstring str(length, L'\0');
+      std::memcpy(str.data(), state.take(length * sizeof(wchar_t)), length * sizeof(wchar_t));
+      data.value<std::wstring>(str);
+      break;
+    }
+    case ex::TypeKind::ARRAY_TYPE:
+      for (std::size_t i = 0; i < data.size(); ++i) { load_instance(state, data[i]); }
+      break;
+    case ex::TypeKind::SEQUENCE_TYPE: {
+      const auto length = state.read<std::uint32_t>();
+      data.resize(length);
+      for (std::size_t i = 0; i < length; ++i) { load_instance(state, data[i]); }
+      break;
+    }
+    case ex::TypeKind::STRUCTURE_TYPE:
+      for (const ex::Member& member : static_cast<const ex::StructType&>(type).members()) {
+        load_instance(state, data[member.name()]);
+      }
+      break;
+    default: break;
+    }
+  }
+
+  /// Advances the reader past an instance as written by save_instance(), checking its lengths
+  void check_instance(detail::StateReader& state, const eprosima::xtypes::DynamicType& type) {
+    namespace ex = eprosima::xtypes;
+
+    if (detail::is_plain_type(type)) {
+      state.take(type.memory_size());
+      return;
+    }
+
+    switch (type.kind()) {
+    case ex::TypeKind::STRING_TYPE: state.take(state.read<std::uint32_t>()); break;
+    case ex::TypeKind::WSTRING_TYPE:
+      state.take(state.read<std::uint32_t>() * sizeof(wchar_t));
+      break;
+    case ex::TypeKind::ARRAY_TYPE: {
+      const auto& array = static_cast<const ex::ArrayType&>(type);
+      for (std::size_t i = 0; i < array.dimension(); ++i) {
+        check_instance(state, array.content_type());
+      }
+      break;
+    }
+    case ex::TypeKind::SEQUENCE_TYPE: {
+      const auto& sequence = static_cast<const ex::SequenceType&>(type);
+      const auto length = state.read<std::uint32_t>();
+      if (sequence.bounds() > 0 && length > sequence.bounds()) {
+        throw std::runtime_error("FMU state exceeds the bound of a sequence");
+      }
+      for (std::size_t i = 0; i < length; ++i) { check_instance(state, sequence.content_type()); }
+      break;
+    }
+    case ex::TypeKind::STRUCTURE_TYPE:
+      for (const ex::Member& member : static_cast<const ex::StructType&>(type).members()) {
+        check_instance(state, member.type());
+      }
+      break;
+    default: break;
+    }
+  }
+
+}
+
 void DataMapper::clear() {
   m_int_writer.clear();
   m_int_reader.clear();
@@ -24,9 +154,22 @@ void DataMapper::clear() {
   m_real_reader.clear();
   m_bool_writer.clear();
   m_bool_reader.clear();
-  m_string_writer.clear();
-  m_string_reader.clear();
-  m_data_store.clear();
+  m_strings.clear();
+  m_sequence_instances.clear();
+  m_sequence_lengths.clear();
+  m_sequence_bounds.clear();
+  m_real_owner.clear();
+  m_int_owner.clear();
+  m_bool_owner.clear();
+  m_string_owner.clear();
+  m_interpolated.clear();
+  m_interpolated_index.clear();
+  m_arena.clear();
+  m_diagnostics_type.reset();
+  m_diagnostics_topics.clear();
+  m_offsets.clear();
+  m_store_index.clear();
+  m_store_keys.clear();
   m_int_offset = 0;
   m_real_offset = 0;
   m_bool_offset = 0;
@@ -49,6 +192,8 @@ void DataMapper::reset(const std::filesystem::path& fmu_resources) {
     throw std::runtime_error("<ddsfmu> not found in ddsfmu_mapping.xml");
   }
 
+  std::vector<std::pair<std::size_t, detail::Interpolation>> interpolations;
+
   auto mapper_iterator = [&](DataMapper::Direction direction) {
     std::string node_name;
     switch (direction) {
@@ -77,12 +222,15 @@ void DataMapper::reset(const std::filesystem::path& fmu_resources) {
       std::string topic_name(topic->value());
       std::string topic_type(type->value());
       bool do_key_filtering = false;
+      auto interpolation = fmu_node->first_attribute("interpolation");
 
       if (direction == DataMapper::Direction::Read) {
         auto key_filter = fmu_node->first_attribute("key_filter");
         if (key_filter) {
           std::istringstream(key_filter->value()) >> std::boolalpha >> do_key_filtering;
         }
+      } else if (interpolation) {
+        throw std::runtime_error("<ddsfmu><fmu_in> does not support attribute 'interpolation'");
       }
 
       if (!m_context.module().has_structure(topic_type)) {
@@ -94,13 +242,168 @@ void DataMapper::reset(const std::filesystem::path& fmu_resources) {
       if (direction == DataMapper::Direction::Read && do_key_filtering) {
         queue_for_key_parameter(topic_name, topic_type);
       }
+      if (interpolation) {
+        interpolations.emplace_back(
+          store_index(topic_name, direction), detail::parse_interpolation(interpolation->value()));
+      }
     }
   };
 
-  mapper_iterator(DataMapper::Direction::Read);  // outputs
+  mapper_iterator(DataMapper::Direction::Read); // outputs
+
+  // Diagnostics are outputs, so they precede inputs as in the model description
+  bool diagnostics = false;
+  auto diagnostics_attribute = mapper_ddsfmu->first_attribute("diagnostics");
+  if (diagnostics_attribute) {
+    std::istringstream(diagnostics_attribute->value()) >> std::boolalpha >> diagnostics;
+  }
+  if (diagnostics) {
+    for (const auto& key : m_store_keys) { m_diagnostics_topics.push_back(std::get<0>(key)); }
+    m_diagnostics_type = std::make_unique<eprosima::xtypes::StructType>(
+      detail::diagnostics_type(m_diagnostics_topics));
+
+    DataMapper::StoreKey key = std::make_tuple(DiagnosticsName, Direction::Diagnostics);
+    m_store_index.emplace(key, m_arena.add(*m_diagnostics_type));
+    m_store_keys.push_back(key);
+  }
+
   mapper_iterator(DataMapper::Direction::Write); // inputs
 
   process_key_queue(); // parameters
+
+  allocate();
+
+  for (const auto& interpolation : interpolations) {
+    add_interpolator(interpolation.first, interpolation.second);
+  }
+}
+
+void DataMapper::soft_reset() {
+  // Instances are reconstructed in place, such that visitors remain valid
+  m_arena.reset_defaults();
+  for (auto& str : m_strings) { str.reserve(); }
+  for (auto& length : m_sequence_lengths) { length = 0; }
+  reset_interpolators();
+}
+
+void DataMapper::save_state(std::vector<std::uint8_t>& state) const {
+  detail::append_value(state, static_cast<std::uint32_t>(m_arena.size()));
+
+  if (m_arena.is_plain()) {
+    // All data stores are copied as one block
+    detail::append_value(state, static_cast<std::uint64_t>(m_arena.bytes()));
+    detail::append_bytes(state, m_arena.data(), m_arena.bytes());
+    return;
+  }
+
+  for (std::size_t store = 0; store < m_arena.size(); ++store) {
+    // Store length is written once the store has been serialized
+    const std::size_t length_position = state.size();
+    detail::append_value(state, std::uint64_t{0});
+    save_instance(state, m_arena[store]);
+
+    const std::uint64_t length = state.size() - length_position - sizeof(std::uint64_t);
+    std::memcpy(state.data() + length_position, &length, sizeof(length));
+  }
+
+  // Bounded sequences are stored at their bound, their lengths are kept separately
+  detail::append_value(state, static_cast<std::uint32_t>(m_sequence_lengths.size()));
+  for (auto length : m_sequence_lengths) { detail::append_value(state, length); }
+}
+
+void DataMapper::load_state(detail::StateReader& state) {
+  // The whole state is checked before any data store is modified
+  detail::StateReader checked = state;
+  read_state(checked, false);
+  read_state(state, true);
+  reset_interpolators();
+}
+
+void DataMapper::read_state(detail::StateReader& state, bool apply) {
+  if (state.read<std::uint32_t>() != m_arena.size()) {
+    throw std::runtime_error("FMU state does not match the number of data stores");
+  }
+
+  if (m_arena.is_plain()) {
+    if (state.read<std::uint64_t>() != m_arena.bytes()) {
+      throw std::runtime_error("FMU state does not match the size of data stores");
+    }
+    const auto* bytes = state.take(m_arena.bytes());
+    if (apply) { std::memcpy(m_arena.data(), bytes, m_arena.bytes()); }
+    return;
+  }
+
+  for (std::size_t store = 0; store < m_arena.size(); ++store) {
+    auto& data = m_arena[store];
+    const auto length = state.read<std::uint64_t>();
+    const std::size_t begin = state.offset();
+    const std::string& topic = std::get<0>(m_store_keys.at(store));
+
+    if (detail::is_plain_type(data.type()) && length != data.type().memory_size()) {
+      throw std::runtime_error("FMU state does not match data store of: " + topic);
+    }
+
+    if (apply) {
+      load_instance(state, data.ref());
+    } else {
+      check_instance(state, data.type());
+    }
+
+    if (state.offset() - begin != length) {
+      throw std::runtime_error("FMU state does not match data store of: " + topic);
+    }
+  }
+
+  if (state.read<std::uint32_t>() != m_sequence_lengths.size()) {
+    throw std::runtime_error("FMU state does not match the number of sequences");
+  }
+  for (std::size_t i = 0; i < m_sequence_lengths.size(); ++i) {
+    const auto length = state.read<std::uint32_t>();
+    if (apply) { m_sequence_lengths[i] = std::min(length, m_sequence_bounds[i]); }
+  }
+}
+
+void DataMapper::sample_taken(std::size_t store, double time) {
+  if (store >= m_interpolated_index.size() || m_interpolated_index[store] == NoInterpolation) {
+    return;
+  }
+  auto& interpolated = m_interpolated[m_interpolated_index[store]];
+  double* values = interpolated.interpolator.sample(time);
+  for (std::size_t i = 0; i < interpolated.sources.size(); ++i) {
+    interpolated.sources[i](values[i]);
+  }
+}
+
+void DataMapper::interpolate(double time) {
+  for (auto& interpolated : m_interpolated) { interpolated.interpolator.evaluate(time); }
+}
+
+void DataMapper::reset_interpolators() {
+  for (auto& interpolated : m_interpolated) {
+    interpolated.interpolator.clear();
+    double* output = interpolated.interpolator.output();
+    for (std::size_t i = 0; i < interpolated.sources.size(); ++i) {
+      interpolated.sources[i](output[i]);
+    }
+  }
+}
+
+void DataMapper::add_interpolator(std::size_t store, detail::Interpolation mode) {
+  // Real variables of a data store have consecutive value references
+  const auto first = static_cast<std::size_t>(std::get<0>(m_offsets.at(store)));
+  std::size_t end = first;
+  while (end < m_real_owner.size() && m_real_owner[end] == store) { ++end; }
+
+  m_interpolated_index.at(store) = m_interpolated.size();
+  auto& interpolated = m_interpolated.emplace_back(mode, end - first);
+
+  // The output keeps its address when m_interpolated grows
+  double* output = interpolated.interpolator.output();
+  for (std::size_t i = 0; i < end - first; ++i) {
+    interpolated.sources.push_back(std::move(m_real_reader[first + i]));
+    interpolated.sources.back()(output[i]);
+    m_real_reader[first + i] = [value = output + i](double& out) { out = *value; };
+  }
 }
 
 void DataMapper::process_key_queue() {
@@ -110,14 +413,23 @@ void DataMapper::process_key_queue() {
   }
 }
 
+std::size_t
+  DataMapper::owner(config::ScalarVariableType fmi_type, const std::int32_t value_ref) const {
+  switch (fmi_type) {
+  case config::ScalarVariableType::Real: return m_real_owner.at(value_ref);
+  case config::ScalarVariableType::Integer: return m_int_owner.at(value_ref);
+  case config::ScalarVariableType::Boolean: return m_bool_owner.at(value_ref);
+  case config::ScalarVariableType::String: return m_string_owner.at(value_ref);
+  default: throw std::logic_error("Value reference owner requested for unknown FMI type");
+  }
+}
+
 void DataMapper::add(
   const std::string& topic_name, const std::string& topic_type, Direction read_write_param) {
   const eprosima::xtypes::DynamicType& message_type(m_context.module().structure(topic_type));
   DataMapper::StoreKey key = std::make_tuple(topic_name, read_write_param);
 
-  auto item = m_data_store.emplace(key, eprosima::xtypes::DynamicData(message_type));
-
-  if (!item.second) {
+  if (m_store_index.count(key)) {
     std::string dir;
     switch (read_write_param) {
     case DataMapper::Direction::Write: dir = "input"; break;
@@ -131,13 +443,27 @@ void DataMapper::add(
       + dir);
   }
 
-  auto& dyn_data = (*item.first).second;
+  // Instances are constructed by allocate(), once all data stores are known
+  m_store_index.emplace(key, m_arena.add(message_type));
+  m_store_keys.push_back(key);
+}
+
+void DataMapper::allocate() {
+  m_arena.allocate();
+  for (std::size_t store = 0; store < m_arena.size(); ++store) { add_visitors(store); }
+  m_interpolated_index.assign(m_arena.size(), NoInterpolation);
+}
+
+void DataMapper::add_visitors(std::size_t store) {
+  const DataMapper::StoreKey& key = m_store_keys.at(store);
+  const Direction read_write_param = std::get<1>(key);
+  auto& dyn_data = m_arena[store];
 
   // We use reader indexes, they are identical to writers in this fmu
   DataMapper::IndexOffsets idx_value = std::make_tuple(
     static_cast<int32_t>(m_real_reader.size()), static_cast<int32_t>(m_int_reader.size()),
-    static_cast<int32_t>(m_bool_reader.size()), static_cast<int32_t>(m_string_reader.size()));
-  m_offsets.emplace(key, idx_value);
+    static_cast<int32_t>(m_bool_reader.size()), static_cast<int32_t>(m_strings.size()));
+  m_offsets.push_back(idx_value);
 
   // switch on type kind must be identical to the one in SignalDistributor
 
@@ -168,6 +494,21 @@ void DataMapper::add(
     bool is_a_key_parameter = is_leaf_or_string && !is_not_parameter
                               && (node.from_member() && node.from_member()->is_key());
 
+    if (is_not_parameter && detail::is_bounded_sequence(node.type())) {
+      // The sequence is kept at its bound, its length is an Integer variable of its own
+      const auto bound = static_cast<std::int32_t>(node.data().size());
+      std::uint32_t* length = &m_sequence_lengths.emplace_back(0u);
+      m_sequence_bounds.push_back(static_cast<std::uint32_t>(bound));
+      m_sequence_instances.emplace(node.data().instance_id(), length);
+
+      m_int_writer.emplace_back([length, bound](const std::int32_t& in) {
+        *length = static_cast<std::uint32_t>(std::clamp(in, 0, bound));
+      });
+      m_int_reader.emplace_back(
+        [length](std::int32_t& out) { out = static_cast<std::int32_t>(*length); });
+      return;
+    }
+
     if ((is_leaf_or_string && is_not_parameter) || is_a_key_parameter) {
       auto fmi_type = SignalDistributor::resolve_type(node);
 
@@ -272,16 +613,8 @@ void DataMapper::add(
       case ddsfmu::config::ScalarVariableType::String:
         switch (node.type().kind()) {
         case eprosima::xtypes::TypeKind::STRING_TYPE:
-          m_string_writer.emplace_back(std::bind(
-            detail::writer_visitor<std::string, std::string>, std::placeholders::_1, node.data()));
-          m_string_reader.emplace_back(std::bind(
-            detail::reader_visitor<std::string, std::string>, std::placeholders::_1, node.data()));
-          break;
         case eprosima::xtypes::TypeKind::CHAR_8_TYPE:
-          m_string_writer.emplace_back(std::bind(
-            detail::writer_visitor<std::string, char>, std::placeholders::_1, node.data()));
-          m_string_reader.emplace_back(std::bind(
-            detail::reader_visitor<std::string, char>, std::placeholders::_1, node.data()));
+          m_strings.emplace_back(node.data());
           break;
         default: break;
         }
@@ -290,6 +623,11 @@ void DataMapper::add(
       }
     }
   });
+
+  m_real_owner.resize(m_real_reader.size(), store);
+  m_int_owner.resize(m_int_reader.size(), store);
+  m_bool_owner.resize(m_bool_reader.size(), store);
+  m_string_owner.resize(m_strings.size(), store);
 }
 
 }
@@ -7,15 +7,25 @@
   file, You can obtain one at http://mozilla.org/MPL/2.0/.
 */
 
+#include <deque>
 #include <filesystem>
+#include <functional>
 #include <map>
+#include <memory>
 #include <queue>
 #include <string>
 #include <tuple>
+#include <vector>
 
 #include <xtypes/DynamicData.hpp>
 #include <xtypes/idl/idl.hpp>
 
+#include "Converter.hpp"
+#include "Interpolator.hpp"
+#include "StateBuffer.hpp"
+#include "StepDiagnostics.hpp"
+#include "StoreArena.hpp"
+#include "model-descriptor.hpp"
 #include "visitors.hpp"
 
 namespace ddsfmu {
@@ -26,9 +36,13 @@ namespace ddsfmu {
    Types defined in IDL is mapped onto four FMU types, namely: Real, Integer, Boolean and
    String. Integer types with more than 32 bits are mapped to Real. The primitive types:
    uint32_t, int64_t, and uint64_t are all mapped to Real. Enumerations are mapped to
-   Integer. All data are stored in xtypes::DynamicData. Each data member of DynamicData is
-   directly written to or read from using visitor functions, which use references. The
-   visitor functions are called from specialized setters and getters:
+   Integer. All data are stored as xtypes instances in one contiguous detail::StoreArena,
+   which is allocated once all topics are known. Each data member is directly written to or
+   read from using visitor functions, which use references. Bounded sequences are kept at
+   their bound, such that each element is a variable, and have an Integer variable
+   `[sequence].length` for the number of elements that are published or were received.
+   Unbounded sequences are not mapped. The visitor functions are called from specialized
+   setters and getters:
 
    set_double(), get_double(), set_int(), get_int(), set_bool(), get_bool(), set_string(), get_string()
 
@@ -42,7 +56,8 @@ public:
   enum class Direction {
     Read,     ///< Read from DDS, FMU output
     Write,    ///< Write to DDS, FMU input
-    Parameter ///< Used for Read content filter of \@key
+    Parameter,  ///< Used for Read content filter of \@key
+    Diagnostics ///< Timing and counters of each step, FMU output
   };
 
   /**
@@ -56,6 +71,7 @@ public:
   DataMapper() = default;
   DataMapper(const DataMapper&) = delete;            ///< Copy constructor
   DataMapper& operator=(const DataMapper&) = delete; ///< Copy assignment
+  ~DataMapper() { clear(); }                         ///< Unregisters sequence lengths
 
   /**
      @brief Clears and repopulates internal data structures
@@ -67,6 +83,41 @@ public:
   */
   void reset(const std::filesystem::path& fmu_resources);
 
+  /**
+     @brief Resets all data stores to default values
+
+     Unlike reset(), configuration files are not reloaded. The data stores are assigned
+     default values in place, such that visitors and references to them remain valid.
+  */
+  void soft_reset();
+
+  /**
+     @brief Appends the values of all data stores to a state buffer
+
+     Each data store is written as its byte length followed by its values. Trivially
+     copyable types, such as structures of primitives and arrays, are copied as a single
+     block of memory. If all data stores are trivially copyable, the whole arena is copied
+     as one block. Strings and sequences are prefixed with their length. Maps and unions
+     cannot be mapped to FMU variables and are not part of the state. The lengths of
+     bounded sequences follow the data stores.
+
+     @param [in, out] state Buffer to append to, see detail::append_value()
+  */
+  void save_state(std::vector<std::uint8_t>& state) const;
+
+  /**
+     @brief Restores the values of all data stores from a state buffer
+
+     The state must have been saved by an instance with identical configuration.
+     Throws std::runtime_error if the state does not match the data stores, in which case
+     no data store is modified. Lengths of bounded sequences are clamped to their bound.
+     Samples of interpolated outputs are discarded, such that outputs are those of the
+     restored stores.
+
+     @param [in, out] state Reader positioned at the data store values
+  */
+  void load_state(detail::StateReader& state);
+
   inline void set_double(const std::int32_t value_ref, const double& value) {
     m_real_writer.at(value_ref)(value);
   }
@@ -86,25 +137,119 @@ public:
     m_bool_reader.at(value_ref)(value);
   }
   inline void set_string(const std::int32_t value_ref, const std::string& value) {
-    m_string_writer.at(value_ref)(value);
+    m_strings.at(value_ref).set(value.data(), value.size());
   }
   inline void get_string(const std::int32_t value_ref, std::string& value) const {
-    m_string_reader.at(value_ref)(value);
+    value = m_strings.at(value_ref).get();
   }
 
-  inline eprosima::xtypes::DynamicData& data_ref(const std::string& topic, Direction read_write_param) {
-    return m_data_store.at(std::make_tuple(topic, read_write_param));
+  /**
+     @brief Sets a String variable without temporary copies
+
+     @param [in] value_ref Value reference of String variable
+     @param [in] value Null-terminated string
+  */
+  inline void set_string(const std::int32_t value_ref, const char* value) {
+    m_strings.at(value_ref).set(value);
+  }
+
+  /**
+     @brief Gets a String variable without copying
+
+     @param [in] value_ref Value reference of String variable
+     @return Null-terminated string, valid until the variable is set or a sample is taken
+  */
+  inline const char* get_string(const std::int32_t value_ref) const {
+    return m_strings.at(value_ref).get();
+  }
+
+  inline eprosima::xtypes::WritableDynamicDataRef&
+    data_ref(const std::string& topic, Direction read_write_param) {
+    return m_arena[store_index(topic, read_write_param)];
   }
-  inline const eprosima::xtypes::DynamicData&
+  inline const eprosima::xtypes::WritableDynamicDataRef&
     data_ref(const std::string& topic, Direction read_write_param) const {
-    return m_data_store.at(std::make_tuple(topic, read_write_param));
+    return m_arena[store_index(topic, read_write_param)];
+  }
+  /// Data store by index, see store_index()
+  inline eprosima::xtypes::WritableDynamicDataRef& data_ref(std::size_t store) {
+    return m_arena[store];
   }
+  inline std::size_t store_count() const { return m_arena.size(); } ///< Number of data stores
 
   inline eprosima::xtypes::idl::Context& idl_context() { return m_context; }
 
+  /// True if `diagnostics="true"` on `<ddsfmu>`, see detail::diagnostics_type()
+  inline bool has_diagnostics() const { return static_cast<bool>(m_diagnostics_type); }
+
+  /// FMU output topics with diagnostics counters, in order of their data store indices
+  inline const std::vector<std::string>& diagnostics_topics() const {
+    return m_diagnostics_topics;
+  }
+
+  /// Data store of diagnostics, throws std::out_of_range if diagnostics are disabled
+  inline eprosima::xtypes::WritableDynamicDataRef& diagnostics_ref() {
+    return data_ref(DiagnosticsName, Direction::Diagnostics);
+  }
+
   inline IndexOffsets index_offsets(const std::string& topic, Direction read_write_param) const {
     // We have the same number of readers and writers, so the same index applies to both
-    return m_offsets.at(std::make_tuple(topic, read_write_param));
+    return m_offsets.at(store_index(topic, read_write_param));
+  }
+  /// Index offsets of data store by index, see store_index()
+  inline IndexOffsets index_offsets(std::size_t store) const { return m_offsets.at(store); }
+
+  /**
+     @brief Index of the data store associated with topic and direction
+
+     Data stores are enumerated densely in the order they are added during reset(). Use the
+     index for repeated access, such that topic names need not be compared.
+
+     @param [in] topic Topic name
+     @param [in] read_write_param Direction of the data store
+     @return Index of the data store
+  */
+  inline std::size_t store_index(const std::string& topic, Direction read_write_param) const {
+    return m_store_index.at(std::make_tuple(topic, read_write_param));
+  }
+
+  /**
+     @brief Index of the data store that owns a value reference
+
+     This relates an FMI setter or getter call to the topic it accesses.
+
+     @param [in] fmi_type FMI type of the value reference
+     @param [in] value_ref Value reference
+     @return Index of the data store, see store_index()
+  */
+  std::size_t owner(config::ScalarVariableType fmi_type, const std::int32_t value_ref) const;
+
+  /**
+     @brief Records the Real variables of a data store after a sample was taken into it
+
+     Does nothing unless `interpolation` is set on the `<fmu_out>` of the data store.
+
+     @param [in] store Index of data store, see store_index()
+     @param [in] time Simulation time of the sample
+  */
+  void sample_taken(std::size_t store, double time);
+
+  /**
+     @brief Evaluates interpolated Real FMU outputs at a simulation time
+
+     Getters of Real variables of data stores with `interpolation` on their `<fmu_out>`
+     return the evaluated values, while the data stores keep the received samples.
+
+     @param [in] time Simulation time, usually the end of the step
+  */
+  void interpolate(double time);
+
+  /// True if any FMU output has interpolation
+  inline bool has_interpolation() const { return !m_interpolated.empty(); }
+
+  /// Lengths of bounded sequences of the data stores, to pass to the Converter
+  inline const Converter::SequenceLengths& sequence_lengths() const {
+    return m_sequence_instances;
   }
 
   inline void queue_for_key_parameter(const std::string& topic_name, const std::string& topic_type){
@@ -114,11 +259,29 @@ public:
   void process_key_queue();
 
 private:
+  static constexpr const char* DiagnosticsName = "diag"; ///< Name of diagnostics data store
   typedef std::tuple<std::string, Direction> StoreKey;
   void add(const std::string& topic_name, const std::string& topic_type, Direction read_write_param);
+  void allocate(); ///< Constructs all added data stores and their visitors
+  void add_visitors(std::size_t store); ///< Registers visitors for members of a data store
+  /// Redirects Real getters of a data store to an interpolator
+  void add_interpolator(std::size_t store, detail::Interpolation mode);
+  void reset_interpolators(); ///< Discards samples, outputs are those of the data stores
+  /// Reads a state saved by save_state(), writing to the data stores only if apply is true
+  void read_state(detail::StateReader& state, bool apply);
+
+  /// Interpolated Real variables of a data store
+  struct Interpolated {
+    Interpolated(detail::Interpolation mode, std::size_t signals)
+        : interpolator(mode, signals) {}
+    detail::Interpolator interpolator;
+    std::vector<std::function<void(double&)>> sources; ///< Getters of the data store
+  };
   void clear(); ///< Clears internal data structures
   std::int32_t m_int_offset, m_real_offset, m_bool_offset, m_string_offset;
-  std::map<StoreKey, IndexOffsets> m_offsets;
+  std::vector<IndexOffsets> m_offsets; ///< Offsets by data store index
+  std::map<StoreKey, std::size_t> m_store_index;
+  std::vector<StoreKey> m_store_keys; ///< Keys by data store index
   std::queue<std::pair<std::string, std::string>> m_potential_keys;
   std::vector<std::function<void(const std::int32_t&)>> m_int_writer;
   std::vector<std::function<void(std::int32_t&)>> m_int_reader;
@@ -126,10 +289,18 @@ private:
   std::vector<std::function<void(double&)>> m_real_reader;
   std::vector<std::function<void(const bool&)>> m_bool_writer;
   std::vector<std::function<void(bool&)>> m_bool_reader;
-  std::vector<std::function<void(const std::string&)>> m_string_writer;
-  std::vector<std::function<void(std::string&)>> m_string_reader;
-  std::map<StoreKey, eprosima::xtypes::DynamicData> m_data_store;
+  std::vector<detail::StringVariable> m_strings;
+  std::deque<std::uint32_t> m_sequence_lengths; ///< Of bounded sequences, stable addresses
+  Converter::SequenceLengths m_sequence_instances; ///< Lengths above by sequence instance
+  std::vector<std::uint32_t> m_sequence_bounds; ///< Bounds of the lengths above
+  std::vector<std::size_t> m_real_owner, m_int_owner, m_bool_owner, m_string_owner;
+  std::vector<Interpolated> m_interpolated;
+  std::vector<std::size_t> m_interpolated_index; ///< By data store index, or NoInterpolation
+  static constexpr std::size_t NoInterpolation = static_cast<std::size_t>(-1);
   eprosima::xtypes::idl::Context m_context;
+  std::unique_ptr<eprosima::xtypes::StructType> m_diagnostics_type; ///< Or nullptr if disabled
+  std::vector<std::string> m_diagnostics_topics;
+  detail::StoreArena m_arena; ///< Instances of types above, declared after them
 };
 
 }
@@ -7,31 +7,153 @@
 
 #include "DynamicPubSub.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <optional>
 #include <sstream>
 #include <string>
 #include <tuple>
 #include <vector>
 
 #include <cppfmu_common.hpp>
+#include <fastdds/dds/common/InstanceHandle.hpp>
 #include <fastdds/dds/core/policy/QosPolicies.hpp>
 #include <fastdds/dds/domain/DomainParticipantFactory.hpp>
+#include <fastdds/dds/domain/qos/DomainParticipantQos.hpp>
 #include <fastdds/dds/log/Log.hpp>
 #include <fastdds/dds/publisher/qos/DataWriterQos.hpp>
 #include <fastdds/dds/publisher/qos/PublisherQos.hpp>
 #include <fastdds/dds/subscriber/qos/DataReaderQos.hpp>
 #include <fastdds/dds/subscriber/qos/SubscriberQos.hpp>
+#include <fastdds/rtps/transport/UDPv4TransportDescriptor.h>
+#include <fastdds/rtps/transport/shared_mem/SharedMemTransportDescriptor.h>
+#include <fastrtps/attributes/ParticipantAttributes.h>
+#include <fastrtps/common/Time_t.h>
+#include <fastrtps/rtps/resources/ResourceManagement.h>
 #include <fastrtps/types/DynamicDataFactory.h>
 #include <fastrtps/types/DynamicPubSubType.h>
 #include <fastrtps/types/DynamicTypeBuilder.h>
+#include <fastrtps/types/DynamicTypeBuilderFactory.h>
 #include <fastrtps/types/DynamicTypePtr.h>
 #include <fastrtps/xmlparser/XMLProfileManager.h>
 
 #include "Converter.hpp"
 #include "LoggerAdapters.hpp"
+#include "Tracer.hpp"
 #include "model-descriptor.hpp"
+#include "qos-profiles.hpp"
 
 namespace ddsfmu {
 
+namespace {
+
+  /**
+     @brief Preallocates the history of a DataWriter or DataReader for bounded samples
+
+     The payload pool of the PREALLOCATED memory policy is sized by the type support, see
+     DynamicPubSub::create_entities(). Samples of a KEEP_LAST history of an unkeyed topic
+     never exceed the history depth, such that only that many are allocated up front.
+     Memory policies other than the default PREALLOCATED_WITH_REALLOC are kept as chosen
+     in the profile.
+
+     @param [in,out] qos QoS of the entity
+     @param [in] max_size Maximum serialized size of the type, or std::nullopt if unbounded
+     @param [in] keyed Whether the type has key members
+  */
+  template <typename EntityQos>
+  void preallocate_history(EntityQos& qos, std::optional<std::size_t> max_size, bool keyed) {
+    namespace rtps = eprosima::fastrtps::rtps;
+    if (!max_size) { return; }
+
+    auto& policy = qos.endpoint().history_memory_policy;
+    if (policy == rtps::PREALLOCATED_WITH_REALLOC_MEMORY_MODE) {
+      policy = rtps::PREALLOCATED_MEMORY_MODE;
+    }
+
+    auto& limits = qos.resource_limits();
+    if (
+      !keyed && qos.history().kind == eprosima::fastdds::dds::KEEP_LAST_HISTORY_QOS
+      && qos.history().depth > 0) {
+      limits.allocated_samples = qos.history().depth;
+      limits.max_samples_per_instance =
+        std::max(limits.max_samples_per_instance, qos.history().depth);
+      if (limits.max_samples > 0) {
+        limits.max_samples = std::max(limits.max_samples, qos.history().depth);
+      }
+    }
+  }
+
+  /// Transports of the DomainParticipant, see the attribute `transport` of `<ddsfmu>`
+  enum class Transport {
+    Profile, ///< As in the participant profile, by default builtin UDPv4 and shared memory
+    Local,   ///< Shared memory sized for the mapped types, with UDPv4 fallback
+    UDPv4    ///< UDPv4 only
+  };
+
+  Transport parse_transport(const std::string& value) {
+    if (value == "profile") { return Transport::Profile; }
+    if (value == "local") { return Transport::Local; }
+    if (value == "udpv4") { return Transport::UDPv4; }
+    throw std::runtime_error(
+      "<ddsfmu> attribute 'transport' must be 'profile', 'local' or 'udpv4'");
+  }
+
+  /**
+     @brief Shared memory segment size of a participant
+
+     Samples sent over shared memory are copied to buffers in the segment of the sending
+     participant, which are released once all readers have processed them. The segment
+     holds a number of samples of each written topic in flight, with their RTPS headers, and
+     is at least the default of fast-dds, which covers discovery traffic.
+
+     @param [in] sample_sizes Maximum serialized size of each written topic, or std::nullopt
+     if unbounded
+     @return Segment size in bytes
+  */
+  std::uint32_t shm_segment_size(const std::vector<std::optional<std::size_t>>& sample_sizes) {
+    constexpr std::size_t DefaultSegment = 512 * 1024;
+    constexpr std::size_t SamplesInFlight = 16;
+    constexpr std::size_t RtpsOverhead = 256;
+    constexpr std::size_t UnboundedSample = 64 * 1024; ///< Largest UDP datagram, roughly
+    constexpr std::size_t MaxSegment = std::numeric_limits<std::uint32_t>::max();
+
+    std::size_t segment = 0;
+    for (const auto& size : sample_sizes) {
+      segment += SamplesInFlight * (size.value_or(UnboundedSample) + RtpsOverhead);
+    }
+    return static_cast<std::uint32_t>(std::clamp(segment, DefaultSegment, MaxSegment));
+  }
+
+  /**
+     @brief Replaces the transports of a participant
+
+     @param [in,out] qos QoS of the participant
+     @param [in] transport Local or UDPv4
+     @param [in] localhost_only Whether UDPv4 is restricted to the loopback interface
+     @param [in] segment_size Shared memory segment size, see shm_segment_size()
+  */
+  void configure_transports(
+    eprosima::fastdds::dds::DomainParticipantQos& qos, Transport transport, bool localhost_only,
+    std::uint32_t segment_size) {
+    namespace rtps = eprosima::fastdds::rtps;
+    qos.transport().use_builtin_transports = false;
+    qos.transport().user_transports.clear();
+
+    // Fast-dds prefers shared memory for peers on the same host, others are reached by UDP
+    if (transport == Transport::Local) {
+      auto shm = std::make_shared<rtps::SharedMemTransportDescriptor>();
+      shm->segment_size(segment_size);
+      qos.transport().user_transports.push_back(shm);
+    }
+
+    auto udp = std::make_shared<rtps::UDPv4TransportDescriptor>();
+    if (localhost_only) { udp->interfaceWhiteList.emplace_back("127.0.0.1"); }
+    qos.transport().user_transports.push_back(udp);
+  }
+
+}
+
 //typedef eprosima::fastdds::dds::QosPolicyId_t PolicyID;
 const std::map<uint32_t /*eprosima::fastdds::dds::QosPolicyId_t*/, std::string>
   DomainListener::QosPolicyString{
@@ -78,13 +200,87 @@ DynamicPubSub::DynamicPubSub()
     , m_subscriber(nullptr)
     , m_publisher(nullptr)
     , m_data_mapper(nullptr)
-    , m_xml_loaded(false) {}
+    , m_xml_loaded(false)
+    , m_pending_count(0)
+    , m_simulation_stamps(false)
+    , m_async_publish(false)
+    , m_step_writer(nullptr)
+    , m_step_count(0)
+    , m_diagnostics(nullptr)
+    , m_trace_instance(detail::TraceEvent::NoInstance) {}
+
+void DynamicPubSub::write(std::optional<double> time) {
+  using Phase = detail::StepDiagnostics::Phase;
+
+  for (std::size_t i = 0; i < m_writers.size(); ++i) {
+    if (time && m_writer_periods[i] > 0.0) {
+      // Resume from the current time after time moved backwards, e.g. to a restored FMU state
+      if (m_writer_due[i] - m_writer_periods[i] > *time + PeriodTolerance) {
+        m_writer_due[i] = *time;
+      }
+      // Decimated topics are neither converted nor published before they are due
+      if (*time < m_writer_due[i] - PeriodTolerance) { continue; }
+      m_writer_due[i] += m_writer_periods[i];
+      // Resume from the current time after jumps, instead of publishing in each step
+      if (m_writer_due[i] <= *time) { m_writer_due[i] = *time + m_writer_periods[i]; }
+    }
 
-void DynamicPubSub::write() {
-  for (auto& writes : m_write_data) {
-    ddsfmu::Converter::xtypes_to_fastdds(writes.second.first, writes.second.second.get());
-    writes.first->write(static_cast<void*>(writes.second.second.get()));
+    DDSFMU_TRACE_SCOPE("write", m_trace_instance, m_writer_stores[i]);
+    {
+      DDSFMU_TRACE_SCOPE("convert", m_trace_instance, m_writer_stores[i]);
+      if (m_diagnostics) {
+        const auto begin = detail::StepDiagnostics::ticks();
+        ddsfmu::Converter::xtypes_to_fastdds(
+          *m_writer_data[i], m_writer_samples[i].get(), &mapper().sequence_lengths());
+        m_diagnostics->add_ticks(Phase::Convert, detail::StepDiagnostics::ticks() - begin);
+        m_diagnostics->add_bytes(
+          m_writers[i]->get_type()->getSerializedSizeProvider(m_writer_samples[i].get())());
+      } else {
+        ddsfmu::Converter::xtypes_to_fastdds(
+          *m_writer_data[i], m_writer_samples[i].get(), &mapper().sequence_lengths());
+      }
+    }
+    if (m_simulation_stamps && time) {
+      m_writers[i]->write_w_timestamp(
+        static_cast<void*>(m_writer_samples[i].get()), eprosima::fastdds::dds::HANDLE_NIL,
+        eprosima::fastrtps::Time_t(static_cast<long double>(*time)));
+    } else {
+      m_writers[i]->write(static_cast<void*>(m_writer_samples[i].get()));
+    }
+  }
+
+  if (m_step_writer) {
+    DDSFMU_TRACE_SCOPE("handshake", m_trace_instance);
+    m_step_sample->set_uint64_value(++m_step_count, 0);
+    m_step_sample->set_float64_value(time.value_or(0.0), 1);
+    if (m_simulation_stamps && time) {
+      m_step_writer->write_w_timestamp(
+        static_cast<void*>(m_step_sample.get()), eprosima::fastdds::dds::HANDLE_NIL,
+        eprosima::fastrtps::Time_t(static_cast<long double>(*time)));
+    } else {
+      m_step_writer->write(static_cast<void*>(m_step_sample.get()));
+    }
+  }
+}
+
+bool DynamicPubSub::wait(std::optional<double> time) {
+  if (!m_lockstep.enabled()) { return true; }
+  DDSFMU_TRACE_SCOPE("wait", m_trace_instance);
+
+  const bool complete = m_lockstep.wait([this, time](std::size_t reader) {
+    if (m_readers[reader]->get_unread_count() > 0) { return true; }
+    // Time aligned readers may hold a sample for the step from earlier steps
+    const auto& history = m_reader_histories[reader];
+    return time && history.enabled() && history.select(*time) != nullptr;
+  });
+
+  if (!complete) {
+    if (m_diagnostics) { m_diagnostics->add_lockstep_timeout(); }
+    EPROSIMA_LOG_WARNING(
+      DDSFMU, "Lockstep timed out after " << m_lockstep_options.timeout << " s in step "
+                                          << m_step_count);
   }
+  return complete;
 }
 
 DynamicPubSub::~DynamicPubSub() { clear(); }
@@ -94,13 +290,16 @@ void DynamicPubSub::init_key_filters() {
   // This call should also be done once we know that initialization
   // has updated parameter values with writer visitors
 
-  for (auto& [reader, filter] : m_reader_topic_filter) {
+  for (std::size_t i = 0; i < m_readers.size(); ++i) {
+    auto* filter = m_reader_filters[i];
+    if (!filter) { continue; }
+
     std::stringstream guid;
-    guid << reader->guid();
+    guid << m_readers[i]->guid();
     std::vector<std::string> new_params;
     new_params.emplace_back(guid.str()); // Reader GUID
 
-    auto parameter_data = m_filter_data.at(filter);
+    const auto& parameter_data = *m_filter_data[i];
 
     // Acquire and convert from DynamicData into string
     parameter_data.for_each([&](const eprosima::xtypes::DynamicData::ReadableNode& node) {
@@ -167,24 +366,118 @@ void DynamicPubSub::init_key_filters() {
     });
 
     filter->set_expression_parameters(new_params);
+
+    // The filter has now registered the reader GUID
+    auto* key_filter = m_filter_factory.find_filter(guid.str());
+    if (key_filter) { key_filter->set_trace_topic(m_trace_instance, m_reader_stores[i]); }
+    m_reader_key_filters[i] = key_filter;
   }
 }
 
-void DynamicPubSub::take() {
-  for (auto& reads : m_read_data) {
+void DynamicPubSub::take(std::optional<double> time) {
+  using Phase = detail::StepDiagnostics::Phase;
+
+  for (std::size_t i = 0; i < m_readers.size(); ++i) {
     auto have_data = eprosima::fastrtps::types::ReturnCode_t::RETCODE_OK;
     eprosima::fastrtps::types::ReturnCode_t exec_result = have_data;
     eprosima::fastdds::dds::SampleInfo info;
+    std::uint64_t samples = 0;
+    std::optional<double> stamp; // Simulation time of the last converted sample
+
+    if (time && m_reader_histories[i].enabled()) {
+      samples = take_aligned(i, *time);
+      exec_result = eprosima::fastrtps::types::ReturnCode_t::RETCODE_NO_DATA;
+    }
 
     while (exec_result == have_data) {
-      exec_result = reads.first->take_next_sample(reads.second.second.get(), &info);
+      DDSFMU_TRACE_SCOPE("take", m_trace_instance, m_reader_stores[i]);
+      exec_result = m_readers[i]->take_next_sample(m_reader_samples[i].get(), &info);
       if (exec_result == have_data) {
-        ddsfmu::Converter::fastdds_to_xtypes(reads.second.second.get(), reads.second.first);
+        DDSFMU_TRACE_SCOPE("convert", m_trace_instance, m_reader_stores[i]);
+        if (m_diagnostics) {
+          const auto begin = detail::StepDiagnostics::ticks();
+          ddsfmu::Converter::fastdds_to_xtypes(
+            m_reader_samples[i].get(), *m_reader_data[i], &mapper().sequence_lengths());
+          m_diagnostics->add_ticks(Phase::Convert, detail::StepDiagnostics::ticks() - begin);
+          ++samples;
+        } else {
+          ddsfmu::Converter::fastdds_to_xtypes(
+            m_reader_samples[i].get(), *m_reader_data[i], &mapper().sequence_lengths());
+        }
+        stamp = m_simulation_stamps ? static_cast<double>(info.source_timestamp.to_ns()) * 1e-9
+                                    : time.value_or(0.0);
+      }
+    }
+
+    // Samples without a simulation time stamp are taken to be received at the end of the step
+    if (time && stamp) { mapper().sample_taken(m_reader_stores[i], *stamp); }
+
+    if (m_diagnostics) {
+      m_diagnostics->add_samples(m_reader_stores[i], samples);
+      if (m_reader_key_filters[i]) {
+        m_diagnostics->set_rejects(m_reader_stores[i], m_reader_key_filters[i]->rejected());
       }
     }
   }
 }
 
+std::uint64_t DynamicPubSub::take_aligned(std::size_t reader, double time) {
+  using Phase = detail::StepDiagnostics::Phase;
+  auto& history = m_reader_histories[reader];
+  eprosima::fastdds::dds::SampleInfo info;
+  std::uint64_t samples = 0;
+
+  {
+    // All received samples are moved into the history, the oldest being overwritten if full
+    DDSFMU_TRACE_SCOPE("take", m_trace_instance, m_reader_stores[reader]);
+    while (eprosima::fastrtps::types::ReturnCode_t::RETCODE_OK
+           == m_readers[reader]->take_next_sample(history.next_slot().get(), &info)) {
+      if (!info.valid_data) { continue; }
+      history.commit(static_cast<double>(info.source_timestamp.to_ns()) * 1e-9);
+      ++samples;
+    }
+  }
+
+  const auto* selected = history.select(time);
+  if (!selected) { return samples; }
+
+  {
+    DDSFMU_TRACE_SCOPE("convert", m_trace_instance, m_reader_stores[reader]);
+    if (m_diagnostics) {
+      const auto begin = detail::StepDiagnostics::ticks();
+      ddsfmu::Converter::fastdds_to_xtypes(
+        selected->sample.get(), *m_reader_data[reader], &mapper().sequence_lengths());
+      m_diagnostics->add_ticks(Phase::Convert, detail::StepDiagnostics::ticks() - begin);
+    } else {
+      ddsfmu::Converter::fastdds_to_xtypes(
+        selected->sample.get(), *m_reader_data[reader], &mapper().sequence_lengths());
+    }
+  }
+
+  // The selected sample and older ones are no longer needed
+  const double selected_time = selected->time;
+  history.discard_through(selected_time);
+  mapper().sample_taken(m_reader_stores[reader], selected_time);
+  return samples;
+}
+
+void DynamicPubSub::soft_reset() {
+  for (std::size_t i = 0; i < m_readers.size(); ++i) {
+    eprosima::fastdds::dds::SampleInfo info;
+    while (eprosima::fastrtps::types::ReturnCode_t::RETCODE_OK
+           == m_readers[i]->take_next_sample(m_reader_samples[i].get(), &info)) {}
+  }
+  restart(0);
+
+  init_key_filters();
+}
+
+void DynamicPubSub::restart(std::uint64_t step_count) {
+  for (auto& history : m_reader_histories) { history.clear(); }
+  for (auto& due : m_writer_due) { due = -std::numeric_limits<double>::infinity(); }
+  m_step_count = step_count;
+}
+
 void DynamicPubSub::clear() {
   auto* participant_factory = eprosima::fastdds::dds::DomainParticipantFactory::get_instance();
 
@@ -192,31 +485,38 @@ void DynamicPubSub::clear() {
 
   if (m_participant) { m_participant->set_listener(nullptr); }
 
+  // Conditions of readers are detached before the readers are deleted
+  m_lockstep.clear();
+  if (m_step_writer) { m_publisher->delete_datawriter(m_step_writer); }
+  m_step_writer = nullptr;
+  m_step_sample.reset();
+  m_step_count = 0;
+
   // Clean-up old instances, if they exist
-  for (auto& item : m_write_data) {
+  for (auto* writer : m_writers) {
     // Not needed when using DynamicData_ptr
-    //eprosima::fastrtps::types::DynamicDataFactory::get_instance()->delete_data(item.second.second);
+    //eprosima::fastrtps::types::DynamicDataFactory::get_instance()->delete_data(sample);
 
-    item.first->set_listener(nullptr);
-    m_publisher->delete_datawriter(item.first);
+    writer->set_listener(nullptr);
+    m_publisher->delete_datawriter(writer);
   }
 
   if (m_publisher) { m_participant->delete_publisher(m_publisher); }
   m_publisher = nullptr;
 
-  for (auto& item : m_read_data) {
+  for (auto* reader : m_readers) {
     // Not needed when using DynamicData_ptr
-    //eprosima::fastrtps::types::DynamicDataFactory::get_instance()->delete_data(item.second.second);
-    item.first->set_listener(nullptr);
-    m_subscriber->delete_datareader(item.first);
+    //eprosima::fastrtps::types::DynamicDataFactory::get_instance()->delete_data(sample);
+    reader->set_listener(nullptr);
+    m_subscriber->delete_datareader(reader);
   }
   if (m_subscriber) { m_participant->delete_subscriber(m_subscriber); }
   m_subscriber = nullptr;
 
   for (auto& item : m_topic_name_ptr) { m_participant->delete_topic(item.second); }
 
-  for (auto& item : m_reader_topic_filter) {
-    m_participant->delete_contentfilteredtopic(item.second);
+  for (auto* filter : m_reader_filters) {
+    if (filter) { m_participant->delete_contentfilteredtopic(filter); }
   }
 
   if (m_participant) m_participant->delete_contained_entities(); // e.g filter factory
@@ -232,9 +532,22 @@ void DynamicPubSub::clear() {
   m_topic_to_type.clear();
   m_types.clear();
   m_topic_name_ptr.clear();
-  m_reader_topic_filter.clear();
-  m_write_data.clear();
-  m_read_data.clear();
+  m_writers.clear();
+  m_writer_data.clear();
+  m_writer_samples.clear();
+  m_writer_stores.clear();
+  m_writer_periods.clear();
+  m_writer_due.clear();
+  m_readers.clear();
+  m_reader_data.clear();
+  m_reader_samples.clear();
+  m_reader_filters.clear();
+  m_filter_data.clear();
+  m_reader_stores.clear();
+  m_reader_key_filters.clear();
+  m_reader_histories.clear();
+  m_pending.clear();
+  m_pending_count = 0;
 }
 
 void DynamicPubSub::reset(
@@ -242,15 +555,29 @@ void DynamicPubSub::reset(
   cppfmu::Logger* const logger) {
   clear();
   m_data_mapper = mapper_ptr;
+  if (m_trace_instance == detail::TraceEvent::NoInstance) {
+    DDSFMU_TRACE_INSTANCE(m_trace_instance, name);
+  }
 
   // Load and create new instances
 
+  // load ddsfmu mapping
+  rapidxml::xml_document<> doc;
+  std::vector<char> buffer;
+
+  ddsfmu::config::load_ddsfmu_mapping(
+    doc, fmu_resources / "config" / "dds" / "ddsfmu_mapping.xml", buffer);
+
+  auto root_node = doc.first_node("ddsfmu");
+
   if (logger) {
-    // This adds a custom FMI logger to fast-dds
-    eprosima::fastdds::dds::Log::SetVerbosity(eprosima::fastdds::dds::Log::Kind::Info);
+    // This adds a custom FMI logger to fast-dds. Entries above the most verbose configured
+    // category are not even queued by fast-dds.
+    auto log_settings = load_log_settings(root_node->first_node("logging"));
+    eprosima::fastdds::dds::Log::SetVerbosity(log_settings.max_verbosity());
     eprosima::fastdds::dds::Log::ReportFunctions(false);
     eprosima::fastdds::dds::Log::RegisterConsumer(
-      std::make_unique<ddsfmu::FmiLogger>(*logger, name));
+      std::make_unique<ddsfmu::FmiLogger>(*logger, name, log_settings));
   }
 
   if (!m_xml_loaded) {
@@ -264,15 +591,126 @@ void DynamicPubSub::reset(
       throw std::runtime_error("Unable to load DDS XML profile");
     }
 
+    // Profiles generated by the repacker from kind hints, see config::generate_qos_profiles()
+    auto generated_profiles = fmu_resources / "config" / "dds" / config::GeneratedProfiles;
+    if (
+      std::filesystem::exists(generated_profiles)
+      && eprosima::fastrtps::xmlparser::XMLP_ret::XML_OK
+           != eprosima::fastrtps::xmlparser::XMLProfileManager::loadXMLFile(
+             generated_profiles.string())) {
+      std::cerr << "Cannot load XML file " << generated_profiles << std::endl;
+      throw std::runtime_error("Unable to load generated DDS XML profile");
+    }
+
     m_xml_loaded = true;
   }
 
+  // TypeObjects generated by the repacker, such that type information is announced
+  m_type_objects = detail::TypeObjectBundle();
+  auto type_objects = fmu_resources / "config" / "dds" / detail::TypeObjectsFile;
+  if (std::filesystem::exists(type_objects)) {
+    m_type_objects = detail::TypeObjectBundle::load(type_objects);
+    m_type_objects.register_types();
+  }
+
   namespace edds = eprosima::fastdds::dds;
   namespace etypes = eprosima::fastrtps::types;
 
+  typedef std::vector<TopicSignal> SignalList;
+  SignalList fmu_signals;
+
+  // This lambda loads topic and type from <fmu_in> and <fmu_out> of <ddsfmu> the ddsfmu mapping xml
+  auto xml_loader = [&](const std::string& node_name, SignalList& signals) {
+    DynamicPubSub::PubOrSub sig_type;
+    if (node_name == "fmu_in") {
+      sig_type = DynamicPubSub::PubOrSub::PUBLISH;
+    } else {
+      sig_type = DynamicPubSub::PubOrSub::SUBSCRIBE;
+    }
+
+    for (rapidxml::xml_node<>* fmu_node = root_node->first_node(node_name.c_str()); fmu_node;
+         fmu_node = fmu_node->next_sibling(node_name.c_str())) {
+      auto topic = fmu_node->first_attribute("topic");
+      auto type = fmu_node->first_attribute("type");
+      if (!topic || !type) {
+        std::cerr << "<ddsfmu><" << node_name
+                  << "> must specify attributes 'topic' and 'type' Got 'topic': " << std::boolalpha
+                  << (topic != nullptr) << " and 'type': " << std::boolalpha << (type != nullptr)
+                  << std::endl;
+        throw std::runtime_error("Erroneous <ddsfmu>");
+      }
+      if (!mapper().idl_context().module().has_structure(std::string(type->value()))) {
+        throw std::runtime_error("Requested unknown type: " + std::string(type->value()));
+      }
+
+      TopicOptions options;
+      if (sig_type == DynamicPubSub::PubOrSub::PUBLISH) {
+        auto period = fmu_node->first_attribute("period");
+        auto rate = fmu_node->first_attribute("rate");
+        if (period && rate) {
+          throw std::runtime_error("<ddsfmu><fmu_in> must not have both 'period' and 'rate'");
+        }
+        if (period) { options.period = std::stod(period->value()); }
+        if (rate) { options.period = 1.0 / std::stod(rate->value()); }
+        if ((period || rate) && !(options.period > 0.0 && std::isfinite(options.period))) {
+          throw std::runtime_error("<ddsfmu><fmu_in> 'period' and 'rate' must be positive");
+        }
+      } else {
+        if (auto alignment = fmu_node->first_attribute("time_alignment")) {
+          options.alignment = detail::parse_time_alignment(alignment->value());
+        }
+        if (auto history = fmu_node->first_attribute("history")) {
+          options.history = std::stoul(history->value());
+          if (options.history == 0) {
+            throw std::runtime_error("<ddsfmu><fmu_out> attribute 'history' must be positive");
+          }
+        }
+        if (auto lockstep = fmu_node->first_attribute("lockstep")) {
+          std::istringstream(lockstep->value()) >> std::boolalpha >> options.lockstep;
+        }
+      }
+      signals.emplace_back(std::make_tuple(topic->value(), type->value(), sig_type, options));
+    }
+  };
+
+  xml_loader("fmu_in", fmu_signals);  // publishers
+  xml_loader("fmu_out", fmu_signals); // subscribers
+
+  // Transports of the participant profile are used by default
+  Transport transport = Transport::Profile;
+  bool localhost_only = false;
+  if (auto transport_attribute = root_node->first_attribute("transport")) {
+    transport = parse_transport(transport_attribute->value());
+  }
+  if (auto localhost_attribute = root_node->first_attribute("localhost_only")) {
+    std::istringstream(localhost_attribute->value()) >> std::boolalpha >> localhost_only;
+  }
+  if (localhost_only && transport == Transport::Profile) {
+    throw std::runtime_error("<ddsfmu> attribute 'localhost_only' requires 'local' or 'udpv4'");
+  }
+
   // Note: We create only one participant for each fmu
-  m_participant = edds::DomainParticipantFactory::get_instance()->create_participant_with_profile(
-    "dds-fmu-default");
+  auto* participant_factory = edds::DomainParticipantFactory::get_instance();
+  if (transport == Transport::Profile) {
+    m_participant = participant_factory->create_participant_with_profile("dds-fmu-default");
+  } else {
+    // Transports replace those of the profile, while its domain id and other QoS are kept
+    eprosima::fastrtps::ParticipantAttributes attributes;
+    eprosima::fastrtps::xmlparser::XMLProfileManager::fillParticipantAttributes(
+      "dds-fmu-default", attributes, false);
+    edds::DomainParticipantQos participant_qos = participant_factory->get_default_participant_qos();
+    participant_factory->get_participant_qos_from_profile("dds-fmu-default", participant_qos);
+
+    std::vector<std::optional<std::size_t>> sample_sizes;
+    for (const auto& topic_type : fmu_signals) {
+      if (std::get<2>(topic_type) != PubOrSub::PUBLISH) { continue; }
+      sample_sizes.push_back(config::max_serialized_size(
+        mapper().idl_context().module().structure(std::get<1>(topic_type))));
+    }
+    configure_transports(
+      participant_qos, transport, localhost_only, shm_segment_size(sample_sizes));
+    m_participant = participant_factory->create_participant(attributes.domainId, participant_qos);
+  }
 
   if (!m_participant) { throw std::runtime_error("Could not create domain participant"); }
 
@@ -301,51 +739,170 @@ void DynamicPubSub::reset(
     throw std::runtime_error("Could not register custom key filter factory");
   }
 
-  // load ddsfmu mapping
-  rapidxml::xml_document<> doc;
-  std::vector<char> buffer;
+  // Samples are stamped with wall-clock time by default, as by any DDS participant
+  m_simulation_stamps = false;
+  if (auto timestamps = root_node->first_attribute("timestamps")) {
+    std::string kind(timestamps->value());
+    if (kind != "wall" && kind != "simulation") {
+      throw std::runtime_error("<ddsfmu> attribute 'timestamps' must be 'wall' or 'simulation'");
+    }
+    m_simulation_stamps = (kind == "simulation");
+  }
+  // Wall-clock stamps of peers are far ahead of simulation time, so no sample would be selected
+  for (const auto& topic_type : fmu_signals) {
+    if (
+      std::get<3>(topic_type).alignment != detail::TimeAlignment::Latest && !m_simulation_stamps) {
+      throw std::runtime_error(
+        "<ddsfmu><fmu_out> attribute 'time_alignment' requires timestamps=\"simulation\": "
+        + std::get<0>(topic_type));
+    }
+  }
 
-  ddsfmu::config::load_ddsfmu_mapping(
-    doc, fmu_resources / "config" / "dds" / "ddsfmu_mapping.xml", buffer);
+  // Writers send from the calling thread by default, one message per sample
+  m_async_publish = false;
+  m_flow_controller.clear();
+  if (auto publish_mode = root_node->first_attribute("publish_mode")) {
+    std::string kind(publish_mode->value());
+    if (kind != "synchronous" && kind != "asynchronous") {
+      throw std::runtime_error(
+        "<ddsfmu> attribute 'publish_mode' must be 'synchronous' or 'asynchronous'");
+    }
+    m_async_publish = (kind == "asynchronous");
+  }
+  if (auto flow_controller = root_node->first_attribute("flow_controller")) {
+    if (!m_async_publish) {
+      throw std::runtime_error("<ddsfmu> attribute 'flow_controller' requires asynchronous mode");
+    }
+    m_flow_controller = flow_controller->value();
+
+    // Writers would otherwise fail to be created, since fast-dds has no such flow controller
+    const auto& controllers = m_participant->get_qos().flow_controllers();
+    if (std::none_of(controllers.begin(), controllers.end(), [this](const auto& controller) {
+          return controller && controller->name && m_flow_controller == controller->name;
+        })) {
+      throw std::runtime_error(
+        "<ddsfmu> attribute 'flow_controller' is not defined in the participant profile: "
+        + m_flow_controller);
+    }
+  }
 
-  auto root_node = doc.first_node("ddsfmu");
+  // Lockstep options apply to all <fmu_out> with lockstep="true"
+  m_lockstep_options = detail::LockstepOptions();
+  if (auto lockstep = root_node->first_node("lockstep")) {
+    if (auto topic = lockstep->first_attribute("topic")) {
+      m_lockstep_options.topic = topic->value();
+    }
+    if (auto timeout = lockstep->first_attribute("timeout")) {
+      m_lockstep_options.timeout = std::stod(timeout->value());
+    }
+    if (auto spin = lockstep->first_attribute("spin")) {
+      m_lockstep_options.spin = std::stod(spin->value());
+    }
+    if (m_lockstep_options.timeout < 0.0 || m_lockstep_options.spin < 0.0) {
+      throw std::runtime_error("<ddsfmu><lockstep> 'timeout' and 'spin' must not be negative");
+    }
+  }
+  m_lockstep.configure(m_lockstep_options);
+  if (!m_lockstep_options.topic.empty()) {
+    // Mapped topics are created later, or lazily, so they are checked by their configuration
+    for (const auto& topic_type : fmu_signals) {
+      if (std::get<0>(topic_type) == m_lockstep_options.topic) {
+        throw std::runtime_error(
+          "<ddsfmu><lockstep> topic must differ from mapped topics: " + m_lockstep_options.topic);
+      }
+    }
+    create_step_writer();
+  }
 
-  typedef std::vector<std::tuple<std::string, std::string, DynamicPubSub::PubOrSub>> SignalList;
-  SignalList fmu_signals;
+  // Deferred creation postpones type building and entity creation until the topic is first
+  // accessed, or at the latest when activate_all() is called.
+  bool lazy_entities = false;
+  auto lazy_attribute = root_node->first_attribute("lazy_entities");
+  if (lazy_attribute) {
+    std::istringstream(lazy_attribute->value()) >> std::boolalpha >> lazy_entities;
+  }
 
-  // This lambda loads topic and type from <fmu_in> and <fmu_out> of <ddsfmu> the ddsfmu mapping xml
-  auto xml_loader = [&](const std::string& node_name, SignalList& signals) {
-    DynamicPubSub::PubOrSub sig_type;
-    if (node_name == "fmu_in") {
-      sig_type = DynamicPubSub::PubOrSub::PUBLISH;
+  if (lazy_entities) { m_pending.resize(mapper().store_count()); }
+
+  for (auto& topic_type : fmu_signals) {
+    if (lazy_entities) {
+      auto direction = std::get<2>(topic_type) == PubOrSub::PUBLISH ? DataMapper::Direction::Write
+                                                                     : DataMapper::Direction::Read;
+      m_pending.at(mapper().store_index(std::get<0>(topic_type), direction)) = topic_type;
+      ++m_pending_count;
     } else {
-      sig_type = DynamicPubSub::PubOrSub::SUBSCRIBE;
+      create_entities(topic_type);
     }
+  }
+}
 
-    for (rapidxml::xml_node<>* fmu_node = root_node->first_node(node_name.c_str()); fmu_node;
-         fmu_node = fmu_node->next_sibling(node_name.c_str())) {
-      auto topic = fmu_node->first_attribute("topic");
-      auto type = fmu_node->first_attribute("type");
-      if (!topic || !type) {
-        std::cerr << "<ddsfmu><" << node_name
-                  << "> must specify attributes 'topic' and 'type' Got 'topic': " << std::boolalpha
-                  << (topic != nullptr) << " and 'type': " << std::boolalpha << (type != nullptr)
-                  << std::endl;
-        throw std::runtime_error("Erroneous <ddsfmu>");
-      }
-      if (!mapper().idl_context().module().has_structure(std::string(type->value()))) {
-        throw std::runtime_error("Requested unknown type: " + std::string(type->value()));
-      }
-      signals.emplace_back(std::make_tuple(topic->value(), type->value(), sig_type));
-    }
-  };
+void DynamicPubSub::create_step_writer() {
+  namespace edds = eprosima::fastdds::dds;
+  namespace etypes = eprosima::fastrtps::types;
+  const std::string type_name("ddsfmu::LockstepStep");
+  const std::string& topic_name = m_lockstep_options.topic;
+
+  // struct LockstepStep { uint64 step; double time; };
+  if (m_types.find(type_name) == m_types.end()) {
+    auto* factory = etypes::DynamicTypeBuilderFactory::get_instance();
+    etypes::DynamicTypeBuilder_ptr builder = factory->create_struct_builder();
+    builder->add_member(0, "step", factory->create_uint64_type());
+    builder->add_member(1, "time", factory->create_float64_type());
+    builder->set_name(type_name);
+
+    auto& type_support =
+      m_types.emplace(type_name, etypes::DynamicPubSubType(builder->build())).first->second;
+    type_support.setName(type_name.c_str());
+    type_support.auto_fill_type_information(false);
+    type_support.auto_fill_type_object(false);
+    m_participant->register_type(type_support);
+  }
 
-  xml_loader("fmu_in", fmu_signals);  // publishers
-  xml_loader("fmu_out", fmu_signals); // subscribers
+  edds::Topic* topic = m_participant->create_topic_with_profile(topic_name, type_name, topic_name);
+  if (!topic) {
+    topic = m_participant->create_topic(topic_name, type_name, edds::TOPIC_QOS_DEFAULT);
+  }
+  if (!topic) { throw std::runtime_error("Unable to create lockstep topic: " + topic_name); }
+  m_topic_name_ptr.emplace(topic_name, topic);
 
+  m_step_writer = m_publisher->create_datawriter_with_profile(topic, topic_name);
+  if (!m_step_writer) {
+    m_step_writer = m_publisher->create_datawriter(topic, edds::DATAWRITER_QOS_DEFAULT);
+  }
+  if (!m_step_writer) {
+    throw std::runtime_error("Unable to create DataWriter for lockstep topic: " + topic_name);
+  }
+
+  m_step_sample = etypes::DynamicData_ptr(etypes::DynamicDataFactory::get_instance()->create_data(
+    m_types.at(type_name).GetDynamicType()));
+  m_step_count = 0;
+}
+
+void DynamicPubSub::activate(std::size_t store, DataMapper::Direction access) {
+  if (store >= m_pending.size() || !m_pending[store]) { return; }
+
+  bool is_publish = std::get<2>(*m_pending[store]) == PubOrSub::PUBLISH;
+  if (is_publish != (access == DataMapper::Direction::Write)) { return; }
+
+  create_entities(*m_pending[store]);
+  m_pending[store].reset();
+  --m_pending_count;
+}
+
+void DynamicPubSub::activate_all() {
+  for (auto& pending : m_pending) {
+    if (pending) { create_entities(*pending); }
+  }
+  m_pending.clear();
+  m_pending_count = 0;
+}
+
+void DynamicPubSub::create_entities(const TopicSignal& topic_type) {
+  namespace edds = eprosima::fastdds::dds;
+  namespace etypes = eprosima::fastrtps::types;
 
   /*
-    For each topic name, type name and dds direction (read or write)
+    For the given topic name, type name and dds direction (read or write)
     1. Get xtypes DynamicType
     2. Retrieve DynamicTypeBuilder (fast-dds) for xtypes DynamicType
     3. Register type if not registered
@@ -356,186 +913,241 @@ void DynamicPubSub::reset(
       xtypes::DynamicData is a reference to data owned by DataMapper.
 
   */
-  for (auto& topic_type : fmu_signals) {
-    // Get xtypes DynamicType
-    const eprosima::xtypes::DynamicType& message_type(
-      mapper().idl_context().module().structure(std::get<1>(topic_type)));
+  // Get xtypes DynamicType
+  const eprosima::xtypes::DynamicType& message_type(
+    mapper().idl_context().module().structure(std::get<1>(topic_type)));
+
+  // Bounded types get preallocated histories, such that steady state never allocates
+  const std::optional<std::size_t> max_size = config::max_serialized_size(message_type);
+  if (!max_size) {
+    EPROSIMA_LOG_WARNING(
+      DDSFMU, "Type " << std::get<1>(topic_type) << " of topic " << std::get<0>(topic_type)
+                      << " is unbounded, its samples may allocate memory in each step");
+  }
+  bool keyed = false;
+  const auto& structure = static_cast<const eprosima::xtypes::StructType&>(message_type);
+  for (std::size_t i = 0; i < structure.members().size(); ++i) {
+    keyed = keyed || structure.member(i).is_key();
+  }
 
-    // Retrieve DynamicTypeBuilder for xtypes DynamicType
-    etypes::DynamicTypeBuilder* builder = ddsfmu::Converter::create_builder(message_type);
+  // Retrieve DynamicTypeBuilder for xtypes DynamicType
+  etypes::DynamicTypeBuilder* builder = ddsfmu::Converter::create_builder(message_type);
 
-    if (!builder) {
-      throw std::runtime_error("Could not create builder for type: " + std::get<1>(topic_type));
-    }
+  if (!builder) {
+    throw std::runtime_error("Could not create builder for type: " + std::get<1>(topic_type));
+  }
 
-    bool skip_register = false;
+  bool skip_register = false;
 
-    // Register dynamic type with participant by providing topic name and type name
+  // Register dynamic type with participant by providing topic name and type name
 
-    if (m_topic_to_type.find(std::get<0>(topic_type)) != m_topic_to_type.end()) {
-      skip_register = true;
-    }
+  if (m_topic_to_type.find(std::get<0>(topic_type)) != m_topic_to_type.end()) {
+    skip_register = true;
+  }
 
-    if (!skip_register && m_types.find(std::get<1>(topic_type)) != m_types.end()) {
-      m_topic_to_type.emplace(std::get<0>(topic_type), std::get<1>(topic_type));
-      skip_register = true; // type registered
-    }
+  if (!skip_register && m_types.find(std::get<1>(topic_type)) != m_types.end()) {
+    m_topic_to_type.emplace(std::get<0>(topic_type), std::get<1>(topic_type));
+    skip_register = true; // type registered
+  }
 
-    if (!skip_register) {
-      etypes::DynamicType_ptr dyntype_ptr = builder->build();
+  if (!skip_register) {
+    etypes::DynamicType_ptr dyntype_ptr = builder->build();
 
-      if (!dyntype_ptr) {
-        throw std::runtime_error(
-          "Could not create fastrtps dynamic type ptr for: " + std::get<0>(topic_type)
-          + " of type: " + std::get<1>(topic_type));
-      }
+    if (!dyntype_ptr) {
+      throw std::runtime_error(
+        "Could not create fastrtps dynamic type ptr for: " + std::get<0>(topic_type)
+        + " of type: " + std::get<1>(topic_type));
+    }
 
-      auto reg_type =
-        m_types.emplace(std::get<1>(topic_type), etypes::DynamicPubSubType(dyntype_ptr));
+    auto reg_type =
+      m_types.emplace(std::get<1>(topic_type), etypes::DynamicPubSubType(dyntype_ptr));
+
+    bool added = reg_type.second;
+    etypes::DynamicPubSubType& dyn_type_support = reg_type.first->second;
+    m_topic_to_type.emplace(std::get<0>(topic_type), std::get<1>(topic_type));
+
+    edds::TypeSupport p_type = m_participant->find_type(std::get<1>(topic_type));
+
+    // Check if already registered with dds participant
+    if (!p_type) { // not registered
+      dyn_type_support.setName(std::get<1>(topic_type).c_str());
+      // A bug with UnionType in Fast DDS Dynamic Types is bypassed.
+      // WORKAROUND START
+      // Fast-dds builds TypeObjects of dynamic types that are not in the TypeObjectFactory,
+      // which causes seg fault with enums and other complex types, etc sequences of structs.
+      // Types with TypeObjects from the repacker are already there, so building is skipped.
+      const bool type_objects = m_type_objects.contains(std::get<1>(topic_type));
+      dyn_type_support.auto_fill_type_information(type_objects);
+      dyn_type_support.auto_fill_type_object(type_objects);
+      // WORKAROUND END
+
+      // Payload pools of PREALLOCATED histories are sized by the type size
+      if (max_size) {
+        dyn_type_support.m_typeSize =
+          std::max(dyn_type_support.m_typeSize, static_cast<std::uint32_t>(*max_size));
+      }
 
-      bool added = reg_type.second;
-      etypes::DynamicPubSubType& dyn_type_support = reg_type.first->second;
-      m_topic_to_type.emplace(std::get<0>(topic_type), std::get<1>(topic_type));
+      m_participant->register_type(dyn_type_support);
+    }
 
-      edds::TypeSupport p_type = m_participant->find_type(std::get<1>(topic_type));
+    if (added) {
+      // Is this really needed?
+      ddsfmu::Converter::register_type(std::get<1>(topic_type), &dyn_type_support);
+      ddsfmu::Converter::register_xtype(std::get<1>(topic_type), message_type);
+    }
+  }
 
-      // Check if already registered with dds participant
-      if (!p_type) { // not registered
-        dyn_type_support.setName(std::get<1>(topic_type).c_str());
-        // A bug with UnionType in Fast DDS Dynamic Types is bypassed.
-        // WORKAROUND START
-        dyn_type_support.auto_fill_type_information(false); // True will not work with CycloneDDS
-        dyn_type_support.auto_fill_type_object(
-          false); // True causes seg fault with enums and other complex types, etc sequences of structs
-        // WORKAROUND END
+  auto topic_description = m_participant->lookup_topicdescription(std::get<0>(topic_type));
 
-        m_participant->register_type(dyn_type_support);
-      }
+  edds::Topic* tmp_topic = nullptr;
 
-      if (added) {
-        // Is this really needed?
-        ddsfmu::Converter::register_type(std::get<1>(topic_type), &dyn_type_support);
-        ddsfmu::Converter::register_xtype(std::get<1>(topic_type), message_type);
-      }
+  if (!topic_description) {
+    tmp_topic = m_participant->create_topic_with_profile(
+      std::get<0>(topic_type), std::get<1>(topic_type), std::get<0>(topic_type));
+    if (!tmp_topic) {
+      // TODO: add log entry about using default topic qos
+      tmp_topic = m_participant->create_topic(
+        std::get<0>(topic_type), std::get<1>(topic_type), edds::TOPIC_QOS_DEFAULT);
+    }
+    if (!tmp_topic) {
+      throw std::runtime_error(
+        "Unable to create topic: " + std::get<0>(topic_type) + " of type "
+        + std::get<1>(topic_type));
     }
 
-    auto topic_description = m_participant->lookup_topicdescription(std::get<0>(topic_type));
-
-    edds::Topic* tmp_topic = nullptr;
-
-    if (!topic_description) {
-      tmp_topic = m_participant->create_topic_with_profile(
-        std::get<0>(topic_type), std::get<1>(topic_type), std::get<0>(topic_type));
-      if (!tmp_topic) {
-        // TODO: add log entry about using default topic qos
-        tmp_topic = m_participant->create_topic(
-          std::get<0>(topic_type), std::get<1>(topic_type), edds::TOPIC_QOS_DEFAULT);
-      }
-      if (!tmp_topic) {
-        throw std::runtime_error(
-          "Unable to create topic: " + std::get<0>(topic_type) + " of type "
-          + std::get<1>(topic_type));
+  } else {
+    tmp_topic = static_cast<edds::Topic*>(topic_description);
+  }
+  m_topic_name_ptr.emplace(std::get<0>(topic_type), tmp_topic);
+
+  const etypes::DynamicType_ptr& dynamic_type =
+    m_types.at(m_topic_to_type.at(std::get<0>(topic_type))).GetDynamicType();
+
+  etypes::DynamicData* dynamic_data_ptr =
+    etypes::DynamicDataFactory::get_instance()->create_data(dynamic_type);
+
+  if (std::get<2>(topic_type) == PubOrSub::PUBLISH) {
+    // Publish mode and memory policy are immutable, so they are set on the QoS of the
+    // profile before creation
+    edds::DataWriterQos writer_qos = m_publisher->get_default_datawriter_qos();
+    m_publisher->get_datawriter_qos_from_profile(std::get<0>(topic_type), writer_qos);
+    preallocate_history(writer_qos, max_size, keyed);
+    if (m_async_publish) {
+      writer_qos.publish_mode().kind = edds::ASYNCHRONOUS_PUBLISH_MODE;
+      if (!m_flow_controller.empty()) {
+        writer_qos.publish_mode().flow_controller_name = m_flow_controller.c_str();
       }
+    }
+    edds::DataWriter* tmp_writer = m_publisher->create_datawriter(tmp_topic, writer_qos);
 
-    } else {
-      tmp_topic = static_cast<edds::Topic*>(topic_description);
+    if (!tmp_writer && m_async_publish) {
+      // The default QoS would silently publish synchronously
+      throw std::runtime_error(
+        "Unable to create DataWriter in asynchronous publish mode for topic: "
+        + std::get<0>(topic_type));
+    }
+    if (!tmp_writer) {
+      // TODO: add log entry about using default datawriter qos
+      tmp_writer = m_publisher->create_datawriter(tmp_topic, edds::DATAWRITER_QOS_DEFAULT);
+    }
+    if (!tmp_writer) {
+      throw std::runtime_error(
+        "Unable to create DataWriter for topic: " + std::get<1>(topic_type));
     }
-    m_topic_name_ptr.emplace(std::get<0>(topic_type), tmp_topic);
 
-    const etypes::DynamicType_ptr& dynamic_type =
-      m_types.at(m_topic_to_type.at(std::get<0>(topic_type))).GetDynamicType();
+    m_writers.push_back(tmp_writer);
+    m_writer_data.push_back(
+      &mapper().data_ref(std::get<0>(topic_type), DataMapper::Direction::Write));
+    m_writer_samples.emplace_back(dynamic_data_ptr);
+    m_writer_stores.push_back(
+      mapper().store_index(std::get<0>(topic_type), DataMapper::Direction::Write));
+    m_writer_periods.push_back(std::get<3>(topic_type).period);
+    m_writer_due.push_back(-std::numeric_limits<double>::infinity());
+    DDSFMU_TRACE_TOPIC(m_trace_instance, m_writer_stores.back(), std::get<0>(topic_type));
+  } else {
+    bool need_filter = false;
+
+    try {
+      // If user has requested key_filter=True, it is registered in DataMapper
+      const auto& parameter_data =
+        mapper().data_ref(std::get<0>(topic_type), DataMapper::Direction::Parameter);
+
+      // Iterate members to see if at least one member is key
+      parameter_data.for_each([&](const eprosima::xtypes::DynamicData::ReadableNode& a_node) {
+        bool a_is_leaf =
+          (a_node.type().is_primitive_type() || a_node.type().is_enumerated_type());
+        bool a_is_string = a_node.type().kind() == eprosima::xtypes::TypeKind::STRING_TYPE;
+        if (
+          (a_is_leaf || a_is_string) && a_node.from_member() && a_node.from_member()->is_key()) {
+          need_filter = true;
+          throw false; // Found at least one key, so break for_each
+        }
+      });
+    } catch (const std::out_of_range& no_key) {
+      /* Not registered in DataMapper, no key filtering */
+    }
 
-    etypes::DynamicData* dynamic_data_ptr =
-      etypes::DynamicDataFactory::get_instance()->create_data(dynamic_type);
+    eprosima::fastdds::dds::ContentFilteredTopic* filter_topic = nullptr;
 
-    if (std::get<2>(topic_type) == PubOrSub::PUBLISH) {
-      edds::DataWriter* tmp_writer =
-        m_publisher->create_datawriter_with_profile(tmp_topic, std::get<0>(topic_type));
+    if (need_filter) {
+      filter_topic = m_participant->create_contentfilteredtopic(
+        std::get<0>(topic_type) + "Filtered", tmp_topic, " ", {"|GUID UNKNOWN|", "0"},
+        "CUSTOM_KEY_FILTER");
 
-      if (!tmp_writer) {
-        // TODO: add log entry about using default datawriter qos
-        tmp_writer = m_publisher->create_datawriter(tmp_topic, edds::DATAWRITER_QOS_DEFAULT);
-      }
-      if (!tmp_writer) {
+      if (filter_topic == nullptr) {
         throw std::runtime_error(
-          "Unable to create DataWriter for topic: " + std::get<1>(topic_type));
-      }
-
-      m_write_data.emplace(std::make_pair(
-        tmp_writer,
-        std::make_pair(
-          std::ref(mapper().data_ref(std::get<0>(topic_type), DataMapper::Direction::Write)),
-          dynamic_data_ptr)));
-    } else {
-      bool need_filter = false;
-
-      try {
-        // If user has requested key_filter=True, it is registered in DataMapper
-        auto parameter_data =
-          mapper().data_ref(std::get<0>(topic_type), DataMapper::Direction::Parameter);
-
-        // Iterate members to see if at least one member is key
-        parameter_data.for_each([&](const eprosima::xtypes::DynamicData::ReadableNode& a_node) {
-          bool a_is_leaf =
-            (a_node.type().is_primitive_type() || a_node.type().is_enumerated_type());
-          bool a_is_string = a_node.type().kind() == eprosima::xtypes::TypeKind::STRING_TYPE;
-          if (
-            (a_is_leaf || a_is_string) && a_node.from_member() && a_node.from_member()->is_key()) {
-            need_filter = true;
-            throw false; // Found at least one key, so break for_each
-          }
-        });
-      } catch (const std::out_of_range& no_key) {
-        /* Not registered in DataMapper, no key filtering */
+          "Unable to create filtered topic for: " + std::get<1>(topic_type));
       }
+    }
 
-      eprosima::fastdds::dds::ContentFilteredTopic* filter_topic = nullptr;
-
-      if (need_filter) {
-        filter_topic = m_participant->create_contentfilteredtopic(
-          std::get<0>(topic_type) + "Filtered", tmp_topic, " ", {"|GUID UNKNOWN|", "0"},
-          "CUSTOM_KEY_FILTER");
+    edds::DataReaderQos reader_qos = m_subscriber->get_default_datareader_qos();
+    m_subscriber->get_datareader_qos_from_profile(std::get<0>(topic_type), reader_qos);
+    preallocate_history(reader_qos, max_size, keyed);
 
-        if (filter_topic == nullptr) {
-          throw std::runtime_error(
-            "Unable to create filtered topic for: " + std::get<1>(topic_type));
-        }
-      }
+    edds::DataReader* tmp_reader = nullptr;
 
-      edds::DataReader* tmp_reader = nullptr;
+    if (!need_filter) {
+      tmp_reader = m_subscriber->create_datareader(tmp_topic, reader_qos);
+    } else {
+      tmp_reader = m_subscriber->create_datareader(filter_topic, reader_qos);
+    }
 
+    if (!tmp_reader) {
+      // TODO: add log entry about using default datareader qos
       if (!need_filter) {
-        m_subscriber->create_datareader_with_profile(tmp_topic, std::get<0>(topic_type));
+        tmp_reader = m_subscriber->create_datareader(tmp_topic, edds::DATAREADER_QOS_DEFAULT);
       } else {
-        m_subscriber->create_datareader_with_profile(filter_topic, std::get<0>(topic_type));
-      }
-
-      if (!tmp_reader) {
-        // TODO: add log entry about using default datareader qos
-        if (!need_filter) {
-          tmp_reader = m_subscriber->create_datareader(tmp_topic, edds::DATAREADER_QOS_DEFAULT);
-        } else {
-          tmp_reader = m_subscriber->create_datareader(filter_topic, edds::DATAREADER_QOS_DEFAULT);
-        }
-      }
-      if (!tmp_reader) {
-        throw std::runtime_error(
-          "Unable to create DataReader for topic: " + std::get<1>(topic_type));
-      }
-
-      if (need_filter) {
-        m_reader_topic_filter.emplace(tmp_reader, filter_topic);
-        m_filter_data.emplace(
-          filter_topic,
-          std::ref(mapper().data_ref(std::get<0>(topic_type), DataMapper::Direction::Parameter)));
+        tmp_reader = m_subscriber->create_datareader(filter_topic, edds::DATAREADER_QOS_DEFAULT);
       }
+    }
+    if (!tmp_reader) {
+      throw std::runtime_error(
+        "Unable to create DataReader for topic: " + std::get<1>(topic_type));
+    }
 
-      m_read_data.emplace(std::make_pair(
-        tmp_reader,
-        std::make_pair(
-          std::ref(mapper().data_ref(std::get<0>(topic_type), DataMapper::Direction::Read)),
-          dynamic_data_ptr)));
+    m_readers.push_back(tmp_reader);
+    m_reader_data.push_back(
+      &mapper().data_ref(std::get<0>(topic_type), DataMapper::Direction::Read));
+    m_reader_samples.emplace_back(dynamic_data_ptr);
+    m_reader_filters.push_back(filter_topic);
+    m_filter_data.push_back(
+      need_filter ? &mapper().data_ref(std::get<0>(topic_type), DataMapper::Direction::Parameter)
+                  : nullptr);
+    m_reader_stores.push_back(
+      mapper().store_index(std::get<0>(topic_type), DataMapper::Direction::Read));
+    m_reader_key_filters.push_back(nullptr);
+
+    const TopicOptions& options = std::get<3>(topic_type);
+    if (options.alignment == detail::TimeAlignment::Latest) {
+      m_reader_histories.emplace_back();
+    } else {
+      m_reader_histories.emplace_back(options.history, options.alignment, [&dynamic_type]() {
+        return etypes::DynamicData_ptr(
+          etypes::DynamicDataFactory::get_instance()->create_data(dynamic_type));
+      });
     }
+    if (options.lockstep) { m_lockstep.add(tmp_reader, m_readers.size() - 1); }
+    DDSFMU_TRACE_TOPIC(m_trace_instance, m_reader_stores.back(), std::get<0>(topic_type));
   }
 }
 
@@ -7,9 +7,15 @@
   file, You can obtain one at http://mozilla.org/MPL/2.0/.
 */
 
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
 #include <functional>
 #include <map>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
 
 #include <fastdds/dds/domain/DomainParticipant.hpp>
 #include <fastdds/dds/domain/DomainParticipantListener.hpp>
@@ -17,10 +23,15 @@
 #include <fastdds/dds/publisher/Publisher.hpp>
 #include <fastdds/dds/subscriber/DataReader.hpp>
 #include <fastdds/dds/subscriber/Subscriber.hpp>
+#include <fastrtps/types/DynamicDataPtr.h>
 #include <fastrtps/types/DynamicPubSubType.h>
 
 #include "CustomKeyFilterFactory.hpp"
 #include "DataMapper.hpp"
+#include "Lockstep.hpp"
+#include "SampleHistory.hpp"
+#include "StepDiagnostics.hpp"
+#include "TypeObjects.hpp"
 
 namespace cppfmu {
 class Logger;
@@ -117,19 +128,81 @@ public:
     const std::filesystem::path& fmu_resources, DataMapper* const mapper,
     const std::string& name = "dds-fmu", cppfmu::Logger* const logger = nullptr);
 
+  /**
+     @brief Resets the state of DynamicPubSub while keeping DDS entities
+
+     Discards samples received so far and re-initializes key filter parameters from the
+     DataMapper. The participant and all entities are kept, so matched endpoints need not
+     be rediscovered. Call DataMapper::soft_reset() before this function.
+  */
+  void soft_reset();
+
+  /**
+     @brief Discards the runtime state of earlier steps, e.g. after an FMU state was restored
+
+     Samples kept for time alignment are discarded and decimated topics are published in the
+     next step. Samples not yet taken from the DataReaders are kept, as are DDS entities and
+     key filters.
+
+     @param [in] step_count Steps published on the lockstep handshake topic so far
+  */
+  void restart(std::uint64_t step_count);
+
+  /// Steps published on the lockstep handshake topic since reset
+  inline std::uint64_t step_count() const { return m_step_count; }
+
+  /// Identifier of the events of this instance in the trace, see detail::Tracer
+  inline std::uint32_t trace_instance() const { return m_trace_instance; }
+
   /**
      @brief Writes DDS data by using data from DataMapper
 
      For each DataWriter: Converts associated xtypes::DynamicData to DynamicData_ptr and publishes it
+
+     With `timestamps="simulation"` on `<ddsfmu>` in the ddsfmu mapping, the source timestamp
+     of the samples is the given simulation time instead of wall-clock time.
+
+     With `period` or `rate` on `<fmu_in>`, the topic is converted and published only when its
+     period has elapsed in simulation time, otherwise the DataWriter is skipped. If the time
+     moves back before the last publication, the topic is published and its period restarts.
+     Without a time, all DataWriters publish.
+
+     With `publish_mode="asynchronous"` on `<ddsfmu>`, samples are only queued here and sent by
+     the thread of a flow controller, which groups samples of all DataWriters queued by then
+     into as few RTPS messages as possible.
+
+     With `<lockstep topic="...">` in the ddsfmu mapping, the step counter and the given
+     simulation time are published on the handshake topic after all DataWriters.
+
+     @param [in] time Simulation time at the start of the step, if known
   */
-  void write();
+  void write(std::optional<double> time = std::nullopt);
+
+  /**
+     @brief Waits until each lockstep DataReader has a sample for the step
+
+     DataReaders of `<fmu_out>` with `lockstep="true"` in the ddsfmu mapping are waited
+     for, with timeout and spin time from `<lockstep>`. Returns immediately if there are
+     no such readers. On timeout, the step continues with the samples received so far.
+
+     @param [in] time Simulation time at the end of the step, if known
+     @return False if the timeout expired
+  */
+  bool wait(std::optional<double> time = std::nullopt);
 
   /**
      @brief Takes DDS data into data in DataMapper
 
      For each DataReader: Takes data from DDS and if data: Converts to associated xtypes::DynamicData
+
+     With `time_alignment` on `<fmu_out>` in the ddsfmu mapping, received samples are kept in a
+     history, and only the sample selected by its source timestamp is converted. Samples
+     stamped later than the given time are kept for later steps. Without a time, all
+     readers take all samples.
+
+     @param [in] time Simulation time at the end of the step, if known
   */
-  void take();
+  void take(std::optional<double> time = std::nullopt);
 
   /**
      @brief Initialize content filters for keyed topics
@@ -139,13 +212,62 @@ public:
   */
   void init_key_filters();
 
+  /**
+     @brief Creates deferred DDS entities associated with a data store
+
+     With `lazy_entities="true"` on `<ddsfmu>` in the ddsfmu mapping, type registration,
+     topic, DataWriter and DataReader creation is deferred until the data store is first
+     accessed. A DataWriter is created on first write access to its input data store, and a
+     DataReader on first read access to its output data store. Does nothing if there is no
+     pending entity for the data store and access kind.
+
+     @param [in] store Index of data store, see DataMapper::store_index()
+     @param [in] access Write for FMU setters, Read for FMU getters
+  */
+  void activate(std::size_t store, DataMapper::Direction access);
+
+  /**
+     @brief Creates all deferred DDS entities
+
+     Call this before init_key_filters(), such that all readers have been created.
+  */
+  void activate_all();
+
+  /// Returns true if there are deferred DDS entities not yet created
+  inline bool has_pending() const { return m_pending_count > 0; }
+
+  /**
+     @brief Sets the diagnostics that write() and take() report to
+
+     Conversion time, bytes published, samples taken and key filter rejects are counted
+     only if diagnostics are set. Set this after reset().
+
+     @param [in] diagnostics Pointer to diagnostics, or nullptr to disable
+  */
+  inline void set_diagnostics(detail::StepDiagnostics* diagnostics) {
+    m_diagnostics = diagnostics;
+  }
+
 private:
-  typedef std::pair<eprosima::xtypes::DynamicData&, eprosima::fastrtps::types::DynamicData_ptr>
-    DynamicDataConnection;
   enum class PubOrSub {
     PUBLISH,
     SUBSCRIBE
   }; ///< Internal indication whether dealing with publish or subscriber
+  /// Options of a topic given as attributes of <fmu_in> or <fmu_out>
+  struct TopicOptions {
+    detail::TimeAlignment alignment = detail::TimeAlignment::Latest;
+    std::size_t history = 8; ///< Samples kept for time alignment
+    bool lockstep = false;   ///< Whether wait() waits for samples of the topic
+    double period = 0.0;     ///< Simulation time between publications, or zero for each step
+  };
+  typedef std::tuple<std::string, std::string, PubOrSub, TopicOptions>
+    TopicSignal; ///< Topic, type, direction, options
+  typedef detail::SampleHistory<eprosima::fastrtps::types::DynamicData_ptr> History;
+  /// Simulation time tolerance of publication periods, as of time alignment
+  static constexpr double PeriodTolerance = History::Tolerance;
+  void create_entities(const TopicSignal& topic_type); ///< Registers type and creates entities
+  std::uint64_t take_aligned(std::size_t reader, double time); ///< Returns samples taken
+  void create_step_writer(); ///< Creates the DataWriter of the lockstep handshake topic
   DataMapper* m_data_mapper;
   inline DataMapper& mapper() { return *m_data_mapper; }
   void clear(); ///< Clears and deletes all members in need of cleanup
@@ -156,14 +278,42 @@ private:
   DomainListener m_listener;
   std::map<std::string, std::string> m_topic_to_type;
   std::map<std::string, eprosima::fastrtps::types::DynamicPubSubType> m_types;
+  detail::TypeObjectBundle m_type_objects; ///< Generated by the repacker, or empty
   std::map<std::string, eprosima::fastdds::dds::Topic*> m_topic_name_ptr;
-  std::map<eprosima::fastdds::dds::DataReader*, eprosima::fastdds::dds::ContentFilteredTopic*>
-    m_reader_topic_filter;
-  std::map<eprosima::fastdds::dds::ContentFilteredTopic*, eprosima::xtypes::DynamicData&>
-    m_filter_data;
-  std::map<eprosima::fastdds::dds::DataWriter*, DynamicDataConnection> m_write_data;
-  std::map<eprosima::fastdds::dds::DataReader*, DynamicDataConnection> m_read_data;
+
+  // DataWriters as struct of arrays, indexed in order of creation
+  std::vector<eprosima::fastdds::dds::DataWriter*> m_writers;
+  std::vector<eprosima::xtypes::WritableDynamicDataRef*> m_writer_data; ///< Data store
+  std::vector<eprosima::fastrtps::types::DynamicData_ptr> m_writer_samples;
+  std::vector<std::size_t> m_writer_stores; ///< Data store index
+  std::vector<double> m_writer_periods; ///< Zero if published in each step
+  std::vector<double> m_writer_due; ///< Simulation time of the next publication
+
+  // DataReaders as struct of arrays, indexed in order of creation
+  std::vector<eprosima::fastdds::dds::DataReader*> m_readers;
+  std::vector<eprosima::xtypes::WritableDynamicDataRef*> m_reader_data; ///< Data store
+  std::vector<eprosima::fastrtps::types::DynamicData_ptr> m_reader_samples;
+  std::vector<eprosima::fastdds::dds::ContentFilteredTopic*> m_reader_filters; ///< Or nullptr
+  std::vector<eprosima::xtypes::WritableDynamicDataRef*> m_filter_data; ///< Key parameters
+  std::vector<std::size_t> m_reader_stores; ///< Data store index
+  std::vector<const detail::CustomKeyFilter*> m_reader_key_filters; ///< Set by init_key_filters
+  std::vector<History> m_reader_histories; ///< Disabled unless time aligned
+
+  std::vector<std::optional<TopicSignal>> m_pending; ///< Deferred entities by data store index
+  std::size_t m_pending_count;
+  bool m_simulation_stamps; ///< Whether samples are stamped with simulation time
+  bool m_async_publish; ///< Whether DataWriters use asynchronous publish mode
+  std::string m_flow_controller; ///< Of asynchronous DataWriters, or empty for the default
+
+  // Lockstep synchronization
+  detail::LockstepOptions m_lockstep_options;
+  detail::LockstepBarrier m_lockstep;
+  eprosima::fastdds::dds::DataWriter* m_step_writer; ///< Handshake topic, or nullptr
+  eprosima::fastrtps::types::DynamicData_ptr m_step_sample;
+  std::uint64_t m_step_count; ///< Steps published on the handshake topic
   ddsfmu::detail::CustomKeyFilterFactory m_filter_factory;
+  detail::StepDiagnostics* m_diagnostics; ///< Or nullptr if disabled
+  std::uint32_t m_trace_instance; ///< Kept over resets
 };
 
 }
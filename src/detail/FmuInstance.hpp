@@ -7,16 +7,24 @@
   file, You can obtain one at http://mozilla.org/MPL/2.0/.
 */
 
+#include <cstdint>
 #include <filesystem>
 #include <functional>
 #include <iostream>
 #include <string>
+#include <vector>
 
 #include <cppfmu_cs.hpp>
+#include <rapidxml/rapidxml.hpp>
 
 #include "DataMapper.hpp"
 #include "DynamicPubSub.hpp"
 #include "LoggerAdapters.hpp"
+#include "RealtimePacer.hpp"
+#include "StateBuffer.hpp"
+#include "StepDiagnostics.hpp"
+#include "Tracer.hpp"
+#include "model-descriptor.hpp"
 
 namespace ddsfmu {
 
@@ -32,39 +40,45 @@ namespace ddsfmu {
 class FmuInstance : public cppfmu::SlaveInstance {
 public:
   FmuInstance(const std::string& name, const std::filesystem::path& resource_path, cppfmu::Logger logger)
-      : m_name(name), m_resource_path(resource_path), m_logger(logger) {
+      : m_logger(logger), m_soft_reset(false), m_name(name), m_resource_path(resource_path) {
     FmuInstance::Reset();
   }
 
   void SetReal(
     const cppfmu::FMIValueReference vr[], std::size_t nvr, const cppfmu::FMIReal value[]) override {
+    activate(config::ScalarVariableType::Real, vr, nvr, DataMapper::Direction::Write);
     for (std::size_t i = 0; i < nvr; ++i) { m_mapper.set_double(vr[i], value[i]); }
   }
 
   inline void GetReal(
     const cppfmu::FMIValueReference vr[], std::size_t nvr, cppfmu::FMIReal value[]) const override {
+    activate(config::ScalarVariableType::Real, vr, nvr, DataMapper::Direction::Read);
     for (std::size_t i = 0; i < nvr; ++i) { m_mapper.get_double(vr[i], value[i]); }
   }
 
   void SetInteger(
     const cppfmu::FMIValueReference vr[], std::size_t nvr,
     const cppfmu::FMIInteger value[]) override {
+    activate(config::ScalarVariableType::Integer, vr, nvr, DataMapper::Direction::Write);
     for (std::size_t i = 0; i < nvr; ++i) { m_mapper.set_int(vr[i], value[i]); }
   }
 
   void GetInteger(const cppfmu::FMIValueReference vr[], std::size_t nvr, cppfmu::FMIInteger value[])
     const override {
+    activate(config::ScalarVariableType::Integer, vr, nvr, DataMapper::Direction::Read);
     for (std::size_t i = 0; i < nvr; ++i) { m_mapper.get_int(vr[i], value[i]); }
   }
 
   void SetBoolean(
     const cppfmu::FMIValueReference vr[], std::size_t nvr,
     const cppfmu::FMIBoolean value[]) override {
+    activate(config::ScalarVariableType::Boolean, vr, nvr, DataMapper::Direction::Write);
     for (std::size_t i = 0; i < nvr; ++i) { m_mapper.set_bool(vr[i], static_cast<bool>(value[i])); }
   }
 
   void GetBoolean(const cppfmu::FMIValueReference vr[], std::size_t nvr, cppfmu::FMIBoolean value[])
     const override {
+    activate(config::ScalarVariableType::Boolean, vr, nvr, DataMapper::Direction::Read);
     for (std::size_t i = 0; i < nvr; ++i) {
       bool val;
       m_mapper.get_bool(vr[i], val);
@@ -75,22 +89,25 @@ public:
   void SetString(
     const cppfmu::FMIValueReference vr[], std::size_t nvr,
     const cppfmu::FMIString value[]) override {
+    activate(config::ScalarVariableType::String, vr, nvr, DataMapper::Direction::Write);
     for (std::size_t i = 0; i < nvr; ++i) { m_mapper.set_string(vr[i], value[i]); }
   }
 
   void GetString(const cppfmu::FMIValueReference vr[], std::size_t nvr, cppfmu::FMIString value[])
     const override {
-    for (std::size_t i = 0; i < nvr; ++i) {
-      std::string val;
-      m_mapper.get_string(vr[i], val);
-      value[i] = val.c_str();
-    }
+    activate(config::ScalarVariableType::String, vr, nvr, DataMapper::Direction::Read);
+    // Pointers into the data stores remain valid until the next call that modifies them
+    for (std::size_t i = 0; i < nvr; ++i) { value[i] = m_mapper.get_string(vr[i]); }
   }
 
   virtual void ExitInitializationMode() override {
+    m_pubsub.activate_all();
     m_pubsub.init_key_filters();
   }
 
+  /// Writes the event trace, if enabled by DDSFMU_TRACE
+  void Terminate() override { DDSFMU_TRACE_DUMP(); }
+
   ~FmuInstance() = default;
 
   void SetupExperiment(
@@ -102,27 +119,166 @@ public:
   bool DoStep(
     cppfmu::FMIReal currentCommunicationPoint, cppfmu::FMIReal communicationStepSize,
     cppfmu::FMIBoolean /*newStep*/, cppfmu::FMIReal& /*endOfStep*/) override {
+    DDSFMU_TRACE_SCOPE("DoStep", m_pubsub.trace_instance());
     m_time = currentCommunicationPoint + communicationStepSize;
-    m_pubsub.write();
-    m_pubsub.take();
 
+    using Phase = detail::StepDiagnostics::Phase;
+    const bool diagnostics = m_diagnostics.enabled();
+    if (diagnostics) { m_diagnostics.begin_step(); }
+
+    // Inputs are valid at the start of the step, outputs are selected for its end
+    if (m_pacer.enabled()) {
+      detail::PhaseTimer timer(m_diagnostics, Phase::Pace);
+      m_pacer.pace(currentCommunicationPoint);
+      if (diagnostics) { m_diagnostics.set_pacing(m_pacer.jitter_ns(), m_pacer.overruns()); }
+    }
+    {
+      detail::PhaseTimer timer(m_diagnostics, Phase::Write);
+      m_pubsub.write(currentCommunicationPoint);
+    }
+    {
+      detail::PhaseTimer timer(m_diagnostics, Phase::Wait);
+      m_pubsub.wait(m_time);
+    }
+    {
+      detail::PhaseTimer timer(m_diagnostics, Phase::Take);
+      m_pubsub.take(m_time);
+      m_mapper.interpolate(m_time);
+    }
+
+    if (diagnostics) { m_diagnostics.end_step(); }
     return true;
   }
 
+  /**
+     @brief Stores the FMU state in a contiguous buffer
+
+     The state consists of a header, the simulation time, the lockstep step counter and the
+     values of all data stores, see DataMapper::save_state(). The capacity of the buffer is
+     reused, so repeatedly taking snapshots into the same buffer does not allocate. The bytes
+     are in native byte order and can be restored by another process with the same FMU
+     configuration.
+
+     @param [in, out] state Buffer to store the state in
+  */
+  void GetFMUstate(std::vector<std::uint8_t>& state) const {
+    state.clear();
+    detail::append_value(state, StateMagic);
+    detail::append_value(state, StateVersion);
+    detail::append_value(state, m_time);
+    detail::append_value(state, m_pubsub.step_count());
+    m_mapper.save_state(state);
+  }
+
+  /**
+     @brief Restores the FMU state from a buffer created by GetFMUstate()
+
+     Throws std::runtime_error if the state is not recognized or does not match the
+     configuration of this instance.
+
+     Runtime state of earlier steps that is not part of the FMU state is reset instead of
+     restored: samples kept for time alignment and interpolation are discarded, decimated
+     topics are published in the next step, and real-time pacing is re-anchored, see
+     DynamicPubSub::restart(). Outputs are thus those of the restored data stores until new
+     samples are taken. The lockstep step counter is restored.
+
+     @param [in] state Pointer to state bytes
+     @param [in] size Number of state bytes
+  */
+  void SetFMUstate(const std::uint8_t* state, std::size_t size) {
+    detail::StateReader reader(state, size);
+    const auto magic = reader.read<std::uint32_t>();
+    const auto version = reader.read<std::uint32_t>();
+    if (magic != StateMagic || version != StateVersion) {
+      throw std::runtime_error("Unrecognized FMU state");
+    }
+    const auto time = reader.read<cppfmu::FMIReal>();
+    const auto step_count = reader.read<std::uint64_t>();
+    m_mapper.load_state(reader);
+    m_time = time;
+    m_pubsub.restart(step_count);
+    m_pacer.restart();
+  }
+
   void Reset() override {
     m_time = 0.0;
+    m_pacer.restart();
+
+    if (m_soft_reset) {
+      // Keep DDS entities and matched endpoints, only reset the data
+      m_mapper.soft_reset();
+      m_pubsub.soft_reset();
+      return;
+    }
+
     m_mapper.reset(m_resource_path);
     m_pubsub.reset(m_resource_path, &m_mapper, m_name, &m_logger);
+    load_options();
 
+    // Diagnostics write to their data store, which is reconstructed in place by soft resets
+    if (m_mapper.has_diagnostics()) {
+      m_diagnostics.bind(m_mapper.diagnostics_ref(), m_mapper.diagnostics_topics());
+      m_pubsub.set_diagnostics(&m_diagnostics);
+    } else {
+      m_diagnostics.unbind();
+      m_pubsub.set_diagnostics(nullptr);
+    }
   }
 
 private:
+  static constexpr std::uint32_t StateMagic = 0x53554d46; ///< "FMUS" in little-endian
+  static constexpr std::uint32_t StateVersion = 1;        ///< Version of state layout
+
+  /// Creates deferred DDS entities of topics accessed by the value references, if any
+  inline void activate(
+    config::ScalarVariableType fmi_type, const cppfmu::FMIValueReference vr[], std::size_t nvr,
+    DataMapper::Direction access) const {
+    if (!m_pubsub.has_pending()) { return; }
+    for (std::size_t i = 0; i < nvr; ++i) {
+      m_pubsub.activate(m_mapper.owner(fmi_type, vr[i]), access);
+    }
+  }
+
+  /// Loads options given as attributes of <ddsfmu> in the ddsfmu mapping
+  void load_options() {
+    rapidxml::xml_document<> doc;
+    std::vector<char> buffer;
+    config::load_ddsfmu_mapping(
+      doc, m_resource_path / "config" / "dds" / "ddsfmu_mapping.xml", buffer);
+    auto root_node = doc.first_node("ddsfmu");
+
+    // Subsequent resets are hard, unless the user requests reset="soft"
+    auto reset_kind = root_node->first_attribute("reset");
+    m_soft_reset = false;
+    if (reset_kind) {
+      std::string kind(reset_kind->value());
+      if (kind != "soft" && kind != "hard") {
+        throw std::runtime_error("<ddsfmu> attribute 'reset' must be 'soft' or 'hard'");
+      }
+      m_soft_reset = (kind == "soft");
+    }
+
+    // DoStep() runs as fast as possible, unless paced to wall-clock time
+    double realtime_factor = 0.0;
+    if (auto factor = root_node->first_attribute("realtime_factor")) {
+      realtime_factor = std::stod(factor->value());
+      if (realtime_factor < 0.0) {
+        throw std::runtime_error("<ddsfmu> attribute 'realtime_factor' must not be negative");
+      }
+    }
+    m_pacer.configure(realtime_factor);
+  }
+
+  // The fast-dds log consumer of m_pubsub refers to the logger, so the logger is destroyed last
+  cppfmu::Logger m_logger;
   cppfmu::FMIReal m_time;
+  bool m_soft_reset;
   std::string m_name;
   std::filesystem::path m_resource_path;
   ddsfmu::DataMapper m_mapper;
-  ddsfmu::DynamicPubSub m_pubsub;
-  cppfmu::Logger m_logger;
+  mutable ddsfmu::DynamicPubSub m_pubsub; ///< Mutable, since getters may create DDS entities
+  detail::StepDiagnostics m_diagnostics;
+  detail::RealtimePacer m_pacer;
 };
 
 }
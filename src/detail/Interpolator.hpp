@@ -0,0 +1,139 @@
+#pragma once
+
+/*
+  Copyright 2023, SINTEF Ocean
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace ddsfmu {
+namespace detail {
+
+/// Evaluation of Real FMU outputs between received samples
+enum class Interpolation {
+  Hold,       ///< Zero-order hold of the latest sample
+  Linear,     ///< Linear ramp from the previous to the latest sample
+  Extrapolate ///< First-order extrapolation from the two latest samples
+};
+
+/**
+   @brief Parses the value of the `interpolation` attribute
+
+   @param [in] value One of `hold`, `linear` or `extrapolate`
+   @return Interpolation
+*/
+inline Interpolation parse_interpolation(const std::string& value) {
+  if (value == "hold") { return Interpolation::Hold; }
+  if (value == "linear") { return Interpolation::Linear; }
+  if (value == "extrapolate") { return Interpolation::Extrapolate; }
+  throw std::runtime_error("Attribute 'interpolation' must be 'hold', 'linear' or 'extrapolate'");
+}
+
+/**
+   @brief Interpolates the Real signals of one data store between time stamped samples
+
+   The two latest samples are kept in a ring of two slots, each slot holding the values of
+   all signals contiguously. Output values are evaluated in one loop over all signals with
+   a common weight, which compilers vectorize.
+
+   Linear interpolation starts at the previous sample when the latest sample is received,
+   and reaches the latest sample after the interval between the two. The output is thus
+   continuous, but delayed by one sample interval. Extrapolation continues the slope of
+   the two latest samples beyond the latest one.
+*/
+class Interpolator {
+public:
+  /// Simulation time tolerance, samples closer in time replace the latest sample
+  static constexpr double Tolerance = 1e-8;
+
+  /**
+     @brief Creates an interpolator without samples
+
+     @param [in] mode Interpolation
+     @param [in] signals Number of Real signals
+  */
+  Interpolator(Interpolation mode, std::size_t signals)
+      : m_mode(mode), m_signals(signals), m_values(2 * signals), m_output(signals) {}
+
+  inline std::size_t signals() const { return m_signals; }
+  inline std::size_t samples() const { return m_count; } ///< Number of samples, at most two
+
+  /// Values evaluated by evaluate(), which keep their address
+  inline double* output() { return m_output.data(); }
+  inline const double* output() const { return m_output.data(); }
+
+  /**
+     @brief Adds a sample, overwriting the oldest one
+
+     A sample that is not later than the latest sample replaces it.
+
+     @param [in] time Simulation time of the sample
+     @return Values of the sample to fill in, signals() values
+  */
+  double* sample(double time) {
+    if (m_count == 0 || time > m_times[m_latest] + Tolerance) {
+      m_latest ^= 1;
+      m_count = std::min<std::size_t>(m_count + 1, 2);
+    }
+    m_times[m_latest] = time;
+    return &m_values[m_latest * m_signals];
+  }
+
+  /**
+     @brief Evaluates the output at a simulation time
+
+     Does nothing without samples.
+
+     @param [in] time Simulation time
+  */
+  void evaluate(double time) {
+    if (m_count == 0) { return; }
+
+    const double* latest = &m_values[m_latest * m_signals];
+    double* output = m_output.data();
+
+    // Weight of the latest sample relative to the previous one
+    double weight = 1.0;
+    if (m_count == 2 && m_mode != Interpolation::Hold) {
+      const double interval = m_times[m_latest] - m_times[m_latest ^ 1];
+      const double elapsed = time - m_times[m_latest];
+      if (m_mode == Interpolation::Linear) {
+        weight = std::clamp(elapsed / interval, 0.0, 1.0);
+      } else {
+        weight = 1.0 + std::max(elapsed, 0.0) / interval;
+      }
+    }
+
+    if (weight == 1.0) {
+      std::copy(latest, latest + m_signals, output);
+      return;
+    }
+
+    const double* previous = &m_values[(m_latest ^ 1) * m_signals];
+    for (std::size_t i = 0; i < m_signals; ++i) {
+      output[i] = previous[i] + weight * (latest[i] - previous[i]);
+    }
+  }
+
+  /// Removes all samples, the output is kept
+  inline void clear() { m_count = 0; }
+
+private:
+  Interpolation m_mode;
+  std::size_t m_signals;
+  std::vector<double> m_values; ///< Two slots of m_signals values
+  std::vector<double> m_output;
+  double m_times[2] = {0.0, 0.0};
+  std::size_t m_latest = 0; ///< Slot of the latest sample
+  std::size_t m_count = 0;
+};
+
+}
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+/*
+  Copyright 2023, SINTEF Ocean
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fastdds/dds/core/condition/StatusCondition.hpp>
+#include <fastdds/dds/core/condition/WaitSet.hpp>
+#include <fastdds/dds/core/status/StatusMask.hpp>
+#include <fastdds/dds/subscriber/DataReader.hpp>
+#include <fastrtps/common/Time_t.h>
+
+namespace ddsfmu {
+namespace detail {
+
+/// Options of `<lockstep>` in the ddsfmu mapping
+struct LockstepOptions {
+  std::string topic;     ///< Handshake topic with the step counter, or empty
+  double timeout = 1.0;  ///< Seconds to wait for samples in each step
+  double spin = 100e-6;  ///< Seconds of busy-waiting at most before sleeping
+};
+
+/**
+   @brief Barrier on DataReaders that blocks until each of them has a sample
+
+   Waiting first polls the readers, yielding the thread between polls, and then sleeps on a
+   WaitSet with the data available conditions of the readers still missing a sample. The
+   polling time adapts to the latency of previous steps: it is twice its moving average,
+   but at most the configured spin time. Peers that answer quickly are thus caught without
+   the wake-up latency of the WaitSet, while slow peers do not burn a core.
+*/
+class LockstepBarrier {
+public:
+  typedef std::chrono::steady_clock Clock;
+
+  /// Sets timeout and spin time of subsequent waits, see LockstepOptions
+  void configure(const LockstepOptions& options) {
+    m_timeout = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(options.timeout));
+    m_spin_limit = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(options.spin));
+    m_spin = m_spin_limit;
+    m_latency = Clock::duration::zero();
+  }
+
+  /**
+     @brief Adds a DataReader to wait for
+
+     @param [in] reader DataReader, which must outlive the barrier or clear()
+     @param [in] index Index of the reader passed to the predicate of wait()
+  */
+  void add(eprosima::fastdds::dds::DataReader* reader, std::size_t index) {
+    auto& condition = reader->get_statuscondition();
+    condition.set_enabled_statuses(eprosima::fastdds::dds::StatusMask::data_available());
+    m_waitset.attach_condition(condition);
+    m_conditions.push_back(&condition);
+    m_indexes.push_back(index);
+    m_done.push_back(false);
+    m_active.reserve(m_conditions.size());
+  }
+
+  /// Removes all DataReaders
+  void clear() {
+    for (auto* condition : m_conditions) { m_waitset.detach_condition(*condition); }
+    m_conditions.clear();
+    m_indexes.clear();
+    m_done.clear();
+    m_timeouts = 0;
+  }
+
+  inline bool enabled() const { return !m_conditions.empty(); }
+
+  /// Number of waits that timed out
+  inline std::uint64_t timeouts() const { return m_timeouts; }
+
+  /**
+     @brief Waits until each DataReader has a sample, or the timeout expires
+
+     @param [in] ready Predicate on the index of a reader, true if it has a sample
+     @return False if the timeout expired
+  */
+  template <typename Ready>
+  bool wait(Ready&& ready) {
+    const auto begin = Clock::now();
+    const auto deadline = begin + m_timeout;
+    bool complete = poll(ready);
+
+    // Busy-wait for fast peers
+    while (!complete && Clock::now() - begin < m_spin) {
+      std::this_thread::yield();
+      complete = poll(ready);
+    }
+
+    // Sleep on the conditions of readers still missing a sample
+    while (!complete) {
+      const auto now = Clock::now();
+      if (now >= deadline) { break; }
+      const std::chrono::duration<long double> remaining = deadline - now;
+      m_waitset.wait(m_active, eprosima::fastrtps::Duration_t(remaining.count()));
+      complete = poll(ready);
+    }
+
+    // Conditions of complete readers were detached, see poll()
+    for (std::size_t i = 0; i < m_conditions.size(); ++i) {
+      if (m_done[i]) {
+        m_waitset.attach_condition(*m_conditions[i]);
+        m_done[i] = false;
+      }
+    }
+
+    if (!complete) {
+      ++m_timeouts;
+      return false;
+    }
+
+    m_latency = (3 * m_latency + (Clock::now() - begin)) / 4;
+    m_spin = std::min(m_spin_limit, 2 * m_latency);
+    return true;
+  }
+
+private:
+  /// Detaches the conditions of readers that have a sample, true if all have one
+  template <typename Ready>
+  bool poll(Ready& ready) {
+    bool complete = true;
+    for (std::size_t i = 0; i < m_conditions.size(); ++i) {
+      if (m_done[i]) { continue; }
+      if (ready(m_indexes[i])) {
+        m_waitset.detach_condition(*m_conditions[i]);
+        m_done[i] = true;
+      } else {
+        complete = false;
+      }
+    }
+    return complete;
+  }
+
+  eprosima::fastdds::dds::WaitSet m_waitset;
+  eprosima::fastdds::dds::ConditionSeq m_active; ///< Triggered conditions, not used
+  std::vector<eprosima::fastdds::dds::StatusCondition*> m_conditions;
+  std::vector<std::size_t> m_indexes;
+  std::vector<bool> m_done; ///< Readers of the current wait that have a sample
+  Clock::duration m_timeout = std::chrono::seconds(1);
+  Clock::duration m_spin_limit = Clock::duration::zero();
+  Clock::duration m_spin = Clock::duration::zero(); ///< Adapted spin time
+  Clock::duration m_latency = Clock::duration::zero(); ///< Moving average of waits
+  std::uint64_t m_timeouts = 0;
+};
+
+}
+}
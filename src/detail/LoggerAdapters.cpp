@@ -0,0 +1,167 @@
+/*
+  Copyright 2023, SINTEF Ocean
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "LoggerAdapters.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace ddsfmu {
+
+namespace {
+
+  LogSettings::Kind parse_verbosity(const rapidxml::xml_attribute<>* attribute) {
+    const std::string value(attribute->value());
+    if (value == "error") { return LogSettings::Kind::Error; }
+    if (value == "warning") { return LogSettings::Kind::Warning; }
+    if (value == "info") { return LogSettings::Kind::Info; }
+    throw std::runtime_error(
+      "<logging> attribute 'verbosity' must be 'error', 'warning' or 'info'");
+  }
+
+  const char* kind_name(eprosima::fastdds::dds::Log::Kind kind) {
+    switch (kind) {
+    case eprosima::fastdds::dds::Log::Kind::Error: return "Error";
+    case eprosima::fastdds::dds::Log::Kind::Warning: return "Warning";
+    case eprosima::fastdds::dds::Log::Kind::Info:
+    default: return "Info";
+    }
+  }
+
+}
+
+LogSettings::Kind LogSettings::max_verbosity() const {
+  Kind most = verbosity;
+  for (const auto& category : categories) { most = std::max(most, category.second); }
+  return most;
+}
+
+bool LogSettings::accepts(const char* category, Kind kind) const {
+  if (category && !categories.empty()) {
+    auto found = categories.find(category);
+    if (found != categories.end()) { return kind <= found->second; }
+  }
+  return kind <= verbosity;
+}
+
+LogSettings load_log_settings(const rapidxml::xml_node<>* logging) {
+  LogSettings settings;
+  if (!logging) { return settings; }
+
+  if (auto verbosity = logging->first_attribute("verbosity")) {
+    settings.verbosity = parse_verbosity(verbosity);
+  }
+  if (auto max_rate = logging->first_attribute("max_rate")) {
+    settings.max_rate = std::stod(max_rate->value());
+    if (settings.max_rate < 0.0) {
+      throw std::runtime_error("<logging> attribute 'max_rate' must be non-negative");
+    }
+  }
+  if (auto queue_size = logging->first_attribute("queue_size")) {
+    settings.queue_size = std::stoul(queue_size->value());
+    if (settings.queue_size == 0) {
+      throw std::runtime_error("<logging> attribute 'queue_size' must be positive");
+    }
+  }
+
+  for (auto category = logging->first_node("category"); category;
+       category = category->next_sibling("category")) {
+    auto name = category->first_attribute("name");
+    auto verbosity = category->first_attribute("verbosity");
+    if (!name || !verbosity) {
+      throw std::runtime_error(
+        "<logging><category> must specify attributes 'name' and 'verbosity'");
+    }
+    settings.categories[name->value()] = parse_verbosity(verbosity);
+  }
+
+  return settings;
+}
+
+FmiLogger::FmiLogger(cppfmu::Logger& logger, const std::string& name, const LogSettings& settings)
+    : m_logger(logger)
+    , m_name(name)
+    , m_settings(settings)
+    , m_queue(settings.queue_size)
+    , m_tokens(settings.max_rate)
+    , m_refilled(std::chrono::steady_clock::now()) {
+  m_thread = std::thread(&FmiLogger::run, this);
+}
+
+FmiLogger::~FmiLogger() {
+  m_stop.store(true);
+  m_wakeup.notify_one();
+  if (m_thread.joinable()) { m_thread.join(); }
+}
+
+void FmiLogger::Consume(const eprosima::fastdds::dds::Log::Entry& entry) {
+  if (!m_settings.accepts(entry.context.category, entry.kind)) { return; }
+
+  if (m_settings.max_rate > 0.0) {
+    // Refill the token bucket, which holds at most one second worth of entries
+    const auto now = std::chrono::steady_clock::now();
+    const std::chrono::duration<double> elapsed = now - m_refilled;
+    m_refilled = now;
+    m_tokens = std::min(m_settings.max_rate, m_tokens + elapsed.count() * m_settings.max_rate);
+    if (m_tokens < 1.0) {
+      m_suppressed.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    m_tokens -= 1.0;
+  }
+
+  Record record;
+  record.kind = entry.kind;
+  record.category = entry.context.category ? entry.context.category : "";
+  record.message = entry.message;
+  if (!m_queue.try_push(std::move(record))) {
+    m_suppressed.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  m_wakeup.notify_one();
+}
+
+void FmiLogger::run() {
+  while (!m_stop.load()) {
+    {
+      // Entries are forwarded at the latest after the timeout, should a notification be missed
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_wakeup.wait_for(lock, std::chrono::milliseconds(100));
+    }
+    drain();
+  }
+  drain();
+}
+
+void FmiLogger::drain() {
+  Record record;
+  std::string text;
+  while (m_queue.try_pop(record)) {
+    cppfmu::FMIStatus status = cppfmu::FMIOK;
+    switch (record.kind) {
+    case eprosima::fastdds::dds::Log::Kind::Info: status = cppfmu::FMIOK; break;
+    case eprosima::fastdds::dds::Log::Kind::Warning:
+    case eprosima::fastdds::dds::Log::Kind::Error: status = cppfmu::FMIWarning; break;
+    }
+
+    text.clear();
+    text.append("[").append(record.category).append(" ").append(kind_name(record.kind));
+    text.append("] ").append(record.message);
+
+    // The message is a format string, so it is passed as an argument
+    m_logger.Log(status, m_name.c_str(), "%s", text.c_str());
+  }
+
+  const auto suppressed = m_suppressed.exchange(0, std::memory_order_relaxed);
+  if (suppressed > 0) {
+    m_logger.Log(
+      cppfmu::FMIWarning, m_name.c_str(), "%llu fast-dds log entries were suppressed",
+      static_cast<unsigned long long>(suppressed));
+  }
+}
+
+}
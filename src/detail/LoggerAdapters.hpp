@@ -7,53 +7,104 @@
   file, You can obtain one at http://mozilla.org/MPL/2.0/.
 */
 
-#include <iostream>
-#include <sstream>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
 #include <string>
-#include <utility>
+#include <thread>
 
 #include <cppfmu_common.hpp>
-#include <fastdds/dds/log/OStreamConsumer.hpp>
+#include <fastdds/dds/log/Log.hpp>
+#include <rapidxml/rapidxml.hpp>
+
+#include "SpscQueue.hpp"
 
 namespace ddsfmu {
 
-class FmiLogger : public eprosima::fastdds::dds::OStreamConsumer {
+/**
+   @brief Settings of FmiLogger
+
+   Loaded from the `<logging>` element of `<ddsfmu>` in the ddsfmu mapping, see
+   load_log_settings().
+*/
+struct LogSettings {
+  typedef eprosima::fastdds::dds::Log::Kind Kind;
+
+  Kind verbosity = Kind::Warning;         ///< Default verbosity of all categories
+  std::map<std::string, Kind> categories; ///< Verbosity of individual fast-dds categories
+  double max_rate = 100.0;                ///< Maximum forwarded entries per second, 0 is unlimited
+  std::size_t queue_size = 256;           ///< Number of entries waiting to be forwarded
+
+  /// Most verbose kind of any category, which is the verbosity to set for fast-dds
+  Kind max_verbosity() const;
+
+  /// Whether an entry of a category and kind is to be forwarded
+  bool accepts(const char* category, Kind kind) const;
+};
+
+/**
+   @brief Loads logging settings
+
+   The element has the optional attributes `verbosity` (error, warning or info),
+   `max_rate` (entries per second) and `queue_size`, and optional children
+   `<category name="..." verbosity="..."/>`.
+
+   @param [in] logging The `<logging>` element, or nullptr for default settings
+   @return Settings
+*/
+LogSettings load_log_settings(const rapidxml::xml_node<>* logging);
+
+/**
+   @brief Forwards fast-dds log entries to the FMI logger
+
+   Entries are filtered by category and verbosity, rate limited and moved into a bounded
+   lock-free queue by Consume(), which runs on the fast-dds logging thread. A background
+   thread formats the entries and calls the FMI logger, such that slow FMI logging
+   callbacks never stall fast-dds. Entries that are rate limited or do not fit in the queue
+   are counted and reported as a single message.
+
+   Remaining entries are forwarded on destruction, so the FMI logger must outlive the
+   consumer, i.e. the consumer must be unregistered from fast-dds before the logger is
+   destroyed.
+*/
+class FmiLogger : public eprosima::fastdds::dds::LogConsumer {
 public:
   FmiLogger() = delete;
-  FmiLogger(cppfmu::Logger& logger, const std::string& name)
-      : m_logger(logger), m_str(std::ostringstream::ate), m_name(name) {}
-  virtual ~FmiLogger() = default;
-
-  void Consume(const eprosima::fastdds::dds::Log::Entry& entry) override {
-    eprosima::fastdds::dds::OStreamConsumer::Consume(entry);
-
-    cppfmu::FMIStatus status;
-
-    switch (entry.kind) {
-    case eprosima::fastdds::dds::Log::Kind::Info:
-      status = cppfmu::FMIOK;
-      break;
-    case eprosima::fastdds::dds::Log::Kind::Warning:
-    case eprosima::fastdds::dds::Log::Kind::Error:
-      status = cppfmu::FMIWarning;
-      break;
-    }
-
-    // TODO: What is correct category here (not m_name?)
-    m_logger.Log(status, m_name.c_str(), m_str.str().c_str());
-    m_str.str("");
-    m_str.clear();
-  }
-
-protected:
-  std::ostream& get_stream(const eprosima::fastdds::dds::Log::Entry& entry) override {
-    return m_str;
-  }
+  FmiLogger(cppfmu::Logger& logger, const std::string& name, const LogSettings& settings = {});
+  FmiLogger(const FmiLogger&) = delete;            ///< Copy constructor
+  FmiLogger& operator=(const FmiLogger&) = delete; ///< Copy assignment
+  ~FmiLogger() override;                           ///< Forwards remaining entries
+
+  void Consume(const eprosima::fastdds::dds::Log::Entry& entry) override;
 
 private:
-  std::ostringstream m_str;
-  std::string m_name;
+  struct Record {
+    eprosima::fastdds::dds::Log::Kind kind = eprosima::fastdds::dds::Log::Kind::Info;
+    std::string category;
+    std::string message;
+  };
+
+  void run();   ///< Loop of background thread
+  void drain(); ///< Forwards all queued entries to the FMI logger
+
   cppfmu::Logger& m_logger;
+  std::string m_name;
+  LogSettings m_settings;
+  detail::SpscQueue<Record> m_queue;
+
+  // Token bucket of rate limiting, only accessed by Consume()
+  double m_tokens;
+  std::chrono::steady_clock::time_point m_refilled;
+
+  std::atomic<std::uint64_t> m_suppressed{0}; ///< Entries rate limited or not queued
+  std::atomic<bool> m_stop{false};
+  std::mutex m_mutex; ///< Only used to wait for entries
+  std::condition_variable m_wakeup;
+  std::thread m_thread;
 };
 
 }
@@ -0,0 +1,101 @@
+#pragma once
+
+/*
+  Copyright 2023, SINTEF Ocean
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+namespace ddsfmu {
+namespace detail {
+
+/**
+   @brief Paces simulation time to wall-clock time scaled by a real-time factor
+
+   The first call to pace() anchors simulation time to the monotonic clock. Each later call
+   sleeps until the absolute deadline of the given simulation time, such that sleep errors
+   do not accumulate over steps. A step that starts after its deadline is an overrun. The
+   anchor is then moved to the current time, such that late steps are not followed by a
+   burst of steps catching up with wall-clock time.
+*/
+class RealtimePacer {
+public:
+  typedef std::chrono::steady_clock Clock;
+
+  /**
+     @brief Sets the real-time factor
+
+     @param [in] factor Simulation seconds per wall-clock second, or zero to disable
+  */
+  inline void configure(double factor) {
+    m_factor = factor;
+    restart();
+  }
+
+  inline bool enabled() const { return m_factor > 0.0; }
+
+  /// Re-anchors at the next call to pace(), e.g. after a reset or a restored state
+  inline void restart() {
+    m_anchored = false;
+    m_jitter_ns = 0;
+    m_overruns = 0;
+  }
+
+  /**
+     @brief Sleeps until the wall-clock deadline of a simulation time
+
+     @param [in] time Simulation time
+  */
+  void pace(double time) {
+    if (!m_anchored) {
+      anchor(Clock::now(), time);
+      return;
+    }
+
+    const auto deadline = m_wall_origin
+                          + std::chrono::duration_cast<Clock::duration>(
+                            std::chrono::duration<double>((time - m_time_origin) / m_factor));
+    if (Clock::now() < deadline) {
+      std::this_thread::sleep_until(deadline);
+      m_jitter_ns = nanoseconds(Clock::now() - deadline);
+    } else {
+      const auto now = Clock::now();
+      m_jitter_ns = nanoseconds(now - deadline);
+      ++m_overruns;
+      anchor(now, time);
+    }
+  }
+
+  /// Deviation of the last step from its deadline in nanoseconds, wake-up latency or lateness
+  inline std::uint64_t jitter_ns() const { return m_jitter_ns; }
+
+  /// Number of steps that started after their deadline since restart()
+  inline std::uint64_t overruns() const { return m_overruns; }
+
+private:
+  inline void anchor(Clock::time_point now, double time) {
+    m_wall_origin = now;
+    m_time_origin = time;
+    m_anchored = true;
+  }
+
+  static inline std::uint64_t nanoseconds(Clock::duration duration) {
+    return static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+  }
+
+  double m_factor = 0.0;
+  bool m_anchored = false;
+  Clock::time_point m_wall_origin;
+  double m_time_origin = 0.0;
+  std::uint64_t m_jitter_ns = 0;
+  std::uint64_t m_overruns = 0;
+};
+
+}
+}
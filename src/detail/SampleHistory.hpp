@@ -0,0 +1,156 @@
+#pragma once
+
+/*
+  Copyright 2023, SINTEF Ocean
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ddsfmu {
+namespace detail {
+
+/// Selection of received samples by their simulation time stamp
+enum class TimeAlignment {
+  Latest,  ///< All samples are used in order of reception, the last one wins
+  AtMost,  ///< Latest sample stamped no later than the end of the step
+  Closest, ///< Sample stamped nearest to the end of the step
+};
+
+/**
+   @brief Parses the value of the `time_alignment` attribute
+
+   @param [in] value One of `none`, `at_most` or `closest`
+   @return Time alignment, where `none` is TimeAlignment::Latest
+*/
+inline TimeAlignment parse_time_alignment(const std::string& value) {
+  if (value == "none") { return TimeAlignment::Latest; }
+  if (value == "at_most") { return TimeAlignment::AtMost; }
+  if (value == "closest") { return TimeAlignment::Closest; }
+  throw std::runtime_error("Attribute 'time_alignment' must be 'none', 'at_most' or 'closest'");
+}
+
+/**
+   @brief Bounded history of time stamped samples of one DataReader
+
+   Samples are taken into preallocated slots of a ring, such that the history does not
+   allocate after construction. When the ring is full, the oldest sample is overwritten.
+   Samples stamped later than the current step are kept for later steps, so that a reader
+   is not drained ahead of the simulation.
+
+   @tparam SamplePtr Pointer type of samples, swappable and dereferenceable
+*/
+template <typename SamplePtr>
+class SampleHistory {
+public:
+  /// Simulation time tolerance of comparisons, covering the nanosecond resolution of stamps
+  static constexpr double Tolerance = 1e-8;
+
+  /// Slot of the history
+  struct Entry {
+    SamplePtr sample;
+    double time = 0.0;
+  };
+
+  SampleHistory() = default; ///< Empty history, which is disabled
+
+  /**
+     @brief Creates a history and preallocates all samples
+
+     @param [in] capacity Number of samples held at most
+     @param [in] alignment Selection of samples, see select()
+     @param [in] create Creates an empty sample
+  */
+  SampleHistory(
+    std::size_t capacity, TimeAlignment alignment, const std::function<SamplePtr()>& create)
+      : m_alignment(alignment) {
+    m_entries.resize(capacity);
+    for (auto& entry : m_entries) { entry.sample = create(); }
+  }
+
+  /// Whether samples are selected by time, otherwise the history is not used
+  inline bool enabled() const {
+    return !m_entries.empty() && m_alignment != TimeAlignment::Latest;
+  }
+
+  inline std::size_t size() const { return m_size; }
+  inline std::size_t capacity() const { return m_entries.size(); }
+
+  /// Sample to take the next sample into, which is only kept by commit()
+  inline SamplePtr& next_slot() { return m_entries[index(m_size)].sample; }
+
+  /// Keeps the sample of next_slot(), overwriting the oldest sample if full
+  void commit(double time) {
+    m_entries[index(m_size)].time = time;
+    if (m_size == m_entries.size()) {
+      m_head = index(1);
+    } else {
+      ++m_size;
+    }
+  }
+
+  /**
+     @brief Selects the sample to use at the end of a step
+
+     @param [in] time Simulation time at the end of the step
+     @return Selected entry, or nullptr if no sample qualifies
+  */
+  const Entry* select(double time) const {
+    const Entry* selected = nullptr;
+    for (std::size_t i = 0; i < m_size; ++i) {
+      const Entry& entry = m_entries[index(i)];
+      if (m_alignment == TimeAlignment::AtMost) {
+        if (entry.time <= time + Tolerance && (!selected || entry.time >= selected->time)) {
+          selected = &entry;
+        }
+      } else if (
+        !selected || std::abs(entry.time - time) < std::abs(selected->time - time) - Tolerance) {
+        selected = &entry;
+      }
+    }
+    return selected;
+  }
+
+  /// Removes samples stamped no later than time, keeping the order of the others
+  void discard_through(double time) {
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < m_size; ++i) {
+      Entry& entry = m_entries[index(i)];
+      if (entry.time > time + Tolerance) {
+        Entry& target = m_entries[index(kept++)];
+        if (&target != &entry) {
+          std::swap(target.sample, entry.sample);
+          target.time = entry.time;
+        }
+      }
+    }
+    m_size = kept;
+  }
+
+  /// Removes all samples, keeping their memory
+  inline void clear() {
+    m_head = 0;
+    m_size = 0;
+  }
+
+private:
+  inline std::size_t index(std::size_t offset) const {
+    return (m_head + offset) % m_entries.size();
+  }
+
+  std::vector<Entry> m_entries;
+  TimeAlignment m_alignment = TimeAlignment::Latest;
+  std::size_t m_head = 0; ///< Oldest sample
+  std::size_t m_size = 0; ///< Number of samples
+};
+
+}
+}
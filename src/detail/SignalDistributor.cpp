@@ -7,6 +7,9 @@
 
 #include "SignalDistributor.hpp"
 
+#include "StepDiagnostics.hpp"
+#include "StoreArena.hpp"
+
 namespace ddsfmu {
 
 SignalDistributor::SignalDistributor()
@@ -20,25 +23,38 @@ bool SignalDistributor::has_structure(const std::string& topic_type) {
   return m_context.module().has_structure(topic_type);
 }
 
+const eprosima::xtypes::DynamicType& SignalDistributor::structure(const std::string& topic_type) {
+  return m_context.module().structure(topic_type);
+}
+
 void SignalDistributor::add(
   const std::string& topic_name, const std::string& topic_type, Cardinality cardinal) {
-  const eprosima::xtypes::DynamicType& message_type(m_context.module().structure(topic_type));
+  std::string cardinality_prefix;
+  switch (cardinal) {
+  case Cardinality::INPUT: cardinality_prefix = "pub."; break;
+  case Cardinality::OUTPUT: cardinality_prefix = "sub."; break;
+  case Cardinality::PARAMETER: cardinality_prefix = "key.sub."; break;
+  }
+
+  add_signals(
+    m_context.module().structure(topic_type), cardinality_prefix + topic_name + ".", cardinal);
+}
+
+void SignalDistributor::add_diagnostics(const std::vector<std::string>& read_topics) {
+  add_signals(detail::diagnostics_type(read_topics), "diag.", Cardinality::OUTPUT);
+}
+
+void SignalDistributor::add_signals(
+  const eprosima::xtypes::DynamicType& message_type, const std::string& prefix,
+  Cardinality cardinal) {
   eprosima::xtypes::DynamicData message_data(message_type);
+  detail::expand_bounded_sequences(message_data); // Identical to data stores of DataMapper
 
-  std::string cardinal_string, cardinality_prefix;
+  std::string cardinal_string;
   switch (cardinal) {
-  case Cardinality::INPUT:
-    cardinal_string = "input";
-    cardinality_prefix = "pub.";
-    break;
-  case Cardinality::OUTPUT:
-    cardinal_string = "output";
-    cardinality_prefix = "sub.";
-    break;
-  case Cardinality::PARAMETER:
-    cardinal_string = "parameter";
-    cardinality_prefix = "key.sub.";
-    break;
+  case Cardinality::INPUT: cardinal_string = "input"; break;
+  case Cardinality::OUTPUT: cardinal_string = "output"; break;
+  case Cardinality::PARAMETER: cardinal_string = "parameter"; break;
   }
 
   message_data.for_each([&](eprosima::xtypes::DynamicData::ReadableNode& node) {
@@ -49,12 +65,29 @@ void SignalDistributor::add(
     bool is_a_key_parameter = is_leaf_or_string && !is_not_parameter
      && (node.from_member() && node.from_member()->is_key());
 
+    if (node.type().kind() == eprosima::xtypes::TypeKind::SEQUENCE_TYPE && is_not_parameter) {
+      std::string structured_name;
+      config::name_generator(structured_name, node);
+      if (!detail::is_bounded_sequence(node.type())) {
+        std::cerr << "Unbounded sequence is not mapped: " << prefix + structured_name
+                  << std::endl;
+        return;
+      }
+
+      // Elements are mapped like array elements when visited, here only the length
+      if (cardinal == Cardinality::OUTPUT) { m_outputs++; }
+      m_signal_mapping.emplace_back(std::make_tuple(
+        m_integer_idx++, prefix + structured_name + ".length", cardinal_string,
+        config::ScalarVariableType::Integer));
+      return;
+    }
+
     if ((is_leaf_or_string && is_not_parameter) || is_a_key_parameter) {
       if (cardinal == Cardinality::OUTPUT) { m_outputs++; }
 
       std::string structured_name;
       config::name_generator(structured_name, node);
-      structured_name = cardinality_prefix + topic_name + "." + structured_name;
+      structured_name = prefix + structured_name;
 
       auto fmi_type = SignalDistributor::resolve_type(node);
 
@@ -68,6 +68,14 @@ public:
   */
   bool has_structure(const std::string& topic_type);
 
+  /**
+     @brief Returns the scoped structure topic_type, which must exist, see has_structure()
+
+     @param [in] topic_type Scoped name of the type (e.g. My::Impl)
+     @return Structure type from the loaded IDLs
+  */
+  const eprosima::xtypes::DynamicType& structure(const std::string& topic_type);
+
   /**
      @brief  Adds signal mappings in form of SignalInfo entries
 
@@ -82,6 +90,16 @@ public:
   */
   void add(const std::string& topic_name, const std::string& topic_type, Cardinality cardinal);
 
+  /**
+     @brief  Adds diagnostics outputs of each step, see detail::diagnostics_type()
+
+     The signals are named `diag.[structured_name]`. Call this after outputs and before
+     inputs are added, such that diagnostics are enumerated with the outputs.
+
+     @param [in] read_topics Topic names of `<fmu_out>` in order of the ddsfmu mapping
+  */
+  void add_diagnostics(const std::vector<std::string>& read_topics);
+
   /**
      @brief  Queues signal mappings in form of SignalInfo entries for key parameters, if any
 
@@ -115,6 +133,10 @@ public:
     return m_outputs;
   } ///< Returns number of scalar FMU outputs
 private:
+  /// Adds signals for the leaves of a type, with names prefixed by prefix
+  void add_signals(
+    const eprosima::xtypes::DynamicType& message_type, const std::string& prefix,
+    Cardinality cardinal);
   std::queue<std::pair<std::string, std::string>> m_potential_keys;
   std::uint32_t m_real_idx, m_integer_idx, m_boolean_idx, m_string_idx, m_outputs;
   std::vector<SignalInfo> m_signal_mapping;
@@ -0,0 +1,71 @@
+#pragma once
+
+/*
+  Copyright 2023, SINTEF Ocean
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace ddsfmu {
+namespace detail {
+
+/**
+   @brief Bounded lock-free queue for a single producer and a single consumer thread
+
+   Elements are moved in and out of preallocated slots. Neither push nor pop blocks: when
+   the queue is full or empty, the call fails.
+
+   @tparam T Default constructible and move assignable element type
+*/
+template <typename T>
+class SpscQueue {
+public:
+  /**
+     @brief Creates a queue
+
+     @param [in] capacity Minimum number of elements, rounded up to a power of two
+  */
+  explicit SpscQueue(std::size_t capacity) {
+    std::size_t slots = 2;
+    while (slots < capacity) { slots <<= 1; }
+    m_slots.resize(slots);
+    m_mask = slots - 1;
+  }
+  SpscQueue(const SpscQueue&) = delete;            ///< Copy constructor
+  SpscQueue& operator=(const SpscQueue&) = delete; ///< Copy assignment
+
+  /// Moves an element into the queue, called by the producer. Returns false if full.
+  bool try_push(T&& value) {
+    const auto tail = m_tail.load(std::memory_order_relaxed);
+    if (tail - m_head.load(std::memory_order_acquire) == m_slots.size()) { return false; }
+    m_slots[tail & m_mask] = std::move(value);
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Moves the oldest element out of the queue, called by the consumer. Returns false if empty.
+  bool try_pop(T& value) {
+    const auto head = m_head.load(std::memory_order_relaxed);
+    if (head == m_tail.load(std::memory_order_acquire)) { return false; }
+    value = std::move(m_slots[head & m_mask]);
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  inline std::size_t capacity() const { return m_slots.size(); }
+
+private:
+  std::vector<T> m_slots;
+  std::size_t m_mask;
+  alignas(64) std::atomic<std::size_t> m_head{0}; ///< Next element to pop, owned by consumer
+  alignas(64) std::atomic<std::size_t> m_tail{0}; ///< Next element to push, owned by producer
+};
+
+}
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+/*
+  Copyright 2023, SINTEF Ocean
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace ddsfmu {
+namespace detail {
+
+/**
+   @brief Appends raw bytes to a state buffer
+
+   @param [in, out] buffer State buffer
+   @param [in] data Pointer to bytes to append
+   @param [in] size Number of bytes to append
+*/
+inline void append_bytes(std::vector<std::uint8_t>& buffer, const void* data, std::size_t size) {
+  const auto* bytes = static_cast<const std::uint8_t*>(data);
+  buffer.insert(buffer.end(), bytes, bytes + size);
+}
+
+/**
+   @brief Appends a trivially copyable value to a state buffer
+
+   @param [in, out] buffer State buffer
+   @param [in] value Value to append in native byte order
+*/
+template<typename T>
+void append_value(std::vector<std::uint8_t>& buffer, const T& value) {
+  static_assert(std::is_trivially_copyable<T>::value, "State values must be trivially copyable");
+  append_bytes(buffer, &value, sizeof(T));
+}
+
+/**
+   @brief Sequential reader of a state buffer
+
+   Reads values in the order they were appended with append_value() and append_bytes().
+   Throws std::runtime_error if the buffer is exhausted.
+*/
+class StateReader {
+public:
+  StateReader(const std::uint8_t* data, std::size_t size)
+      : m_data(data), m_size(size), m_offset(0) {}
+
+  /**
+     @brief Returns pointer to the next bytes and advances the reader
+
+     @param [in] size Number of bytes to advance
+     @return Pointer to the first byte
+  */
+  const std::uint8_t* take(std::size_t size) {
+    if (size > m_size - m_offset) { throw std::runtime_error("FMU state is truncated"); }
+    const std::uint8_t* bytes = m_data + m_offset;
+    m_offset += size;
+    return bytes;
+  }
+
+  /// Reads a trivially copyable value in native byte order
+  template<typename T>
+  T read() {
+    static_assert(std::is_trivially_copyable<T>::value, "State values must be trivially copyable");
+    T value;
+    std::memcpy(&value, take(sizeof(T)), sizeof(T));
+    return value;
+  }
+
+  inline std::size_t offset() const { return m_offset; } ///< Number of bytes read so far
+
+private:
+  const std::uint8_t* m_data;
+  std::size_t m_size;
+  std::size_t m_offset;
+};
+
+}
+}
@@ -0,0 +1,123 @@
+/*
+  Copyright 2023, SINTEF Ocean
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "StepDiagnostics.hpp"
+
+namespace ddsfmu {
+namespace detail {
+
+namespace {
+
+  std::uint64_t* member(eprosima::xtypes::WritableDynamicDataRef data, const std::string& name) {
+    return reinterpret_cast<std::uint64_t*>(data[name].instance_id());
+  }
+
+}
+
+eprosima::xtypes::StructType diagnostics_type(const std::vector<std::string>& read_topics) {
+  namespace ex = eprosima::xtypes;
+  const auto& counter = ex::primitive_type<std::uint64_t>();
+
+  ex::StructType diagnostics("DdsFmuDiagnostics");
+  diagnostics.add_member("step_ns", counter);
+  diagnostics.add_member("write_ns", counter);
+  diagnostics.add_member("take_ns", counter);
+  diagnostics.add_member("wait_ns", counter);
+  diagnostics.add_member("pace_ns", counter);
+  diagnostics.add_member("convert_ns", counter);
+  diagnostics.add_member("bytes_published", counter);
+  diagnostics.add_member("lockstep_timeouts", counter);
+  diagnostics.add_member("jitter_ns", counter);
+  diagnostics.add_member("overruns", counter);
+
+  if (!read_topics.empty()) {
+    ex::StructType topic("DdsFmuTopicDiagnostics");
+    topic.add_member("samples", counter);
+    topic.add_member("rejects", counter);
+
+    ex::StructType topics("DdsFmuTopicsDiagnostics");
+    for (const auto& name : read_topics) { topics.add_member(name, topic); }
+    diagnostics.add_member("sub", topics);
+  }
+
+  return diagnostics;
+}
+
+void StepDiagnostics::bind(
+  eprosima::xtypes::WritableDynamicDataRef& store, const std::vector<std::string>& read_topics) {
+  m_step_ns = member(store, "step_ns");
+  m_phase_ns[static_cast<std::size_t>(Phase::Write)] = member(store, "write_ns");
+  m_phase_ns[static_cast<std::size_t>(Phase::Take)] = member(store, "take_ns");
+  m_phase_ns[static_cast<std::size_t>(Phase::Wait)] = member(store, "wait_ns");
+  m_phase_ns[static_cast<std::size_t>(Phase::Pace)] = member(store, "pace_ns");
+  m_phase_ns[static_cast<std::size_t>(Phase::Convert)] = member(store, "convert_ns");
+  m_bytes_published = member(store, "bytes_published");
+  m_lockstep_timeouts_out = member(store, "lockstep_timeouts");
+  m_jitter_ns_out = member(store, "jitter_ns");
+  m_overruns_out = member(store, "overruns");
+
+  m_topic_samples.clear();
+  m_topic_rejects.clear();
+  for (const auto& name : read_topics) {
+    auto topic = store["sub"][name];
+    m_topic_samples.push_back(member(topic, "samples"));
+    m_topic_rejects.push_back(member(topic, "rejects"));
+  }
+  m_samples.assign(read_topics.size(), 0);
+  m_rejects.assign(read_topics.size(), 0);
+  m_last_rejects.assign(read_topics.size(), 0);
+
+  m_origin_ticks = ticks();
+  m_origin_time = std::chrono::steady_clock::now();
+  m_ns_per_tick = 1.0;
+}
+
+void StepDiagnostics::unbind() {
+  m_step_ns = nullptr;
+  m_bytes_published = nullptr;
+  m_lockstep_timeouts_out = nullptr;
+  m_jitter_ns_out = nullptr;
+  m_overruns_out = nullptr;
+  for (auto& phase : m_phase_ns) { phase = nullptr; }
+  m_topic_samples.clear();
+  m_topic_rejects.clear();
+  m_samples.clear();
+  m_rejects.clear();
+  m_last_rejects.clear();
+}
+
+void StepDiagnostics::end_step() {
+  const std::uint64_t end = ticks();
+
+  // Refine the tick period with the time elapsed since bind()
+  const auto elapsed = std::chrono::duration<double, std::nano>(
+                         std::chrono::steady_clock::now() - m_origin_time)
+                         .count();
+  if (end > m_origin_ticks && elapsed > 0.0) {
+    m_ns_per_tick = elapsed / static_cast<double>(end - m_origin_ticks);
+  }
+
+  *m_step_ns = to_ns(end - m_step_begin);
+  for (std::size_t i = 0; i < static_cast<std::size_t>(Phase::Count); ++i) {
+    *m_phase_ns[i] = to_ns(m_phase_ticks[i]);
+  }
+  *m_bytes_published = m_bytes;
+  *m_lockstep_timeouts_out = m_lockstep_timeouts;
+  *m_jitter_ns_out = m_jitter_ns;
+  *m_overruns_out = m_overruns;
+
+  for (std::size_t i = 0; i < m_samples.size(); ++i) {
+    *m_topic_samples[i] = m_samples[i];
+    // Totals restart when filters are recreated
+    *m_topic_rejects[i] =
+      m_rejects[i] >= m_last_rejects[i] ? m_rejects[i] - m_last_rejects[i] : m_rejects[i];
+    m_last_rejects[i] = m_rejects[i];
+  }
+}
+
+}
+}
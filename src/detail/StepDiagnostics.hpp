@@ -0,0 +1,184 @@
+#pragma once
+
+/*
+  Copyright 2023, SINTEF Ocean
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define DDSFMU_HAS_TSC
+#elif defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define DDSFMU_HAS_TSC
+#endif
+
+#include <xtypes/xtypes.hpp>
+
+namespace ddsfmu {
+namespace detail {
+
+/**
+   @brief Creates the type of the diagnostics data store
+
+   The members are FMU outputs named `diag.<member>`. All members are `uint64`, so they are
+   mapped to Real. Per topic counters are named `diag.sub.<topic>.samples` and
+   `diag.sub.<topic>.rejects` for each FMU output topic.
+
+   @param [in] read_topics Topic names of `<fmu_out>` in order of the ddsfmu mapping
+   @return Structure type of diagnostics
+*/
+eprosima::xtypes::StructType diagnostics_type(const std::vector<std::string>& read_topics);
+
+/**
+   @brief Per step timing and counters of FmuInstance::DoStep
+
+   Timing uses the time stamp counter where available, otherwise std::chrono::steady_clock.
+   Ticks are converted to nanoseconds at the end of each step, by the ratio of elapsed
+   steady_clock time and ticks since bind(). Values are written directly to the
+   diagnostics data store, such that they are read as FMU outputs. All values are those of
+   the last step.
+
+   Instrumented code checks enabled() or a null pointer, such that the overhead is a branch
+   when diagnostics are disabled.
+*/
+class StepDiagnostics {
+public:
+  enum class Phase {
+    Write,   ///< DynamicPubSub::write()
+    Take,    ///< DynamicPubSub::take()
+    Wait,    ///< DynamicPubSub::wait()
+    Pace,    ///< Sleeping of real-time pacing
+    Convert, ///< Conversions between xtypes and fast-dds within write and take
+    Count
+  };
+
+  /// Monotonic tick count
+  static inline std::uint64_t ticks() {
+#ifdef DDSFMU_HAS_TSC
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                        std::chrono::steady_clock::now().time_since_epoch())
+                                        .count());
+#endif
+  }
+
+  /**
+     @brief Enables diagnostics with outputs in a data store
+
+     @param [in] store Data store of type diagnostics_type(), which must outlive the binding
+     @param [in] read_topics FMU output topics, as given to diagnostics_type()
+  */
+  void bind(
+    eprosima::xtypes::WritableDynamicDataRef& store, const std::vector<std::string>& read_topics);
+
+  /// Disables diagnostics and releases the data store
+  void unbind();
+
+  inline bool enabled() const { return m_step_ns != nullptr; }
+
+  inline void begin_step() {
+    m_step_begin = ticks();
+    for (auto& phase : m_phase_ticks) { phase = 0; }
+    m_bytes = 0;
+    m_lockstep_timeouts = 0;
+    for (auto& samples : m_samples) { samples = 0; }
+  }
+
+  inline void add_ticks(Phase phase, std::uint64_t ticks) {
+    m_phase_ticks[static_cast<std::size_t>(phase)] += ticks;
+  }
+  inline void add_bytes(std::uint64_t bytes) { m_bytes += bytes; }
+  inline void add_lockstep_timeout() { ++m_lockstep_timeouts; }
+
+  /**
+     @brief Sets the results of real-time pacing of the step
+
+     @param [in] jitter_ns Deviation of the step start from its deadline in nanoseconds
+     @param [in] overruns Number of overruns since pacing started
+  */
+  inline void set_pacing(std::uint64_t jitter_ns, std::uint64_t overruns) {
+    m_jitter_ns = jitter_ns;
+    m_overruns = overruns;
+  }
+
+  /**
+     @brief Counts samples taken for an FMU output topic
+
+     @param [in] topic Index of topic in read_topics, which is its data store index
+     @param [in] samples Number of samples
+  */
+  inline void add_samples(std::size_t topic, std::uint64_t samples) {
+    m_samples.at(topic) += samples;
+  }
+
+  /**
+     @brief Sets the total number of samples rejected by the key filter of a topic
+
+     @param [in] topic Index of topic in read_topics, which is its data store index
+     @param [in] total Number of rejected samples since the filter was created
+  */
+  inline void set_rejects(std::size_t topic, std::uint64_t total) {
+    m_rejects.at(topic) = total;
+  }
+
+  /// Writes the values of the step to the diagnostics data store
+  void end_step();
+
+private:
+  std::uint64_t to_ns(std::uint64_t ticks) const {
+    return static_cast<std::uint64_t>(static_cast<double>(ticks) * m_ns_per_tick);
+  }
+
+  std::uint64_t m_step_begin = 0;
+  std::uint64_t m_phase_ticks[static_cast<std::size_t>(Phase::Count)] = {};
+  std::uint64_t m_bytes = 0;
+  std::uint64_t m_lockstep_timeouts = 0;
+  std::uint64_t m_jitter_ns = 0, m_overruns = 0;
+  std::vector<std::uint64_t> m_samples, m_rejects, m_last_rejects;
+
+  // Calibration of ticks against steady_clock
+  std::uint64_t m_origin_ticks = 0;
+  std::chrono::steady_clock::time_point m_origin_time;
+  double m_ns_per_tick = 1.0;
+
+  // Members of the data store
+  std::uint64_t* m_step_ns = nullptr;
+  std::uint64_t* m_phase_ns[static_cast<std::size_t>(Phase::Count)] = {};
+  std::uint64_t* m_bytes_published = nullptr;
+  std::uint64_t* m_lockstep_timeouts_out = nullptr;
+  std::uint64_t* m_jitter_ns_out = nullptr;
+  std::uint64_t* m_overruns_out = nullptr;
+  std::vector<std::uint64_t*> m_topic_samples, m_topic_rejects;
+};
+
+/// Adds the ticks of its scope to a phase, or does nothing if diagnostics are disabled
+class PhaseTimer {
+public:
+  PhaseTimer(StepDiagnostics& diagnostics, StepDiagnostics::Phase phase)
+      : m_diagnostics(diagnostics.enabled() ? &diagnostics : nullptr)
+      , m_phase(phase)
+      , m_begin(m_diagnostics ? StepDiagnostics::ticks() : 0) {}
+  ~PhaseTimer() {
+    if (m_diagnostics) { m_diagnostics->add_ticks(m_phase, StepDiagnostics::ticks() - m_begin); }
+  }
+  PhaseTimer(const PhaseTimer&) = delete;
+  PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+private:
+  StepDiagnostics* m_diagnostics;
+  StepDiagnostics::Phase m_phase;
+  std::uint64_t m_begin;
+};
+
+}
+}
@@ -0,0 +1,147 @@
+/*
+  Copyright 2023, SINTEF Ocean
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "StoreArena.hpp"
+
+#include <stdexcept>
+
+namespace ddsfmu {
+namespace detail {
+
+namespace {
+
+  /// Alignment of each instance, as for memory from operator new
+  constexpr std::size_t InstanceAlignment = alignof(std::max_align_t);
+
+  constexpr std::size_t align_up(std::size_t offset) {
+    return (offset + InstanceAlignment - 1) / InstanceAlignment * InstanceAlignment;
+  }
+
+  /// Default constructs an instance at its address, keeping bounded sequence memory
+  void reset_instance(eprosima::xtypes::WritableDynamicDataRef data) {
+    namespace ex = eprosima::xtypes;
+    const ex::DynamicType& type = data.type();
+    auto* instance = reinterpret_cast<std::uint8_t*>(data.instance_id());
+
+    switch (type.kind()) {
+    case ex::TypeKind::STRUCTURE_TYPE:
+      if (!is_plain_type(type)) {
+        for (const ex::Member& member : static_cast<const ex::StructType&>(type).members()) {
+          reset_instance(data[member.name()]);
+        }
+        return;
+      }
+      break;
+    case ex::TypeKind::ARRAY_TYPE:
+      if (!is_plain_type(type)) {
+        for (std::size_t i = 0; i < data.size(); ++i) { reset_instance(data[i]); }
+        return;
+      }
+      break;
+    case ex::TypeKind::SEQUENCE_TYPE:
+      if (is_bounded_sequence(type)) {
+        for (std::size_t i = 0; i < data.size(); ++i) { reset_instance(data[i]); }
+        return;
+      }
+      break;
+    default: break;
+    }
+
+    type.destroy_instance(instance);
+    type.construct_instance(instance);
+  }
+
+}
+
+bool is_plain_type(const eprosima::xtypes::DynamicType& type) {
+  namespace ex = eprosima::xtypes;
+  if (type.is_primitive_type() || type.is_enumerated_type()) { return true; }
+
+  switch (type.kind()) {
+  case ex::TypeKind::ARRAY_TYPE:
+    return is_plain_type(static_cast<const ex::ArrayType&>(type).content_type());
+  case ex::TypeKind::STRUCTURE_TYPE:
+    for (const ex::Member& member : static_cast<const ex::StructType&>(type).members()) {
+      if (!is_plain_type(member.type())) { return false; }
+    }
+    return true;
+  default: return false;
+  }
+}
+
+bool is_bounded_sequence(const eprosima::xtypes::DynamicType& type) {
+  return type.kind() == eprosima::xtypes::TypeKind::SEQUENCE_TYPE
+         && static_cast<const eprosima::xtypes::SequenceType&>(type).bounds() > 0;
+}
+
+void expand_bounded_sequences(eprosima::xtypes::WritableDynamicDataRef data) {
+  namespace ex = eprosima::xtypes;
+  const ex::DynamicType& type = data.type();
+
+  switch (type.kind()) {
+  case ex::TypeKind::STRUCTURE_TYPE:
+    for (const ex::Member& member : static_cast<const ex::StructType&>(type).members()) {
+      expand_bounded_sequences(data[member.name()]);
+    }
+    break;
+  case ex::TypeKind::ARRAY_TYPE:
+    if (is_plain_type(type)) { break; }
+    for (std::size_t i = 0; i < data.size(); ++i) { expand_bounded_sequences(data[i]); }
+    break;
+  case ex::TypeKind::SEQUENCE_TYPE: {
+    if (!is_bounded_sequence(type)) { break; }
+    const std::size_t bound = static_cast<const ex::SequenceType&>(type).bounds();
+    if (data.size() < bound) { data.resize(bound); }
+    for (std::size_t i = 0; i < bound; ++i) { expand_bounded_sequences(data[i]); }
+    break;
+  }
+  default: break;
+  }
+}
+
+std::size_t StoreArena::add(const eprosima::xtypes::DynamicType& type) {
+  if (m_memory) { throw std::logic_error("Cannot add type to allocated StoreArena"); }
+
+  m_slots.push_back(Slot{&type, m_bytes});
+  m_bytes = align_up(m_bytes + type.memory_size());
+  m_plain = m_plain && is_plain_type(type);
+  return m_slots.size() - 1;
+}
+
+void StoreArena::allocate() {
+  if (m_memory) { throw std::logic_error("StoreArena is already allocated"); }
+
+  // Zero initialized, such that padding between instances has defined values
+  m_memory = std::make_unique<std::uint8_t[]>(m_bytes);
+
+  for (const auto& slot : m_slots) {
+    std::uint8_t* instance = m_memory.get() + slot.offset;
+    slot.type->construct_instance(instance);
+    m_instances.emplace_back(*slot.type, instance);
+    expand_bounded_sequences(m_instances.back());
+  }
+}
+
+void StoreArena::clear() {
+  if (m_memory) {
+    for (const auto& slot : m_slots) { slot.type->destroy_instance(m_memory.get() + slot.offset); }
+  }
+  m_instances.clear();
+  m_memory.reset();
+  m_slots.clear();
+  m_bytes = 0;
+  m_plain = true;
+}
+
+void StoreArena::reset_defaults() {
+  if (!m_memory) { return; }
+
+  for (auto& instance : m_instances) { reset_instance(instance); }
+}
+
+}
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+/*
+  Copyright 2023, SINTEF Ocean
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include <xtypes/DynamicData.hpp>
+
+namespace ddsfmu {
+namespace detail {
+
+/**
+   @brief Contiguous storage of xtypes instances
+
+   Each xtypes::DynamicData allocates its own instance memory. The arena instead lays out
+   all instances in one block of memory, which is allocated once all types are known.
+   Instances are accessed through references deriving from xtypes::WritableDynamicDataRef,
+   which remain valid until clear() is called. Bounded sequences are resized to their bound
+   when constructed, such that their elements are allocated once and never move, see
+   expand_bounded_sequences().
+
+   Usage: add() each type, then allocate() and access instances with operator[].
+*/
+class StoreArena {
+public:
+  /// Reference to an instance owned by the arena
+  class Instance : public eprosima::xtypes::WritableDynamicDataRef {
+  public:
+    Instance(const eprosima::xtypes::DynamicType& type, std::uint8_t* source)
+        : eprosima::xtypes::WritableDynamicDataRef(type, source) {}
+  };
+
+  StoreArena() = default;
+  StoreArena(const StoreArena&) = delete;            ///< Copy constructor
+  StoreArena& operator=(const StoreArena&) = delete; ///< Copy assignment
+  ~StoreArena() { clear(); }
+
+  /**
+     @brief Reserves space for an instance of a type
+
+     The type must outlive the arena, or until clear() is called.
+
+     @param [in] type Type of instance
+     @return Index of the instance
+  */
+  std::size_t add(const eprosima::xtypes::DynamicType& type);
+
+  /**
+     @brief Allocates memory and constructs all instances with default values
+
+     Throws std::logic_error if already allocated.
+  */
+  void allocate();
+
+  /// Destroys all instances and releases the memory
+  void clear();
+
+  /**
+     @brief Assigns default values to all instances in place
+
+     Members are destroyed and default constructed at their address, except bounded
+     sequences, which keep their memory and have each element reset in place.
+  */
+  void reset_defaults();
+
+  inline Instance& operator[](std::size_t index) { return m_instances.at(index); }
+  inline const Instance& operator[](std::size_t index) const { return m_instances.at(index); }
+  inline std::size_t size() const { return m_slots.size(); }
+
+  /// True if all instances can be copied as a single block, see data()
+  inline bool is_plain() const { return m_plain; }
+  inline const std::uint8_t* data() const { return m_memory.get(); } ///< Start of arena memory
+  inline std::uint8_t* data() { return m_memory.get(); }             ///< Start of arena memory
+  inline std::size_t bytes() const { return m_bytes; } ///< Size of arena memory
+
+private:
+  struct Slot {
+    const eprosima::xtypes::DynamicType* type;
+    std::size_t offset;
+  };
+  std::vector<Slot> m_slots;
+  std::deque<Instance> m_instances; ///< Stable references, constructed in place
+  std::unique_ptr<std::uint8_t[]> m_memory;
+  std::size_t m_bytes = 0;
+  bool m_plain = true;
+};
+
+/// True if instances of the type can be copied as a single block of memory
+bool is_plain_type(const eprosima::xtypes::DynamicType& type);
+
+/**
+   @brief Resizes all bounded sequences of an instance to their bound
+
+   Nested members are expanded recursively. Unbounded sequences are left empty.
+
+   @param [in] data Instance to expand
+*/
+void expand_bounded_sequences(eprosima::xtypes::WritableDynamicDataRef data);
+
+/// True if the type is a sequence with a bound, i.e. `sequence<T, N>` in IDL
+bool is_bounded_sequence(const eprosima::xtypes::DynamicType& type);
+
+}
+}
@@ -0,0 +1,150 @@
+/*
+  Copyright 2023, SINTEF Ocean
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "Tracer.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace ddsfmu {
+namespace detail {
+
+namespace {
+
+  std::atomic<std::uint64_t> tracer_serial{0};
+
+  void write_escaped(std::ostream& out, const std::string& text) {
+    for (char c : text) {
+      if (c == '"' || c == '\\') { out << '\\'; }
+      out << c;
+    }
+  }
+
+  void write_us(std::ostream& out, std::uint64_t ns) {
+    out << ns / 1000 << '.' << std::setw(3) << std::setfill('0') << ns % 1000;
+  }
+
+}
+
+void TraceRing::snapshot(std::vector<TraceEvent>& events) const {
+  const auto head = m_head.load(std::memory_order_acquire);
+  // The slot of the oldest event is the next one to be overwritten
+  const auto first = head >= Capacity ? head - Capacity + 1 : 0;
+  std::uint64_t words[Slot::Words];
+  TraceEvent event;
+
+  for (auto i = first; i < head; ++i) {
+    const auto& slot = m_slots[i & (Capacity - 1)];
+    if (slot.sequence.load(std::memory_order_acquire) != 2 * i + 2) { continue; }
+    for (std::size_t j = 0; j < Slot::Words; ++j) {
+      words[j] = slot.words[j].load(std::memory_order_relaxed);
+    }
+    // Discard the event if it was overwritten while copying
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) != 2 * i + 2) { continue; }
+
+    std::memcpy(&event, words, sizeof(TraceEvent));
+    events.push_back(event);
+  }
+}
+
+Tracer::Tracer(std::filesystem::path output)
+    : m_output(std::move(output))
+    , m_enabled(!m_output.empty())
+    , m_serial(++tracer_serial)
+    , m_origin_ns(now_ns()) {}
+
+Tracer::~Tracer() { dump(); }
+
+Tracer& Tracer::instance() {
+  static Tracer* tracer = [] {
+    const char* output = std::getenv("DDSFMU_TRACE");
+    auto* created = new Tracer(output ? output : "");
+    if (created->enabled()) {
+      std::atexit([] { Tracer::instance().dump(); });
+    }
+    return created;
+  }();
+  return *tracer;
+}
+
+std::uint32_t Tracer::add_instance(const std::string& name) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_instance_names.push_back(name);
+  return static_cast<std::uint32_t>(m_instance_names.size());
+}
+
+void Tracer::name_topic(std::uint32_t instance, std::uint32_t topic, const std::string& name) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_topic_names[{instance, topic}] = name;
+}
+
+TraceRing& Tracer::register_thread() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_rings.push_back(std::make_unique<TraceRing>(static_cast<std::uint32_t>(m_rings.size() + 1)));
+  return *m_rings.back();
+}
+
+bool Tracer::dump() const {
+  if (!m_enabled) { return false; }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::ofstream out(m_output, std::ios::trunc);
+  if (!out) {
+    std::cerr << "dds-fmu: Unable to write trace to " << m_output.string() << std::endl;
+    return false;
+  }
+
+  out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  bool first = true;
+  for (std::size_t i = 0; i < m_instance_names.size(); ++i) {
+    out << (first ? "\n" : ",\n");
+    first = false;
+    out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << i + 1
+        << ",\"args\":{\"name\":\"";
+    write_escaped(out, m_instance_names[i]);
+    out << "\"}}";
+  }
+
+  std::vector<TraceEvent> events;
+  for (const auto& ring : m_rings) {
+    events.clear();
+    ring->snapshot(events);
+    for (const auto& event : events) {
+      out << (first ? "\n" : ",\n");
+      first = false;
+      out << "{\"name\":\"" << event.name << "\",\"cat\":\"ddsfmu\",\"ph\":\"" << event.phase
+          << "\",\"pid\":" << event.instance << ",\"tid\":" << ring->thread_id() << ",\"ts\":";
+      write_us(out, event.begin_ns - std::min(event.begin_ns, m_origin_ns));
+      if (event.phase == 'X') {
+        out << ",\"dur\":";
+        write_us(out, event.duration_ns);
+      } else {
+        out << ",\"s\":\"t\"";
+      }
+      if (event.topic != TraceEvent::NoTopic) {
+        out << ",\"args\":{\"topic\":" << event.topic;
+        auto name = m_topic_names.find({event.instance, event.topic});
+        if (name != m_topic_names.end()) {
+          out << ",\"topic_name\":\"";
+          write_escaped(out, name->second);
+          out << '"';
+        }
+        out << '}';
+      }
+      out << '}';
+    }
+  }
+  out << "\n]}\n";
+  return static_cast<bool>(out);
+}
+
+}
+}
@@ -0,0 +1,274 @@
+#pragma once
+
+/*
+  Copyright 2023, SINTEF Ocean
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ddsfmu {
+namespace detail {
+
+/// A traced event, as in the Chrome trace event format
+struct TraceEvent {
+  static constexpr std::uint32_t NoTopic = 0xffffffff;
+  static constexpr std::uint32_t NoInstance = 0;
+
+  const char* name;          ///< Static string
+  std::uint64_t begin_ns;    ///< Time stamp of steady_clock
+  std::uint64_t duration_ns; ///< Zero for instant events
+  std::uint32_t instance;    ///< Identifier from Tracer::add_instance(), or NoInstance
+  std::uint32_t topic;       ///< Data store index of the instance, or NoTopic
+  char phase;                ///< 'X' for complete events, 'i' for instant events
+};
+
+/**
+   @brief Fixed size ring buffer of trace events recorded by a single thread
+
+   Only the owning thread pushes events, so recording is wait-free. When full, the oldest
+   events are overwritten. Other threads may copy the events with snapshot() at any time:
+   each slot is published with a sequence number, and slots that are being overwritten
+   during the copy are skipped.
+*/
+class TraceRing {
+public:
+  static constexpr std::size_t Capacity = 1 << 16; ///< Number of events, a power of two
+
+  TraceRing(std::uint32_t thread_id) : m_slots(Capacity), m_thread_id(thread_id) {}
+
+  inline void push(const TraceEvent& event) {
+    const auto head = m_head.load(std::memory_order_relaxed);
+    auto& slot = m_slots[head & (Capacity - 1)];
+
+    std::uint64_t words[Slot::Words];
+    std::memcpy(words, &event, sizeof(TraceEvent));
+
+    // An odd sequence number marks the slot as being written
+    slot.sequence.store(2 * head + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (std::size_t i = 0; i < Slot::Words; ++i) {
+      slot.words[i].store(words[i], std::memory_order_relaxed);
+    }
+    slot.sequence.store(2 * head + 2, std::memory_order_release);
+    m_head.store(head + 1, std::memory_order_release);
+  }
+
+  /**
+     @brief Appends the recorded events, oldest first
+
+     Events that may have been overwritten during the copy are discarded.
+
+     @param [in, out] events Vector to append events to
+  */
+  void snapshot(std::vector<TraceEvent>& events) const;
+
+  inline std::uint32_t thread_id() const { return m_thread_id; }
+
+private:
+  static_assert(std::is_trivially_copyable<TraceEvent>::value);
+
+  /// Event stored as atomic words, such that it may be read while being overwritten
+  struct Slot {
+    static constexpr std::size_t Words = (sizeof(TraceEvent) + 7) / 8;
+
+    std::atomic<std::uint64_t> sequence{0}; ///< 2 * index + 2 of the complete event
+    std::atomic<std::uint64_t> words[Words] = {};
+  };
+
+  std::vector<Slot> m_slots;
+  std::atomic<std::uint64_t> m_head{0}; ///< Number of events pushed since construction
+  std::uint32_t m_thread_id;
+};
+
+/**
+   @brief Event tracing of the publish and receive pipeline
+
+   Tracing is compiled in with the CMake option DDSFMU_WITH_TRACING, and enabled at runtime
+   by setting the environment variable DDSFMU_TRACE to the path of the output file. Each
+   thread records to its own TraceRing, independent of the fast-dds log and FmiLogger. The
+   events are written as Chrome trace event JSON by dump(), which can be opened in
+   chrome://tracing or https://ui.perfetto.dev.
+
+   Events of each FMU instance are written with its identifier as process id, since several
+   instances may share the process and thereby the tracer.
+
+   Use the macros DDSFMU_TRACE_SCOPE and DDSFMU_TRACE_INSTANT, which expand to nothing if
+   tracing is not compiled in.
+*/
+class Tracer {
+public:
+  /**
+     @brief Creates a tracer writing to a file
+
+     @param [in] output Path of Chrome trace JSON, or an empty path to disable tracing
+  */
+  explicit Tracer(std::filesystem::path output);
+  Tracer(const Tracer&) = delete;            ///< Copy constructor
+  Tracer& operator=(const Tracer&) = delete; ///< Copy assignment
+  ~Tracer();                                 ///< Calls dump() if enabled
+
+  /**
+     @brief Process wide tracer, configured by the environment variable DDSFMU_TRACE
+
+     The instance is never destroyed, since fast-dds threads may record events during
+     static destruction. It is dumped at exit, and FmuInstance dumps it on Terminate.
+  */
+  static Tracer& instance();
+
+  static inline std::uint64_t now_ns() {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                        std::chrono::steady_clock::now().time_since_epoch())
+                                        .count());
+  }
+
+  inline bool enabled() const { return m_enabled; }
+
+  /// Records an event with duration, ending now
+  inline void complete(
+    const char* name, std::uint64_t begin_ns, std::uint32_t instance, std::uint32_t topic) {
+    ring().push({name, begin_ns, now_ns() - begin_ns, instance, topic, 'X'});
+  }
+
+  /// Records an event without duration
+  inline void instant(const char* name, std::uint32_t instance, std::uint32_t topic) {
+    ring().push({name, now_ns(), 0, instance, topic, 'i'});
+  }
+
+  /**
+     @brief Adds an FMU instance, which is written as a process of the trace
+
+     @param [in] name Instance name
+     @return Identifier of the instance, never NoInstance
+  */
+  std::uint32_t add_instance(const std::string& name);
+
+  /**
+     @brief Names a topic identifier, which is added to the arguments of its events
+
+     @param [in] instance Identifier from add_instance()
+     @param [in] topic Data store index
+     @param [in] name Topic name
+  */
+  void name_topic(std::uint32_t instance, std::uint32_t topic, const std::string& name);
+
+  /**
+     @brief Writes all recorded events to the output file
+
+     The events are kept, such that a later dump includes them as well. Does nothing if
+     tracing is disabled.
+
+     @return true if the file was written
+  */
+  bool dump() const;
+
+private:
+  /// Ring of the calling thread, which is created on first use
+  inline TraceRing& ring() {
+    struct Cache {
+      std::uint64_t serial = 0;
+      TraceRing* ring = nullptr;
+    };
+    thread_local Cache cache;
+    if (cache.serial != m_serial) {
+      cache.ring = &register_thread();
+      cache.serial = m_serial;
+    }
+    return *cache.ring;
+  }
+
+  TraceRing& register_thread();
+
+  std::filesystem::path m_output;
+  bool m_enabled;
+  std::uint64_t m_serial; ///< Distinguishes tracers in thread local caches
+  std::uint64_t m_origin_ns;
+  mutable std::mutex m_mutex; ///< Guards members below, never held while recording
+  std::vector<std::unique_ptr<TraceRing>> m_rings;
+  std::vector<std::string> m_instance_names; ///< Indexed by instance identifier - 1
+  std::map<std::pair<std::uint32_t, std::uint32_t>, std::string> m_topic_names;
+};
+
+/// Records a complete event from construction to destruction
+class TraceScope {
+public:
+  TraceScope(
+    const char* name, std::uint32_t instance = TraceEvent::NoInstance,
+    std::uint32_t topic = TraceEvent::NoTopic)
+      : m_name(name), m_instance(instance), m_topic(topic), m_begin(0) {
+    if (Tracer::instance().enabled()) { m_begin = Tracer::now_ns(); }
+  }
+  ~TraceScope() {
+    if (m_begin != 0) { Tracer::instance().complete(m_name, m_begin, m_instance, m_topic); }
+  }
+  TraceScope(const TraceScope&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+  const char* m_name;
+  std::uint32_t m_instance;
+  std::uint32_t m_topic;
+  std::uint64_t m_begin;
+};
+
+}
+}
+
+#define DDSFMU_TRACE_CONCAT_(a, b) a##b
+#define DDSFMU_TRACE_CONCAT(a, b) DDSFMU_TRACE_CONCAT_(a, b)
+
+#ifdef DDSFMU_WITH_TRACING
+/// Traces the enclosing scope as an event with name, and optional instance and topic identifiers
+#define DDSFMU_TRACE_SCOPE(...)                                                                   \
+  ::ddsfmu::detail::TraceScope DDSFMU_TRACE_CONCAT(ddsfmu_trace_scope_, __LINE__)(__VA_ARGS__)
+/// Traces an instant event with name, instance and topic identifiers
+#define DDSFMU_TRACE_INSTANT(name, instance, topic)                                               \
+  do {                                                                                            \
+    auto& ddsfmu_tracer = ::ddsfmu::detail::Tracer::instance();                                   \
+    if (ddsfmu_tracer.enabled()) { ddsfmu_tracer.instant(name, instance, topic); }                \
+  } while (false)
+/// Assigns the identifier of a new instance with a name in the trace
+#define DDSFMU_TRACE_INSTANCE(instance, name)                                                     \
+  do {                                                                                            \
+    auto& ddsfmu_tracer = ::ddsfmu::detail::Tracer::instance();                                   \
+    if (ddsfmu_tracer.enabled()) { instance = ddsfmu_tracer.add_instance(name); }                 \
+  } while (false)
+/// Names a topic identifier of an instance in the trace
+#define DDSFMU_TRACE_TOPIC(instance, topic, name)                                                 \
+  do {                                                                                            \
+    auto& ddsfmu_tracer = ::ddsfmu::detail::Tracer::instance();                                   \
+    if (ddsfmu_tracer.enabled()) { ddsfmu_tracer.name_topic(instance, topic, name); }             \
+  } while (false)
+/// Writes the trace of the process, if enabled
+#define DDSFMU_TRACE_DUMP() ::ddsfmu::detail::Tracer::instance().dump()
+#else
+#define DDSFMU_TRACE_SCOPE(...)                                                                   \
+  do {                                                                                            \
+  } while (false)
+#define DDSFMU_TRACE_INSTANT(name, instance, topic)                                               \
+  do {                                                                                            \
+  } while (false)
+#define DDSFMU_TRACE_INSTANCE(instance, name)                                                     \
+  do {                                                                                            \
+  } while (false)
+#define DDSFMU_TRACE_TOPIC(instance, topic, name)                                                 \
+  do {                                                                                            \
+  } while (false)
+#define DDSFMU_TRACE_DUMP()                                                                       \
+  do {                                                                                            \
+  } while (false)
+#endif
@@ -0,0 +1,389 @@
+/*
+  Copyright 2023, SINTEF Ocean
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "TypeObjects.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <stdexcept>
+#include <utility>
+
+#include <fastcdr/Cdr.h>
+#include <fastcdr/FastBuffer.h>
+#include <fastcdr/exceptions/Exception.h>
+#include <fastrtps/types/TypeNamesGenerator.h>
+#include <fastrtps/types/TypeObjectFactory.h>
+#include <fastrtps/types/TypesBase.h>
+#include <fastrtps/utils/md5.h>
+
+namespace ddsfmu {
+namespace detail {
+
+namespace {
+
+  namespace ex = eprosima::xtypes;
+  namespace ft = eprosima::fastrtps::types;
+
+  /// Format of files written by TypeObjectBundle::save()
+  constexpr std::uint32_t FormatVersion = 1;
+
+  /// Name of a primitive type in the TypeObjectFactory, or nullptr for other types
+  const char* primitive_name(const ex::DynamicType& type) {
+    switch (type.kind()) {
+    case ex::TypeKind::BOOLEAN_TYPE: return ft::TKNAME_BOOLEAN;
+    case ex::TypeKind::INT_8_TYPE:
+    case ex::TypeKind::UINT_8_TYPE: return ft::TKNAME_BYTE; // Bytes in Converter
+    case ex::TypeKind::INT_16_TYPE: return ft::TKNAME_INT16;
+    case ex::TypeKind::UINT_16_TYPE: return ft::TKNAME_UINT16;
+    case ex::TypeKind::INT_32_TYPE: return ft::TKNAME_INT32;
+    case ex::TypeKind::UINT_32_TYPE: return ft::TKNAME_UINT32;
+    case ex::TypeKind::INT_64_TYPE: return ft::TKNAME_INT64;
+    case ex::TypeKind::UINT_64_TYPE: return ft::TKNAME_UINT64;
+    case ex::TypeKind::FLOAT_32_TYPE: return ft::TKNAME_FLOAT32;
+    case ex::TypeKind::FLOAT_64_TYPE: return ft::TKNAME_FLOAT64;
+    case ex::TypeKind::FLOAT_128_TYPE: return ft::TKNAME_FLOAT128;
+    case ex::TypeKind::CHAR_8_TYPE: return ft::TKNAME_CHAR8;
+    case ex::TypeKind::CHAR_16_TYPE:
+    case ex::TypeKind::WIDE_CHAR_TYPE: return ft::TKNAME_CHAR16;
+    default: return nullptr;
+    }
+  }
+
+  /// Dimensions of nested arrays and their element type
+  const ex::DynamicType&
+    array_dimensions(const ex::ArrayType& array, std::vector<uint32_t>& dims) {
+    dims.push_back(array.dimension());
+    if (array.content_type().kind() == ex::TypeKind::ARRAY_TYPE) {
+      return array_dimensions(static_cast<const ex::ArrayType&>(array.content_type()), dims);
+    }
+    return array.content_type();
+  }
+
+  /// First four bytes of the MD5 hash of a member name
+  void name_hash(ft::NameHash& hash, const std::string& name) {
+    eprosima::fastrtps::MD5 md5(name);
+    std::copy_n(md5.digest, hash.size(), hash.begin());
+  }
+
+  /// First 14 bytes of the MD5 hash of a TypeObject serialized as little endian CDR
+  void equivalence_hash(ft::TypeIdentifier& identifier, const ft::TypeObject& object) {
+    eprosima::fastcdr::FastBuffer buffer;
+    eprosima::fastcdr::Cdr cdr(
+      buffer, eprosima::fastcdr::Cdr::LITTLE_ENDIANNESS, eprosima::fastcdr::Cdr::DDS_CDR);
+    object.serialize(cdr);
+
+    eprosima::fastrtps::MD5 md5;
+    md5.update(buffer.getBuffer(), static_cast<std::uint32_t>(cdr.getSerializedDataLength()));
+    md5.finalize();
+    std::copy_n(md5.digest, identifier.equivalence_hash().size(),
+                identifier.equivalence_hash().begin());
+  }
+
+}
+
+const ft::TypeIdentifier*
+  TypeObjectBundle::identifier(const ex::DynamicType& type, bool complete) {
+  auto* factory = ft::TypeObjectFactory::get_instance();
+
+  if (const char* primitive = primitive_name(type)) {
+    return factory->get_type_identifier(primitive, false);
+  }
+
+  switch (type.kind()) {
+  case ex::TypeKind::ALIAS_TYPE:
+    return identifier(static_cast<const ex::AliasType&>(type).rget(), complete);
+  case ex::TypeKind::STRING_TYPE:
+    return factory->get_string_identifier(static_cast<const ex::StringType&>(type).bounds(), false);
+  case ex::TypeKind::WSTRING_TYPE:
+    return factory->get_string_identifier(static_cast<const ex::WStringType&>(type).bounds(), true);
+  case ex::TypeKind::SEQUENCE_TYPE: {
+    const auto& sequence = static_cast<const ex::SequenceType&>(type);
+    return factory->get_sequence_identifier(
+      type_name(sequence.content_type()), sequence.bounds(), complete);
+  }
+  case ex::TypeKind::ARRAY_TYPE: {
+    std::vector<uint32_t> dims;
+    const auto& element = array_dimensions(static_cast<const ex::ArrayType&>(type), dims);
+    return factory->get_array_identifier(type_name(element), dims, complete);
+  }
+  case ex::TypeKind::MAP_TYPE: {
+    const auto& map = static_cast<const ex::MapType&>(type);
+    const auto& pair = static_cast<const ex::PairType&>(map.content_type());
+    return factory->get_map_identifier(
+      type_name(pair.first()), type_name(pair.second()), map.bounds(), complete);
+  }
+  case ex::TypeKind::STRUCTURE_TYPE:
+  case ex::TypeKind::UNION_TYPE:
+  case ex::TypeKind::ENUMERATION_TYPE: {
+    add(type);
+    const auto entry = std::find_if(m_entries.begin(), m_entries.end(), [&](const Entry& e) {
+      return e.name == type.name();
+    });
+    return complete ? &entry->complete_id : &entry->minimal_id;
+  }
+  default: break;
+  }
+  throw std::runtime_error("Unsupported kind of type '" + type.name() + "' in TypeObject");
+}
+
+std::string TypeObjectBundle::type_name(const ex::DynamicType& type) {
+  if (const char* primitive = primitive_name(type)) { return primitive; }
+
+  switch (type.kind()) {
+  case ex::TypeKind::ALIAS_TYPE: return type_name(static_cast<const ex::AliasType&>(type).rget());
+  case ex::TypeKind::STRING_TYPE:
+    return ft::TypeNamesGenerator::get_string_type_name(
+      static_cast<const ex::StringType&>(type).bounds(), false, true);
+  case ex::TypeKind::WSTRING_TYPE:
+    return ft::TypeNamesGenerator::get_string_type_name(
+      static_cast<const ex::WStringType&>(type).bounds(), true, true);
+  case ex::TypeKind::SEQUENCE_TYPE: {
+    const auto& sequence = static_cast<const ex::SequenceType&>(type);
+    const std::string content = type_name(sequence.content_type());
+    identifier(type, true);
+    identifier(type, false);
+    return ft::TypeNamesGenerator::get_sequence_type_name(content, sequence.bounds(), false);
+  }
+  case ex::TypeKind::ARRAY_TYPE: {
+    std::vector<uint32_t> dims;
+    const std::string element =
+      type_name(array_dimensions(static_cast<const ex::ArrayType&>(type), dims));
+    identifier(type, true);
+    identifier(type, false);
+    return ft::TypeNamesGenerator::get_array_type_name(element, dims, false);
+  }
+  case ex::TypeKind::MAP_TYPE: {
+    const auto& map = static_cast<const ex::MapType&>(type);
+    const auto& pair = static_cast<const ex::PairType&>(map.content_type());
+    const std::string key = type_name(pair.first());
+    const std::string value = type_name(pair.second());
+    identifier(type, true);
+    identifier(type, false);
+    return ft::TypeNamesGenerator::get_map_type_name(key, value, map.bounds(), false);
+  }
+  default:
+    identifier(type, true); // Named types, or throws for unsupported kinds
+    return type.name();
+  }
+}
+
+void TypeObjectBundle::add(const ex::DynamicType& type) {
+  if (contains(type.name())) { return; }
+
+  switch (type.kind()) {
+  case ex::TypeKind::STRUCTURE_TYPE:
+    add_structure(static_cast<const ex::StructType&>(type));
+    break;
+  case ex::TypeKind::UNION_TYPE: add_union(static_cast<const ex::UnionType&>(type)); break;
+  case ex::TypeKind::ENUMERATION_TYPE: add_enumeration(type); break;
+  default:
+    throw std::runtime_error("Type '" + type.name() + "' is not a structure, union or enum");
+  }
+}
+
+bool TypeObjectBundle::contains(const std::string& name) const {
+  return std::any_of(
+    m_entries.begin(), m_entries.end(), [&](const Entry& entry) { return entry.name == name; });
+}
+
+void TypeObjectBundle::add_structure(const ex::StructType& structure) {
+  Entry entry;
+  entry.name = structure.name();
+
+  entry.complete._d(ft::EK_COMPLETE);
+  entry.complete.complete()._d(ft::TK_STRUCTURE);
+  auto& complete = entry.complete.complete().struct_type();
+  // No extensibility flags, as fastddsgen 2.x and fast-dds dynamic types, for equal hashes
+  complete.header().detail().type_name(structure.name());
+
+  entry.minimal._d(ft::EK_MINIMAL);
+  entry.minimal.minimal()._d(ft::TK_STRUCTURE);
+  auto& minimal = entry.minimal.minimal().struct_type();
+
+  for (std::size_t idx = 0; idx < structure.members().size(); ++idx) {
+    const ex::Member& member = structure.member(idx);
+
+    ft::CommonStructMember common;
+    common.member_id(static_cast<ft::MemberId>(idx));
+    common.member_flags().IS_KEY(member.is_key());
+
+    common.member_type_id(*identifier(member.type(), true));
+    ft::CompleteStructMember complete_member;
+    complete_member.common(common);
+    complete_member.detail().name(member.name());
+    complete.member_seq().push_back(complete_member);
+
+    common.member_type_id(*identifier(member.type(), false));
+    ft::MinimalStructMember minimal_member;
+    minimal_member.common(common);
+    name_hash(minimal_member.detail().name_hash(), member.name());
+    minimal.member_seq().push_back(minimal_member);
+  }
+
+  finish(std::move(entry));
+}
+
+void TypeObjectBundle::add_union(const ex::UnionType& union_type) {
+  Entry entry;
+  entry.name = union_type.name();
+
+  entry.complete._d(ft::EK_COMPLETE);
+  entry.complete.complete()._d(ft::TK_UNION);
+  auto& complete = entry.complete.complete().union_type();
+  // No extensibility flags, as for structures
+  complete.header().detail().type_name(union_type.name());
+  complete.discriminator().common().type_id(*identifier(union_type.discriminator(), true));
+
+  entry.minimal._d(ft::EK_MINIMAL);
+  entry.minimal.minimal()._d(ft::TK_UNION);
+  auto& minimal = entry.minimal.minimal().union_type();
+  minimal.discriminator().common().type_id(*identifier(union_type.discriminator(), false));
+
+  ft::MemberId idx = 0;
+  for (const std::string& name : union_type.get_case_members()) {
+    const ex::Member& member = union_type.member(name);
+
+    ft::CommonUnionMember common;
+    common.member_id(idx++);
+    common.member_flags().IS_DEFAULT(union_type.is_default(name));
+    for (std::int64_t label : union_type.get_labels(name)) {
+      common.label_seq().push_back(static_cast<std::int32_t>(label));
+    }
+
+    common.type_id(*identifier(member.type(), true));
+    ft::CompleteUnionMember complete_member;
+    complete_member.common(common);
+    complete_member.detail().name(name);
+    complete.member_seq().push_back(complete_member);
+
+    common.type_id(*identifier(member.type(), false));
+    ft::MinimalUnionMember minimal_member;
+    minimal_member.common(common);
+    name_hash(minimal_member.detail().name_hash(), name);
+    minimal.member_seq().push_back(minimal_member);
+  }
+
+  finish(std::move(entry));
+}
+
+void TypeObjectBundle::add_enumeration(const ex::DynamicType& enumeration) {
+  Entry entry;
+  entry.name = enumeration.name();
+
+  entry.complete._d(ft::EK_COMPLETE);
+  entry.complete.complete()._d(ft::TK_ENUM);
+  auto& complete = entry.complete.complete().enumerated_type();
+  complete.header().common().bit_bound(32);
+  complete.header().detail().type_name(enumeration.name());
+
+  entry.minimal._d(ft::EK_MINIMAL);
+  entry.minimal.minimal()._d(ft::TK_ENUM);
+  auto& minimal = entry.minimal.minimal().enumerated_type();
+  minimal.header().common().bit_bound(32);
+
+  // Literals in order of value, as declared
+  const auto& enumerators =
+    static_cast<const ex::EnumerationType<uint32_t>&>(enumeration).enumerators();
+  std::vector<std::pair<uint32_t, std::string>> literals;
+  for (const auto& [name, value] : enumerators) { literals.emplace_back(value, name); }
+  std::sort(literals.begin(), literals.end());
+
+  for (const auto& [value, name] : literals) {
+    ft::CommonEnumeratedLiteral common;
+    common.value(static_cast<std::int32_t>(value));
+
+    ft::CompleteEnumeratedLiteral complete_literal;
+    complete_literal.common(common);
+    complete_literal.detail().name(name);
+    complete.literal_seq().push_back(complete_literal);
+
+    ft::MinimalEnumeratedLiteral minimal_literal;
+    minimal_literal.common(common);
+    name_hash(minimal_literal.detail().name_hash(), name);
+    minimal.literal_seq().push_back(minimal_literal);
+  }
+
+  finish(std::move(entry));
+}
+
+void TypeObjectBundle::finish(Entry&& entry) {
+  entry.complete_id._d(ft::EK_COMPLETE);
+  equivalence_hash(entry.complete_id, entry.complete);
+  entry.minimal_id._d(ft::EK_MINIMAL);
+  equivalence_hash(entry.minimal_id, entry.minimal);
+
+  auto* factory = ft::TypeObjectFactory::get_instance();
+  factory->add_type_object(entry.name, &entry.complete_id, &entry.complete);
+  factory->add_type_object(entry.name, &entry.minimal_id, &entry.minimal);
+  m_entries.push_back(std::move(entry));
+}
+
+void TypeObjectBundle::register_types() const {
+  auto* factory = ft::TypeObjectFactory::get_instance();
+  for (const auto& entry : m_entries) {
+    factory->add_type_object(entry.name, &entry.complete_id, &entry.complete);
+    factory->add_type_object(entry.name, &entry.minimal_id, &entry.minimal);
+  }
+}
+
+void TypeObjectBundle::save(const std::filesystem::path& file) const {
+  eprosima::fastcdr::FastBuffer buffer;
+  eprosima::fastcdr::Cdr cdr(
+    buffer, eprosima::fastcdr::Cdr::LITTLE_ENDIANNESS, eprosima::fastcdr::Cdr::DDS_CDR);
+  cdr.serialize_encapsulation();
+  cdr << FormatVersion << static_cast<std::uint32_t>(m_entries.size());
+  for (const auto& entry : m_entries) {
+    cdr << entry.name;
+    entry.complete_id.serialize(cdr);
+    entry.complete.serialize(cdr);
+    entry.minimal_id.serialize(cdr);
+    entry.minimal.serialize(cdr);
+  }
+
+  std::ofstream out(file, std::ios::binary);
+  out.write(buffer.getBuffer(), static_cast<std::streamsize>(cdr.getSerializedDataLength()));
+  if (!out) { throw std::runtime_error("Unable to write TypeObjects to " + file.string()); }
+}
+
+TypeObjectBundle TypeObjectBundle::load(const std::filesystem::path& file) {
+  std::ifstream in(file, std::ios::binary);
+  if (!in) { throw std::runtime_error("Unable to read TypeObjects from " + file.string()); }
+  std::vector<char> data{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+
+  TypeObjectBundle bundle;
+  try {
+    eprosima::fastcdr::FastBuffer buffer(data.data(), data.size());
+    eprosima::fastcdr::Cdr cdr(buffer, eprosima::fastcdr::Cdr::DEFAULT_ENDIAN,
+                               eprosima::fastcdr::Cdr::DDS_CDR);
+    cdr.read_encapsulation();
+
+    std::uint32_t version = 0, count = 0;
+    cdr >> version >> count;
+    if (version != FormatVersion) {
+      throw std::runtime_error(
+        "Unknown format " + std::to_string(version) + " of TypeObjects " + file.string());
+    }
+
+    bundle.m_entries.resize(count);
+    for (auto& entry : bundle.m_entries) {
+      cdr >> entry.name;
+      entry.complete_id.deserialize(cdr);
+      entry.complete.deserialize(cdr);
+      entry.minimal_id.deserialize(cdr);
+      entry.minimal.deserialize(cdr);
+    }
+  } catch (const eprosima::fastcdr::exception::Exception& e) {
+    throw std::runtime_error("Corrupt TypeObjects " + file.string() + ": " + e.what());
+  }
+  return bundle;
+}
+
+}
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+/*
+  Copyright 2023, SINTEF Ocean
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <fastrtps/types/TypeIdentifier.h>
+#include <fastrtps/types/TypeObject.h>
+#include <xtypes/xtypes.hpp>
+
+namespace ddsfmu {
+namespace detail {
+
+/// File name of TypeObjects generated by the repacker, next to dds_profile.xml
+constexpr const char* TypeObjectsFile = "ddsfmu_types.bin";
+
+/**
+   @brief Complete and minimal TypeObjects of IDL types, built from xtypes
+
+   Fast-dds builds TypeObjects from its dynamic types when a type is registered, which
+   crashes for enums, unions and sequences of structures, see DynamicPubSub::create_entities.
+   The bundle instead builds them from xtypes definitions as fastddsgen generated code does,
+   such that the repacker can save them with the FMU and DynamicPubSub can register them at
+   startup. Type information is then announced in discovery, and matching is type-safe.
+
+   Each named type, that is structures, unions and enumerations, gets an entry with hashed
+   type identifiers. Aliases are resolved, as in Converter. Structures and unions have no
+   extensibility flags set, as in TypeObjects of fastddsgen 2.x and of fast-dds dynamic types,
+   since the flags are part of the hashed identifiers that peers compare. Strings and
+   sequences without bounds are given bound zero, which means unbounded in XTypes.
+
+   Building adds the TypeObjects to the fast-dds TypeObjectFactory, since identifiers of
+   collections are looked up there by element type name.
+*/
+class TypeObjectBundle {
+public:
+  /// TypeObjects of a named type
+  struct Entry {
+    std::string name; ///< Scoped type name
+    eprosima::fastrtps::types::TypeIdentifier complete_id;
+    eprosima::fastrtps::types::TypeObject complete;
+    eprosima::fastrtps::types::TypeIdentifier minimal_id;
+    eprosima::fastrtps::types::TypeObject minimal;
+  };
+
+  /**
+     @brief Builds the TypeObjects of a type and of the named types it depends on
+
+     Types already in the bundle are skipped.
+
+     @param [in] type Structure type of a topic
+     @throw std::runtime_error If the type has members of unsupported kinds, e.g. bitsets
+  */
+  void add(const eprosima::xtypes::DynamicType& type);
+
+  /// True if the bundle has TypeObjects of the scoped type name
+  bool contains(const std::string& name) const;
+
+  /// Entries, where dependencies come before the types that depend on them
+  inline const std::vector<Entry>& entries() const { return m_entries; }
+
+  /// Adds all TypeObjects to the fast-dds TypeObjectFactory
+  void register_types() const;
+
+  /**
+     @brief Writes the bundle as CDR to a file
+
+     @param [in] file Path of the file, which is overwritten
+  */
+  void save(const std::filesystem::path& file) const;
+
+  /**
+     @brief Reads a bundle written by save()
+
+     @param [in] file Path of the file
+     @return Bundle, which is not registered
+     @throw std::runtime_error If the file cannot be read or has an unknown format
+  */
+  static TypeObjectBundle load(const std::filesystem::path& file);
+
+private:
+  /// Identifier of a type, building TypeObjects of named types
+  const eprosima::fastrtps::types::TypeIdentifier*
+    identifier(const eprosima::xtypes::DynamicType& type, bool complete);
+
+  /// Name of a type in the TypeObjectFactory, building identifiers of collections
+  std::string type_name(const eprosima::xtypes::DynamicType& type);
+
+  void add_structure(const eprosima::xtypes::StructType& structure);
+  void add_union(const eprosima::xtypes::UnionType& union_type);
+  void add_enumeration(const eprosima::xtypes::DynamicType& enumeration);
+
+  /// Hashes the identifiers of an entry, registers it and appends it
+  void finish(Entry&& entry);
+
+  std::vector<Entry> m_entries;
+};
+
+}
+}
@@ -7,6 +7,12 @@
   file, You can obtain one at http://mozilla.org/MPL/2.0/.
 */
 
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+#include <xtypes/xtypes.hpp>
+
 namespace ddsfmu {
 
 /**
@@ -43,5 +49,58 @@ inline void writer_visitor<std::string, char>(
   ref.value(in[0]);
 }
 
+/**
+   @brief Access to a string or char member mapped to an FMI String variable
+
+   Strings are read and written in place in the data store, such that get() returns a
+   pointer that remains valid until the member is modified, i.e. by a setter or when
+   receiving a sample. Bounded strings, `string<N>` in IDL, have their bound reserved as
+   capacity, so they never allocate. A char member is returned from a small buffer owned
+   by this instance.
+*/
+class StringVariable {
+public:
+  explicit StringVariable(eprosima::xtypes::WritableDynamicDataRef ref)
+      : m_string(nullptr), m_char(nullptr), m_bound(0), m_chars{'\0', '\0'} {
+    if (ref.type().kind() == eprosima::xtypes::TypeKind::STRING_TYPE) {
+      m_string = reinterpret_cast<std::string*>(ref.instance_id());
+      m_bound = static_cast<const eprosima::xtypes::StringType&>(ref.type()).bounds();
+      reserve();
+    } else {
+      m_char = reinterpret_cast<char*>(ref.instance_id());
+    }
+  }
+
+  /// Reserves the bound of a bounded string, needed after its instance is reconstructed
+  inline void reserve() {
+    if (m_string && m_bound > 0) { m_string->reserve(m_bound); }
+  }
+
+  /// Returns a null-terminated string, valid until the member is modified
+  inline const char* get() const {
+    if (m_string) { return m_string->c_str(); }
+    m_chars[0] = *m_char;
+    return m_chars;
+  }
+
+  /// Assigns characters, which are truncated to the bound of bounded strings
+  inline void set(const char* value, std::size_t length) {
+    if (m_string) {
+      if (m_bound > 0 && length > m_bound) { length = m_bound; }
+      m_string->assign(value, length);
+    } else {
+      *m_char = length > 0 ? value[0] : '\0';
+    }
+  }
+
+  inline void set(const char* value) { set(value, value ? std::strlen(value) : 0); }
+
+private:
+  std::string* m_string; ///< String member in data store, or nullptr
+  char* m_char;          ///< Char member in data store, or nullptr
+  std::size_t m_bound;   ///< Bound of string, 0 if unbounded
+  mutable char m_chars[2];
+};
+
 }
 }
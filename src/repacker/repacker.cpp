@@ -6,14 +6,17 @@
 */
 
 #include <filesystem>
+#include <fstream>
 #include <iostream>
 
 #include <args.hxx>
 #include <zip/zip.h>
 
 #include "SignalDistributor.hpp"
+#include "TypeObjects.hpp"
 #include "auxiliaries.hpp"
 #include "model-descriptor.hpp"
+#include "qos-profiles.hpp"
 #include "dds-fmu/config.hpp"
 
 namespace fs = std::filesystem;
@@ -172,6 +175,9 @@ int generate_xml(const ddsfmu::detail::CommandsInfo& info) {
   distributor.load_idls(info.resources_path); // load idl types into context
 
   auto mapper_ddsfmu = signal_mapping.first_node("ddsfmu");
+  std::vector<std::string> read_topics;
+  std::vector<ddsfmu::config::TopicProfile> qos_profiles;
+  std::vector<std::string> topic_types;
 
   auto mapper_iterator = [&](ddsfmu::SignalDistributor::Cardinality cardinal) {
     std::string node_name;
@@ -209,8 +215,20 @@ int generate_xml(const ddsfmu::detail::CommandsInfo& info) {
         throw std::runtime_error("Unknown idl type");
       }
 
+      if (auto kind = fmu_node->first_attribute("kind")) {
+        qos_profiles.push_back(ddsfmu::config::TopicProfile{
+          topic_name, ddsfmu::config::parse_topic_kind(kind->value()),
+          cardinal == ddsfmu::SignalDistributor::Cardinality::INPUT,
+          ddsfmu::config::max_serialized_size(distributor.structure(topic_type))});
+      }
+
+      topic_types.push_back(topic_type);
+
       //std::cout << "Topic: " << topic_name << " Type: " << topic_type << std::endl;
       distributor.add(topic_name, topic_type, cardinal);
+      if (cardinal == ddsfmu::SignalDistributor::Cardinality::OUTPUT) {
+        read_topics.push_back(topic_name);
+      }
       if (cardinal == ddsfmu::SignalDistributor::Cardinality::OUTPUT && do_key_filtering) {
         distributor.queue_for_key_parameter(topic_name, topic_type);
       }
@@ -219,6 +237,14 @@ int generate_xml(const ddsfmu::detail::CommandsInfo& info) {
 
   // out before in since this is assumed in module_structure_outputs further below!
   mapper_iterator(ddsfmu::SignalDistributor::Cardinality::OUTPUT);
+
+  bool diagnostics = false;
+  auto diagnostics_attribute = mapper_ddsfmu->first_attribute("diagnostics");
+  if (diagnostics_attribute) {
+    std::istringstream(diagnostics_attribute->value()) >> std::boolalpha >> diagnostics;
+  }
+  if (diagnostics) { distributor.add_diagnostics(read_topics); }
+
   mapper_iterator(ddsfmu::SignalDistributor::Cardinality::INPUT);
 
   distributor.process_key_queue();
@@ -234,6 +260,29 @@ int generate_xml(const ddsfmu::detail::CommandsInfo& info) {
 
   ddsfmu::config::model_structure_outputs_generator(doc, root_node, distributor.outputs());
 
+  // write QoS profiles of topics with a kind hint, skipping profiles defined by the user.
+  // The file is written before the guid is generated, since it is part of the configuration
+  const auto dds_config = info.resources_path / "config" / "dds";
+  const auto generated_profiles = dds_config / ddsfmu::config::GeneratedProfiles;
+  if (qos_profiles.empty()) {
+    fs::remove(generated_profiles);
+  } else {
+    std::ofstream(generated_profiles) << ddsfmu::config::generate_qos_profiles(
+      qos_profiles, ddsfmu::config::qos_profile_names(dds_config / "dds_profile.xml"));
+  }
+
+  // precompute TypeObjects of topic types, which the FMU registers instead of building them
+  ddsfmu::detail::TypeObjectBundle type_objects;
+  for (const auto& topic_type : topic_types) {
+    try {
+      type_objects.add(distributor.structure(topic_type));
+    } catch (const std::runtime_error& e) {
+      std::cerr << "WARNING: No TypeObject for type " << topic_type << ": " << e.what()
+                << std::endl;
+    }
+  }
+  type_objects.save(dds_config / ddsfmu::detail::TypeObjectsFile);
+
   // retrieve guid
   auto guid = ddsfmu::config::generate_uuid(ddsfmu::config::get_uuid_files(info.fmu_path, true));
   //,std::vector<std::string>{ddsfmu::config::print_xml(doc)}); // Uncomment and set get_uuid_files false in dds-fmu.cpp
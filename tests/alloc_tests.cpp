@@ -0,0 +1,271 @@
+/*
+  Copyright 2023, SINTEF Ocean
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+/*
+  Allocation regression tests
+
+  The FMU is driven through the FMI C API, as a co-simulation master would, such that the
+  whole call path of e.g. fmi2DoStep is covered. The test executable is linked with the same
+  sources as the dds-fmu module.
+
+  Heap allocations are counted by interposing malloc on glibc, which also catches operator
+  new of the standard library, and by replacing operator new elsewhere. Only allocations of
+  the thread that runs the code under test are counted, such that fast-dds threads, e.g.
+  receiving samples in the background, do not disturb the counts.
+*/
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <map>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "SignalDistributor.hpp"
+#include "fmi_component.hpp"
+#include "scratch_resources.hpp"
+
+namespace {
+
+thread_local bool counting = false;
+thread_local std::uint64_t allocations = 0;
+
+inline void count_allocation() {
+  if (counting) { ++allocations; }
+}
+
+/// Counts heap allocations of the calling thread during its lifetime
+class AllocationCounter {
+public:
+  AllocationCounter() : m_begin(allocations) { counting = true; }
+  ~AllocationCounter() { counting = false; }
+  std::uint64_t count() const { return allocations - m_begin; }
+
+private:
+  std::uint64_t m_begin;
+};
+
+}
+
+#if defined(__GLIBC__)
+extern "C" {
+void* __libc_malloc(std::size_t size);
+void* __libc_calloc(std::size_t count, std::size_t size);
+void* __libc_realloc(void* ptr, std::size_t size);
+
+void* malloc(std::size_t size) {
+  count_allocation();
+  return __libc_malloc(size);
+}
+
+void* calloc(std::size_t count, std::size_t size) {
+  count_allocation();
+  return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, std::size_t size) {
+  count_allocation();
+  return __libc_realloc(ptr, size);
+}
+}
+#else
+void* operator new(std::size_t size) {
+  count_allocation();
+  if (void* ptr = std::malloc(size ? size : 1)) { return ptr; }
+  throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+#endif
+
+namespace {
+
+constexpr int WarmupSteps = 50;
+constexpr int MeasuredSteps = 200;
+constexpr fmi2Real StepSize = 0.01;
+
+/// Initialized dds-fmu with one topic as both input and output, and value references
+struct Loopback {
+  Loopback(const std::string& name, const std::string& type) {
+    resources = scratch_resources(name, R"(<?xml version="1.0" encoding="UTF-8"?>
+<ddsfmu>
+  <fmu_out topic="loopback" type=")" + type + R"(" />
+  <fmu_in topic="loopback" type=")" + type + R"(" />
+</ddsfmu>
+)");
+    component = instantiate_fmu(resources, name);
+
+    ddsfmu::SignalDistributor distributor;
+    distributor.load_idls(resources);
+    distributor.add("loopback", type, ddsfmu::SignalDistributor::Cardinality::OUTPUT);
+    distributor.add("loopback", type, ddsfmu::SignalDistributor::Cardinality::INPUT);
+    for (const auto& info : distributor.get_mapping()) {
+      value_refs[std::get<1>(info)] = static_cast<fmi2ValueReference>(std::get<0>(info));
+    }
+  }
+
+  ~Loopback() {
+    fmi2Terminate(component);
+    fmi2FreeInstance(component);
+  }
+
+  Loopback(const Loopback&) = delete;
+  Loopback& operator=(const Loopback&) = delete;
+
+  /// Steps the FMU, returning the status
+  fmi2Status do_step() {
+    const auto status = fmi2DoStep(component, time, StepSize, fmi2True);
+    time += StepSize;
+    return status;
+  }
+
+  /// Lets the published sample arrive, outside of the measurement
+  static void settle() { std::this_thread::sleep_for(std::chrono::milliseconds(1)); }
+
+  std::filesystem::path resources;
+  fmi2Component component = nullptr;
+  fmi2Real time = 0.0;
+  std::map<std::string, fmi2ValueReference> value_refs;
+};
+
+}
+
+TEST(Allocations, CounterWorks) {
+  // Volatile, such that the allocation is not elided
+  static std::string* volatile escaped = nullptr;
+  AllocationCounter counter;
+  escaped = new std::string(64, 'x');
+  delete escaped;
+  EXPECT_GT(counter.count(), 0u);
+}
+
+TEST(Allocations, FixedSizeAccessors) {
+  Loopback loopback("alloc_accessors", "Trivial");
+  const auto in = loopback.value_refs.at("pub.loopback.val");
+  const auto out = loopback.value_refs.at("sub.loopback.val");
+
+  fmi2Real value = 1.0;
+  ASSERT_EQ(fmi2OK, fmi2SetReal(loopback.component, &in, 1, &value));
+  ASSERT_EQ(fmi2OK, fmi2GetReal(loopback.component, &out, 1, &value));
+
+  AllocationCounter counter;
+  for (int i = 0; i < MeasuredSteps; ++i) {
+    value = static_cast<fmi2Real>(i);
+    fmi2SetReal(loopback.component, &in, 1, &value);
+    fmi2GetReal(loopback.component, &out, 1, &value);
+  }
+  EXPECT_EQ(counter.count(), 0u) << "fmi2SetReal and fmi2GetReal must not allocate";
+}
+
+TEST(Allocations, FixedSizeStep) {
+  Loopback loopback("alloc_fixed", "Trivial");
+  const auto in = loopback.value_refs.at("pub.loopback.val");
+  const auto out = loopback.value_refs.at("sub.loopback.val");
+
+  fmi2Real value = 0.0;
+  for (int i = 0; i < WarmupSteps; ++i) {
+    value = static_cast<fmi2Real>(i);
+    fmi2SetReal(loopback.component, &in, 1, &value);
+    ASSERT_EQ(fmi2OK, loopback.do_step());
+    fmi2GetReal(loopback.component, &out, 1, &value);
+    Loopback::settle();
+  }
+
+  std::uint64_t total = 0;
+  for (int i = 0; i < MeasuredSteps; ++i) {
+    fmi2Status status;
+    {
+      AllocationCounter counter;
+      value = static_cast<fmi2Real>(i);
+      fmi2SetReal(loopback.component, &in, 1, &value);
+      status = loopback.do_step();
+      fmi2GetReal(loopback.component, &out, 1, &value);
+      total += counter.count();
+    }
+    ASSERT_EQ(fmi2OK, status);
+    Loopback::settle();
+  }
+
+  const double per_step = static_cast<double>(total) / MeasuredSteps;
+  RecordProperty("allocations_per_step", std::to_string(per_step));
+  EXPECT_EQ(total, 0u) << "Steady state fmi2DoStep allocates " << per_step
+                       << " times per step for a fixed-size type";
+}
+
+TEST(Allocations, VariableSizeStep) {
+  Loopback loopback("alloc_variable", "Message");
+  const auto in = loopback.value_refs.at("pub.loopback.str");
+  const auto out = loopback.value_refs.at("sub.loopback.str");
+
+  // Strings beyond small string optimization, changing every step
+  std::vector<std::string> strings;
+  for (char c = 'a'; c <= 'z'; ++c) { strings.emplace_back(40, c); }
+
+  fmi2String value = nullptr;
+  for (int i = 0; i < WarmupSteps; ++i) {
+    ASSERT_EQ(fmi2OK, loopback.do_step());
+    fmi2GetString(loopback.component, &out, 1, &value);
+    Loopback::settle();
+  }
+
+  std::uint64_t total = 0;
+  for (int i = 0; i < MeasuredSteps; ++i) {
+    fmi2Status status;
+    {
+      AllocationCounter counter;
+      value = strings[static_cast<std::size_t>(i) % strings.size()].c_str();
+      fmi2SetString(loopback.component, &in, 1, &value);
+      status = loopback.do_step();
+      fmi2GetString(loopback.component, &out, 1, &value);
+      total += counter.count();
+    }
+    ASSERT_EQ(fmi2OK, status);
+    Loopback::settle();
+  }
+
+  // Variable size types are expected to allocate, the count is reported for comparison
+  const double per_step = static_cast<double>(total) / MeasuredSteps;
+  RecordProperty("allocations_per_step", std::to_string(per_step));
+}
+
+#ifdef DDSFMU_FMU_STATE
+TEST(Allocations, GetFMUstateIntoExistingState) {
+  Loopback loopback("alloc_state", "Trivial");
+  const auto in = loopback.value_refs.at("pub.loopback.val");
+
+  // The first snapshot allocates the state and its buffer
+  fmi2FMUstate state = nullptr;
+  ASSERT_EQ(fmi2OK, fmi2GetFMUstate(loopback.component, &state));
+  ASSERT_EQ(fmi2OK, loopback.do_step());
+
+  std::uint64_t total = 0;
+  for (int i = 0; i < MeasuredSteps; ++i) {
+    const fmi2Real value = static_cast<fmi2Real>(i);
+    fmi2SetReal(loopback.component, &in, 1, &value);
+    fmi2Status status;
+    {
+      AllocationCounter counter;
+      status = fmi2GetFMUstate(loopback.component, &state);
+      total += counter.count();
+    }
+    ASSERT_EQ(fmi2OK, status);
+  }
+
+  fmi2FreeFMUstate(loopback.component, &state);
+  EXPECT_EQ(total, 0u) << "Snapshots into an existing FMU state must not allocate";
+}
+#endif
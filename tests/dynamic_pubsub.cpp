@@ -7,12 +7,20 @@
 
 #include <chrono>
 #include <filesystem>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
 #include <thread>
 
 #include <gtest/gtest.h>
 
 #include "DataMapper.hpp"
 #include "DynamicPubSub.hpp"
+#include "SampleHistory.hpp"
+#include "SignalDistributor.hpp"
+#include "StepDiagnostics.hpp"
+#include "scratch_resources.hpp"
 
 TEST(DynamicPubSub, Initialization) {
   auto resources = std::filesystem::current_path() / "resources";
@@ -61,3 +69,442 @@ TEST(DynamicPubSub, Reinitialization) {
   pubsub.reset(resources, &data_mapper);
   pubsub.reset(resources, &data_mapper);
 }
+
+TEST(DynamicPubSub, LazyEntities) {
+  auto resources = scratch_resources("lazy_entities", R"(<?xml version="1.0" encoding="UTF-8"?>
+<ddsfmu lazy_entities="true">
+  <fmu_out topic="roundtrip" type="Trivial" />
+  <fmu_in topic="roundtrip" type="Trivial" />
+</ddsfmu>
+)");
+  ddsfmu::DataMapper data_mapper;
+  ddsfmu::DynamicPubSub pubsub;
+
+  data_mapper.reset(resources);
+  pubsub.reset(resources, &data_mapper);
+
+  EXPECT_TRUE(pubsub.has_pending());
+
+  auto write_store = data_mapper.store_index("roundtrip", ddsfmu::DataMapper::Direction::Write);
+  auto read_store = data_mapper.store_index("roundtrip", ddsfmu::DataMapper::Direction::Read);
+
+  // Read access to an input does not create its writer
+  pubsub.activate(write_store, ddsfmu::DataMapper::Direction::Read);
+  pubsub.activate(write_store, ddsfmu::DataMapper::Direction::Write);
+  EXPECT_TRUE(pubsub.has_pending());
+
+  pubsub.activate_all();
+  EXPECT_FALSE(pubsub.has_pending());
+  EXPECT_EQ(read_store, data_mapper.owner(ddsfmu::config::ScalarVariableType::Real, 0));
+
+  auto& dyn_write = data_mapper.data_ref("roundtrip", ddsfmu::DataMapper::Direction::Write);
+  auto& dyn_read = data_mapper.data_ref("roundtrip", ddsfmu::DataMapper::Direction::Read);
+
+  double d_val(2.72);
+  dyn_write["val"] = d_val;
+  pubsub.write();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  pubsub.take();
+
+  EXPECT_EQ(d_val, dyn_read["val"].value<double>());
+}
+
+TEST(DynamicPubSub, SoftReset) {
+  auto resources = std::filesystem::current_path() / "resources";
+  ddsfmu::DataMapper data_mapper;
+  ddsfmu::DynamicPubSub pubsub;
+
+  auto hard_start = std::chrono::steady_clock::now();
+  data_mapper.reset(resources);
+  pubsub.reset(resources, &data_mapper);
+  auto hard_duration = std::chrono::steady_clock::now() - hard_start;
+
+  auto& dyn_write = data_mapper.data_ref("roundtrip", ddsfmu::DataMapper::Direction::Write);
+  auto& dyn_read = data_mapper.data_ref("roundtrip", ddsfmu::DataMapper::Direction::Read);
+
+  double d_val(1.5);
+  dyn_write["val"] = d_val;
+  data_mapper.set_string(0, "not empty");
+  pubsub.write();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  auto soft_start = std::chrono::steady_clock::now();
+  data_mapper.soft_reset();
+  pubsub.soft_reset();
+  auto soft_duration = std::chrono::steady_clock::now() - soft_start;
+
+  // Data stores are reset and samples received before reset are discarded
+  pubsub.take();
+  EXPECT_EQ(0.0, dyn_write["val"].value<double>());
+  EXPECT_EQ(0.0, dyn_read["val"].value<double>());
+  std::string str;
+  data_mapper.get_string(0, str);
+  EXPECT_TRUE(str.empty());
+
+  // Visitors and entities remain usable
+  auto write_offsets =
+    data_mapper.index_offsets("roundtrip", ddsfmu::DataMapper::Direction::Write);
+  data_mapper.set_double(std::get<0>(write_offsets), d_val);
+  pubsub.write();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  pubsub.take();
+  EXPECT_EQ(d_val, dyn_read["val"].value<double>());
+
+  using std::chrono::microseconds;
+  RecordProperty(
+    "hard_reset_us",
+    static_cast<int>(std::chrono::duration_cast<microseconds>(hard_duration).count()));
+  RecordProperty(
+    "soft_reset_us",
+    static_cast<int>(std::chrono::duration_cast<microseconds>(soft_duration).count()));
+}
+
+TEST(DynamicPubSub, Diagnostics) {
+  auto resources = scratch_resources("diagnostics", R"(<?xml version="1.0" encoding="UTF-8"?>
+<ddsfmu diagnostics="true">
+  <fmu_out topic="roundtrip" type="Trivial" />
+  <fmu_in topic="roundtrip" type="Trivial" />
+</ddsfmu>
+)");
+  ddsfmu::DataMapper data_mapper;
+  ddsfmu::DynamicPubSub pubsub;
+  ddsfmu::detail::StepDiagnostics diagnostics;
+
+  data_mapper.reset(resources);
+  pubsub.reset(resources, &data_mapper);
+  pubsub.init_key_filters();
+  ASSERT_TRUE(data_mapper.has_diagnostics());
+  diagnostics.bind(data_mapper.diagnostics_ref(), data_mapper.diagnostics_topics());
+  pubsub.set_diagnostics(&diagnostics);
+
+  // Diagnostics are enumerated after outputs and before inputs, as in the model description
+  ddsfmu::SignalDistributor distributor;
+  distributor.load_idls(resources);
+  distributor.add("roundtrip", "Trivial", ddsfmu::SignalDistributor::Cardinality::OUTPUT);
+  distributor.add_diagnostics(data_mapper.diagnostics_topics());
+  distributor.add("roundtrip", "Trivial", ddsfmu::SignalDistributor::Cardinality::INPUT);
+
+  const auto diag_store =
+    data_mapper.store_index("diag", ddsfmu::DataMapper::Direction::Diagnostics);
+  std::map<std::string, std::int32_t> value_refs;
+  for (const auto& info : distributor.get_mapping()) {
+    const auto value_ref = static_cast<std::int32_t>(std::get<0>(info));
+    const bool is_diagnostics = std::get<1>(info).rfind("diag.", 0) == 0;
+    EXPECT_EQ(
+      is_diagnostics,
+      data_mapper.owner(ddsfmu::config::ScalarVariableType::Real, value_ref) == diag_store);
+    value_refs[std::get<1>(info)] = value_ref;
+  }
+  EXPECT_EQ(8u, distributor.outputs());
+
+  data_mapper.set_double(value_refs.at("pub.roundtrip.val"), 1.5);
+  diagnostics.begin_step();
+  pubsub.write();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  pubsub.take();
+  diagnostics.end_step();
+
+  double samples, bytes, convert_ns, rejects;
+  data_mapper.get_double(value_refs.at("diag.sub.roundtrip.samples"), samples);
+  data_mapper.get_double(value_refs.at("diag.bytes_published"), bytes);
+  data_mapper.get_double(value_refs.at("diag.convert_ns"), convert_ns);
+  data_mapper.get_double(value_refs.at("diag.sub.roundtrip.rejects"), rejects);
+  EXPECT_EQ(1.0, samples);
+  EXPECT_LT(0.0, bytes);
+  EXPECT_LT(0.0, convert_ns);
+  EXPECT_EQ(0.0, rejects);
+
+  // Counters are those of the last step
+  diagnostics.begin_step();
+  pubsub.take();
+  diagnostics.end_step();
+  data_mapper.get_double(value_refs.at("diag.sub.roundtrip.samples"), samples);
+  data_mapper.get_double(value_refs.at("diag.bytes_published"), bytes);
+  EXPECT_EQ(0.0, samples);
+  EXPECT_EQ(0.0, bytes);
+}
+
+TEST(DynamicPubSub, BoundedSequence) {
+  auto resources = scratch_resources("bounded_sequence", R"(<?xml version="1.0" encoding="UTF-8"?>
+<ddsfmu>
+  <fmu_out topic="cloud" type="Cloud" />
+  <fmu_in topic="cloud" type="Cloud" />
+</ddsfmu>
+)");
+  ddsfmu::DataMapper data_mapper;
+  ddsfmu::DynamicPubSub pubsub;
+  data_mapper.reset(resources);
+  pubsub.reset(resources, &data_mapper);
+  pubsub.init_key_filters();
+
+  ddsfmu::SignalDistributor distributor;
+  distributor.load_idls(resources);
+  distributor.add("cloud", "Cloud", ddsfmu::SignalDistributor::Cardinality::OUTPUT);
+  distributor.add("cloud", "Cloud", ddsfmu::SignalDistributor::Cardinality::INPUT);
+
+  std::map<std::string, std::int32_t> value_refs;
+  for (const auto& info : distributor.get_mapping()) {
+    value_refs[std::get<1>(info)] = static_cast<std::int32_t>(std::get<0>(info));
+  }
+  // Length and x, y of three points, the unbounded sequence is not mapped
+  EXPECT_EQ(7u, distributor.outputs());
+  ASSERT_EQ(1u, value_refs.count("pub.cloud.points.length"));
+  ASSERT_EQ(1u, value_refs.count("pub.cloud.points[2].y"));
+  EXPECT_EQ(0u, value_refs.count("pub.cloud.points[3].x"));
+
+  // Elements are preallocated and stay in place
+  auto& dyn_read = data_mapper.data_ref("cloud", ddsfmu::DataMapper::Direction::Read);
+  ASSERT_EQ(3u, dyn_read["points"].size());
+  const auto element = dyn_read["points"][0].instance_id();
+
+  data_mapper.set_int(value_refs.at("pub.cloud.points.length"), 2);
+  data_mapper.set_double(value_refs.at("pub.cloud.points[0].x"), 1.5);
+  data_mapper.set_double(value_refs.at("pub.cloud.points[1].y"), -2.5);
+  data_mapper.set_double(value_refs.at("pub.cloud.points[2].x"), 9.0); // Beyond length
+  pubsub.write();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  pubsub.take();
+
+  std::int32_t length;
+  double x0, y1, x2;
+  data_mapper.get_int(value_refs.at("sub.cloud.points.length"), length);
+  data_mapper.get_double(value_refs.at("sub.cloud.points[0].x"), x0);
+  data_mapper.get_double(value_refs.at("sub.cloud.points[1].y"), y1);
+  data_mapper.get_double(value_refs.at("sub.cloud.points[2].x"), x2);
+  EXPECT_EQ(2, length);
+  EXPECT_EQ(1.5, x0);
+  EXPECT_EQ(-2.5, y1);
+  EXPECT_EQ(0.0, x2);
+  EXPECT_EQ(element, dyn_read["points"][0].instance_id());
+
+  // Lengths are clamped to the bound and reset with the data stores
+  data_mapper.set_int(value_refs.at("pub.cloud.points.length"), 10);
+  data_mapper.get_int(value_refs.at("pub.cloud.points.length"), length);
+  EXPECT_EQ(3, length);
+  data_mapper.soft_reset();
+  data_mapper.get_int(value_refs.at("sub.cloud.points.length"), length);
+  EXPECT_EQ(0, length);
+  EXPECT_EQ(element, dyn_read["points"][0].instance_id());
+}
+
+TEST(DynamicPubSub, SampleHistory) {
+  using ddsfmu::detail::TimeAlignment;
+  typedef ddsfmu::detail::SampleHistory<std::shared_ptr<int>> History;
+  int created = 0;
+  History history(3, TimeAlignment::AtMost, [&created]() {
+    return std::make_shared<int>(created++);
+  });
+  ASSERT_TRUE(history.enabled());
+  EXPECT_FALSE(History().enabled());
+  EXPECT_EQ(nullptr, history.select(1.0));
+
+  // The oldest sample is overwritten when full
+  for (int i = 0; i < 4; ++i) {
+    *history.next_slot() = 10 * i;
+    history.commit(0.1 * i);
+  }
+  EXPECT_EQ(3u, history.size());
+  EXPECT_EQ(3, created);
+
+  const auto* selected = history.select(0.2);
+  ASSERT_NE(nullptr, selected);
+  EXPECT_EQ(20, *selected->sample);
+  history.discard_through(selected->time);
+  EXPECT_EQ(1u, history.size());
+  EXPECT_EQ(nullptr, history.select(0.2));
+  EXPECT_EQ(30, *history.select(0.3)->sample);
+
+  History closest(4, TimeAlignment::Closest, []() { return std::make_shared<int>(0); });
+  for (int i = 0; i < 4; ++i) {
+    *closest.next_slot() = i;
+    closest.commit(0.1 * i);
+  }
+  EXPECT_EQ(2, *closest.select(0.19)->sample);
+  EXPECT_EQ(3, *closest.select(5.0)->sample);
+  closest.clear();
+  EXPECT_EQ(0u, closest.size());
+}
+
+TEST(DynamicPubSub, TimeAlignment) {
+  auto resources = scratch_resources("time_alignment", R"(<?xml version="1.0" encoding="UTF-8"?>
+<ddsfmu timestamps="simulation">
+  <fmu_out topic="aligned" type="Trivial" time_alignment="at_most" history="4" />
+  <fmu_in topic="aligned" type="Trivial" />
+</ddsfmu>
+)");
+  ddsfmu::DataMapper data_mapper;
+  ddsfmu::DynamicPubSub pubsub;
+  data_mapper.reset(resources);
+  pubsub.reset(resources, &data_mapper);
+  pubsub.init_key_filters();
+
+  auto& dyn_write = data_mapper.data_ref("aligned", ddsfmu::DataMapper::Direction::Write);
+  auto& dyn_read = data_mapper.data_ref("aligned", ddsfmu::DataMapper::Direction::Read);
+
+  // A sample stamped after the step is received, but not used
+  dyn_write["val"] = 1.0;
+  pubsub.write(0.0);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  pubsub.take(-0.1);
+  EXPECT_EQ(0.0, dyn_read["val"].value<double>());
+
+  // A newer sample does not take precedence before its time stamp
+  dyn_write["val"] = 3.0;
+  pubsub.write(0.2);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  pubsub.take(0.1);
+  EXPECT_EQ(1.0, dyn_read["val"].value<double>());
+
+  // It is kept for later steps
+  pubsub.take(0.3);
+  EXPECT_EQ(3.0, dyn_read["val"].value<double>());
+}
+
+TEST(DynamicPubSub, TimeAlignmentRequiresSimulationStamps) {
+  auto resources = scratch_resources("aligned_wall", R"(<?xml version="1.0" encoding="UTF-8"?>
+<ddsfmu>
+  <fmu_out topic="aligned_wall" type="Trivial" time_alignment="closest" />
+</ddsfmu>
+)");
+  ddsfmu::DataMapper data_mapper;
+  ddsfmu::DynamicPubSub pubsub;
+  data_mapper.reset(resources);
+  EXPECT_THROW(pubsub.reset(resources, &data_mapper), std::runtime_error);
+}
+
+TEST(DynamicPubSub, Restart) {
+  auto resources = scratch_resources("restart", R"(<?xml version="1.0" encoding="UTF-8"?>
+<ddsfmu timestamps="simulation">
+  <lockstep topic="restart_step" />
+  <fmu_out topic="restart" type="Trivial" time_alignment="at_most" history="4" />
+  <fmu_in topic="restart" type="Trivial" />
+</ddsfmu>
+)");
+  ddsfmu::DataMapper data_mapper;
+  ddsfmu::DynamicPubSub pubsub;
+  data_mapper.reset(resources);
+  pubsub.reset(resources, &data_mapper);
+  pubsub.init_key_filters();
+
+  auto& dyn_write = data_mapper.data_ref("restart", ddsfmu::DataMapper::Direction::Write);
+  auto& dyn_read = data_mapper.data_ref("restart", ddsfmu::DataMapper::Direction::Read);
+
+  // A sample of a later step is kept for time alignment
+  dyn_write["val"] = 1.0;
+  pubsub.write(0.2);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  pubsub.take(0.1);
+  EXPECT_EQ(0.0, dyn_read["val"].value<double>());
+  EXPECT_EQ(1u, pubsub.step_count());
+
+  // Restarting, as when an FMU state is restored, discards it
+  pubsub.restart(7);
+  EXPECT_EQ(7u, pubsub.step_count());
+  pubsub.take(0.3);
+  EXPECT_EQ(0.0, dyn_read["val"].value<double>());
+}
+
+TEST(DynamicPubSub, Lockstep) {
+  auto resources = scratch_resources("lockstep", R"(<?xml version="1.0" encoding="UTF-8"?>
+<ddsfmu>
+  <lockstep topic="lockstep_step" timeout="0.2" spin="0.0001" />
+  <fmu_out topic="lockstep" type="Trivial" lockstep="true" />
+  <fmu_in topic="lockstep" type="Trivial" />
+</ddsfmu>
+)");
+  ddsfmu::DataMapper data_mapper;
+  ddsfmu::DynamicPubSub pubsub;
+  data_mapper.reset(resources);
+  pubsub.reset(resources, &data_mapper);
+  pubsub.init_key_filters();
+
+  auto& dyn_write = data_mapper.data_ref("lockstep", ddsfmu::DataMapper::Direction::Write);
+  auto& dyn_read = data_mapper.data_ref("lockstep", ddsfmu::DataMapper::Direction::Read);
+
+  // The sample of the step is waited for, without sleeping between write and take
+  dyn_write["val"] = 1.0;
+  pubsub.write(0.0);
+  EXPECT_TRUE(pubsub.wait(0.1));
+  pubsub.take(0.1);
+  EXPECT_EQ(1.0, dyn_read["val"].value<double>());
+
+  // Without a sample the wait times out, and the previous sample is held
+  auto begin = std::chrono::steady_clock::now();
+  EXPECT_FALSE(pubsub.wait(0.2));
+  EXPECT_GE(std::chrono::steady_clock::now() - begin, std::chrono::milliseconds(190));
+  pubsub.take(0.2);
+  EXPECT_EQ(1.0, dyn_read["val"].value<double>());
+}
+
+TEST(DynamicPubSub, LockstepTopicClash) {
+  auto resources = scratch_resources("lockstep_clash", R"(<?xml version="1.0" encoding="UTF-8"?>
+<ddsfmu>
+  <lockstep topic="lockstep_clash" />
+  <fmu_in topic="lockstep_clash" type="Trivial" />
+</ddsfmu>
+)");
+  ddsfmu::DataMapper data_mapper;
+  ddsfmu::DynamicPubSub pubsub;
+  data_mapper.reset(resources);
+  EXPECT_THROW(pubsub.reset(resources, &data_mapper), std::runtime_error);
+}
+
+TEST(DynamicPubSub, UnknownFlowController) {
+  auto resources = scratch_resources("unknown_flow", R"(<?xml version="1.0" encoding="UTF-8"?>
+<ddsfmu publish_mode="asynchronous" flow_controller="not_in_profile">
+  <fmu_in topic="unknown_flow" type="Trivial" />
+</ddsfmu>
+)");
+  ddsfmu::DataMapper data_mapper;
+  ddsfmu::DynamicPubSub pubsub;
+  data_mapper.reset(resources);
+  EXPECT_THROW(pubsub.reset(resources, &data_mapper), std::runtime_error);
+}
+
+TEST(DynamicPubSub, PublishPeriod) {
+  auto resources = scratch_resources("publish_period", R"(<?xml version="1.0" encoding="UTF-8"?>
+<ddsfmu>
+  <fmu_out topic="decimated" type="Trivial" />
+  <fmu_in topic="decimated" type="Trivial" rate="10" />
+</ddsfmu>
+)");
+  ddsfmu::DataMapper data_mapper;
+  ddsfmu::DynamicPubSub pubsub;
+  data_mapper.reset(resources);
+  pubsub.reset(resources, &data_mapper);
+  pubsub.init_key_filters();
+
+  auto& dyn_write = data_mapper.data_ref("decimated", ddsfmu::DataMapper::Direction::Write);
+  auto& dyn_read = data_mapper.data_ref("decimated", ddsfmu::DataMapper::Direction::Read);
+
+  auto step = [&](double time, double value) {
+    dyn_write["val"] = value;
+    pubsub.write(time);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    pubsub.take(time);
+    return dyn_read["val"].value<double>();
+  };
+
+  // The first step publishes, the following steps within the period do not
+  EXPECT_EQ(1.0, step(0.0, 1.0));
+  EXPECT_EQ(1.0, step(0.05, 2.0));
+  EXPECT_EQ(3.0, step(0.1, 3.0));
+  EXPECT_EQ(3.0, step(0.15, 4.0));
+
+  // After time moves backwards, e.g. to a restored FMU state, the next step publishes
+  EXPECT_EQ(5.0, step(0.05, 5.0));
+  EXPECT_EQ(5.0, step(0.1, 6.0));
+  EXPECT_EQ(7.0, step(0.15, 7.0));
+
+  // Without a time, each call publishes
+  dyn_write["val"] = 8.0;
+  pubsub.write();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  pubsub.take();
+  EXPECT_EQ(8.0, dyn_read["val"].value<double>());
+
+  // A soft reset publishes in the next step
+  data_mapper.soft_reset();
+  pubsub.soft_reset();
+  EXPECT_EQ(9.0, step(0.0, 9.0));
+}
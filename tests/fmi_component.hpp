@@ -0,0 +1,53 @@
+#pragma once
+
+/*
+  Copyright 2023, SINTEF Ocean
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include <cstdlib>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+
+#include <cppfmu_cs.hpp>
+
+#include "auxiliaries.hpp"
+
+/// Discards FMI log messages of test instances
+inline void silent_fmi_logger(
+  fmi2ComponentEnvironment, fmi2String, fmi2Status, fmi2String, fmi2String, ...) {}
+
+/**
+   @brief Instantiates and initializes dds-fmu through the FMI C API
+
+   The test executable must be linked with the sources of the dds-fmu module. The GUID is
+   evaluated from the configuration files, as the FMU does.
+
+   @param [in] resources Path to FMU resources folder, e.g. from scratch_resources()
+   @param [in] name Instance name
+   @return Component in step mode, to be freed with fmi2FreeInstance()
+*/
+inline fmi2Component instantiate_fmu(
+  const std::filesystem::path& resources, const std::string& name) {
+  static const fmi2CallbackFunctions callbacks = {
+    silent_fmi_logger, std::calloc, std::free, nullptr, nullptr};
+
+  const auto guid =
+    ddsfmu::config::generate_uuid(ddsfmu::config::get_uuid_files(resources.parent_path(), true));
+#ifdef _WIN32
+  const auto uri = "file:///" + resources.generic_string();
+#else
+  const auto uri = "file://" + resources.generic_string();
+#endif
+
+  fmi2Component component = fmi2Instantiate(
+    name.c_str(), fmi2CoSimulation, guid.c_str(), uri.c_str(), &callbacks, fmi2False, fmi2False);
+  if (!component) { throw std::runtime_error("Could not instantiate dds-fmu"); }
+  fmi2SetupExperiment(component, fmi2False, 0.0, 0.0, fmi2False, 0.0);
+  fmi2EnterInitializationMode(component);
+  fmi2ExitInitializationMode(component);
+  return component;
+}
@@ -0,0 +1,278 @@
+/*
+  Copyright 2023, SINTEF Ocean
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "DataMapper.hpp"
+#include "SignalDistributor.hpp"
+#include "StateBuffer.hpp"
+#include "fmi_component.hpp"
+#include "scratch_resources.hpp"
+
+TEST(FmuState, DataMapperRoundtrip) {
+  auto resources = std::filesystem::current_path() / "resources";
+  ddsfmu::DataMapper data_mapper;
+  data_mapper.reset(resources);
+
+  auto& msg = data_mapper.data_ref("msg_write", ddsfmu::DataMapper::Direction::Write);
+  auto& trivial = data_mapper.data_ref("roundtrip", ddsfmu::DataMapper::Direction::Read);
+
+  msg["str"] = std::string("snapshot");
+  msg["i32"] = std::int32_t(-42);
+  msg["d_val"] = 2.5;
+  msg["enabled"] = true;
+  trivial["val"] = 1.25;
+
+  std::vector<std::uint8_t> state;
+  data_mapper.save_state(state);
+
+  msg["str"] = std::string("a considerably longer string than before");
+  msg["i32"] = std::int32_t(7);
+  msg["d_val"] = -1.0;
+  msg["enabled"] = false;
+  trivial["val"] = 0.0;
+
+  ddsfmu::detail::StateReader reader(state.data(), state.size());
+  data_mapper.load_state(reader);
+  EXPECT_EQ(state.size(), reader.offset());
+
+  EXPECT_EQ("snapshot", msg["str"].value<std::string>());
+  EXPECT_EQ(-42, msg["i32"].value<std::int32_t>());
+  EXPECT_EQ(2.5, msg["d_val"].value<double>());
+  EXPECT_TRUE(msg["enabled"].value<bool>());
+  EXPECT_EQ(1.25, trivial["val"].value<double>());
+
+  // Visitors still refer to the restored data stores
+  std::string str;
+  auto offsets = data_mapper.index_offsets("msg_write", ddsfmu::DataMapper::Direction::Write);
+  data_mapper.get_string(std::get<3>(offsets), str);
+  EXPECT_EQ("snapshot", str);
+
+  // Saving the restored stores yields the same state
+  std::vector<std::uint8_t> again;
+  data_mapper.save_state(again);
+  EXPECT_EQ(state, again);
+}
+
+TEST(FmuState, InvalidState) {
+  auto resources = std::filesystem::current_path() / "resources";
+  ddsfmu::DataMapper data_mapper;
+  data_mapper.reset(resources);
+
+  auto& msg = data_mapper.data_ref("msg_write", ddsfmu::DataMapper::Direction::Write);
+  msg["str"] = std::string("saved");
+  std::vector<std::uint8_t> state;
+  data_mapper.save_state(state);
+  msg["str"] = std::string("current");
+
+  // Data stores are left unchanged if the state is invalid
+  std::vector<std::uint8_t> truncated(state.begin(), state.end() - 1);
+  ddsfmu::detail::StateReader truncated_reader(truncated.data(), truncated.size());
+  EXPECT_THROW(data_mapper.load_state(truncated_reader), std::runtime_error);
+  EXPECT_EQ("current", msg["str"].value<std::string>());
+
+  std::vector<std::uint8_t> wrong_count;
+  ddsfmu::detail::append_value(wrong_count, std::uint32_t(1));
+  ddsfmu::detail::StateReader wrong_count_reader(wrong_count.data(), wrong_count.size());
+  EXPECT_THROW(data_mapper.load_state(wrong_count_reader), std::runtime_error);
+}
+
+TEST(FmuState, SequenceLengthsClamped) {
+  auto resources = scratch_resources("state_sequences", R"(<?xml version="1.0" encoding="UTF-8"?>
+<ddsfmu>
+  <fmu_out topic="cloud" type="Cloud" />
+  <fmu_in topic="cloud" type="Cloud" />
+</ddsfmu>
+)");
+  ddsfmu::DataMapper data_mapper;
+  data_mapper.reset(resources);
+
+  ddsfmu::SignalDistributor distributor;
+  distributor.load_idls(resources);
+  distributor.add("cloud", "Cloud", ddsfmu::SignalDistributor::Cardinality::OUTPUT);
+  distributor.add("cloud", "Cloud", ddsfmu::SignalDistributor::Cardinality::INPUT);
+  std::map<std::string, std::int32_t> value_refs;
+  for (const auto& info : distributor.get_mapping()) {
+    value_refs[std::get<1>(info)] = static_cast<std::int32_t>(std::get<0>(info));
+  }
+
+  std::vector<std::uint8_t> state;
+  data_mapper.save_state(state);
+
+  // The lengths of both bounded sequences are the last values of the state
+  const std::uint32_t beyond_bound = 100;
+  std::memcpy(state.data() + state.size() - 8, &beyond_bound, sizeof(beyond_bound));
+  std::memcpy(state.data() + state.size() - 4, &beyond_bound, sizeof(beyond_bound));
+  ddsfmu::detail::StateReader reader(state.data(), state.size());
+  data_mapper.load_state(reader);
+
+  std::int32_t length = 0;
+  data_mapper.get_int(value_refs.at("pub.cloud.points.length"), length);
+  EXPECT_EQ(3, length);
+  data_mapper.get_int(value_refs.at("sub.cloud.points.length"), length);
+  EXPECT_EQ(3, length);
+}
+
+#ifdef DDSFMU_FMU_STATE
+namespace {
+
+/// dds-fmu with a Trivial topic as both input and output, driven through the FMI C API
+struct StateFmu {
+  explicit StateFmu(const std::string& name) {
+    auto resources = scratch_resources(name, R"(<?xml version="1.0" encoding="UTF-8"?>
+<ddsfmu>
+  <fmu_out topic="loopback" type="Trivial" />
+  <fmu_in topic="loopback" type="Trivial" />
+</ddsfmu>
+)");
+    component = instantiate_fmu(resources, name);
+
+    ddsfmu::SignalDistributor distributor;
+    distributor.load_idls(resources);
+    distributor.add("loopback", "Trivial", ddsfmu::SignalDistributor::Cardinality::OUTPUT);
+    distributor.add("loopback", "Trivial", ddsfmu::SignalDistributor::Cardinality::INPUT);
+    for (const auto& info : distributor.get_mapping()) {
+      if (std::get<1>(info) == "pub.loopback.val") { input = std::get<0>(info); }
+      if (std::get<1>(info) == "sub.loopback.val") { output = std::get<0>(info); }
+    }
+  }
+
+  ~StateFmu() {
+    fmi2Terminate(component);
+    fmi2FreeInstance(component);
+  }
+
+  StateFmu(const StateFmu&) = delete;
+  StateFmu& operator=(const StateFmu&) = delete;
+
+  fmi2Real get(fmi2ValueReference vr) const {
+    fmi2Real value = 0.0;
+    fmi2GetReal(component, &vr, 1, &value);
+    return value;
+  }
+
+  void set_input(fmi2Real value) { fmi2SetReal(component, &input, 1, &value); }
+
+  /// Steps until the output equals the input, returns false on timeout
+  bool step_until_received() {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    do {
+      fmi2DoStep(component, time, 0.1, fmi2True);
+      time += 0.1;
+      if (get(output) == get(input)) { return true; }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    } while (std::chrono::steady_clock::now() < deadline);
+    return false;
+  }
+
+  fmi2Component component;
+  fmi2ValueReference input = 0, output = 0;
+  fmi2Real time = 0.0;
+};
+
+}
+
+TEST(FmuState, FmiGetStepSet) {
+  StateFmu fmu("state_get_step_set");
+  fmu.set_input(1.0);
+  ASSERT_TRUE(fmu.step_until_received());
+
+  fmi2FMUstate state = nullptr;
+  ASSERT_EQ(fmi2OK, fmi2GetFMUstate(fmu.component, &state));
+  ASSERT_NE(nullptr, state);
+
+  fmu.set_input(2.0);
+  ASSERT_TRUE(fmu.step_until_received());
+
+  // Inputs and outputs are those at the time of the state
+  ASSERT_EQ(fmi2OK, fmi2SetFMUstate(fmu.component, state));
+  EXPECT_EQ(1.0, fmu.get(fmu.input));
+  EXPECT_EQ(1.0, fmu.get(fmu.output));
+
+  // Stepping continues from the restored state
+  fmu.set_input(3.0);
+  EXPECT_TRUE(fmu.step_until_received());
+
+  EXPECT_EQ(fmi2OK, fmi2FreeFMUstate(fmu.component, &state));
+  EXPECT_EQ(nullptr, state);
+}
+
+TEST(FmuState, FmiReuseState) {
+  StateFmu fmu("state_reuse");
+  fmi2FMUstate state = nullptr;
+  fmu.set_input(1.0);
+  ASSERT_EQ(fmi2OK, fmi2GetFMUstate(fmu.component, &state));
+  const fmi2FMUstate first = state;
+
+  // An existing state is overwritten in place
+  fmu.set_input(2.0);
+  ASSERT_EQ(fmi2OK, fmi2GetFMUstate(fmu.component, &state));
+  EXPECT_EQ(first, state);
+
+  fmu.set_input(3.0);
+  ASSERT_EQ(fmi2OK, fmi2SetFMUstate(fmu.component, state));
+  EXPECT_EQ(2.0, fmu.get(fmu.input));
+
+  fmi2FreeFMUstate(fmu.component, &state);
+}
+
+TEST(FmuState, FmiSerializeRoundtrip) {
+  StateFmu fmu("state_serialize");
+  fmi2FMUstate state = nullptr;
+  fmu.set_input(1.0);
+  ASSERT_EQ(fmi2OK, fmi2GetFMUstate(fmu.component, &state));
+
+  std::size_t size = 0;
+  ASSERT_EQ(fmi2OK, fmi2SerializedFMUstateSize(fmu.component, state, &size));
+  std::vector<fmi2Byte> bytes(size);
+  ASSERT_EQ(fmi2OK, fmi2SerializeFMUstate(fmu.component, state, bytes.data(), bytes.size()));
+  EXPECT_EQ(fmi2Error, fmi2SerializeFMUstate(fmu.component, state, bytes.data(), size - 1));
+
+  // Into a new state
+  fmi2FMUstate created = nullptr;
+  fmu.set_input(2.0);
+  ASSERT_EQ(
+    fmi2OK, fmi2DeSerializeFMUstate(fmu.component, bytes.data(), bytes.size(), &created));
+  ASSERT_NE(nullptr, created);
+  ASSERT_EQ(fmi2OK, fmi2SetFMUstate(fmu.component, created));
+  EXPECT_EQ(1.0, fmu.get(fmu.input));
+
+  // Into an existing state, which is reused
+  fmu.set_input(2.0);
+  const fmi2FMUstate existing = created;
+  ASSERT_EQ(
+    fmi2OK, fmi2DeSerializeFMUstate(fmu.component, bytes.data(), bytes.size(), &created));
+  EXPECT_EQ(existing, created);
+  ASSERT_EQ(fmi2OK, fmi2SetFMUstate(fmu.component, created));
+  EXPECT_EQ(1.0, fmu.get(fmu.input));
+
+  // A corrupted state is rejected without modifying the instance
+  fmu.set_input(2.0);
+  bytes[0] = static_cast<fmi2Byte>(~bytes[0]);
+  ASSERT_EQ(
+    fmi2OK, fmi2DeSerializeFMUstate(fmu.component, bytes.data(), bytes.size(), &created));
+  EXPECT_EQ(fmi2Error, fmi2SetFMUstate(fmu.component, created));
+  bytes[0] = static_cast<fmi2Byte>(~bytes[0]);
+  ASSERT_EQ(
+    fmi2OK, fmi2DeSerializeFMUstate(fmu.component, bytes.data(), bytes.size() - 1, &created));
+  EXPECT_EQ(fmi2Error, fmi2SetFMUstate(fmu.component, created));
+  EXPECT_EQ(2.0, fmu.get(fmu.input));
+
+  fmi2FreeFMUstate(fmu.component, &created);
+  fmi2FreeFMUstate(fmu.component, &state);
+}
+#endif
@@ -0,0 +1,84 @@
+/*
+  Copyright 2023, SINTEF Ocean
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <rapidxml/rapidxml.hpp>
+
+#include "LoggerAdapters.hpp"
+#include "SpscQueue.hpp"
+
+TEST(Logging, SpscQueueBounded) {
+  ddsfmu::detail::SpscQueue<std::string> queue(3);
+  ASSERT_EQ(queue.capacity(), 4);
+
+  for (std::size_t i = 0; i < queue.capacity(); ++i) {
+    EXPECT_TRUE(queue.try_push(std::to_string(i)));
+  }
+  EXPECT_FALSE(queue.try_push("full"));
+
+  std::string value;
+  for (std::size_t i = 0; i < queue.capacity(); ++i) {
+    ASSERT_TRUE(queue.try_pop(value));
+    EXPECT_EQ(value, std::to_string(i));
+  }
+  EXPECT_FALSE(queue.try_pop(value));
+}
+
+TEST(Logging, SpscQueueThreads) {
+  ddsfmu::detail::SpscQueue<int> queue(16);
+  const int count = 100000;
+
+  std::thread producer([&queue, count]() {
+    for (int i = 0; i < count; ++i) {
+      while (!queue.try_push(int(i))) { std::this_thread::yield(); }
+    }
+  });
+
+  int expected = 0;
+  int value;
+  while (expected < count) {
+    if (queue.try_pop(value)) {
+      ASSERT_EQ(value, expected);
+      ++expected;
+    }
+  }
+  producer.join();
+}
+
+TEST(Logging, LoadSettings) {
+  using Kind = ddsfmu::LogSettings::Kind;
+
+  auto defaults = ddsfmu::load_log_settings(nullptr);
+  EXPECT_EQ(defaults.verbosity, Kind::Warning);
+  EXPECT_FALSE(defaults.accepts("RTPS_PARTICIPANT", Kind::Info));
+
+  std::string xml = R"(<logging verbosity="error" max_rate="5" queue_size="32">
+                         <category name="RTPS_PARTICIPANT" verbosity="info"/>
+                       </logging>)";
+  rapidxml::xml_document<> doc;
+  doc.parse<0>(xml.data());
+
+  auto settings = ddsfmu::load_log_settings(doc.first_node("logging"));
+  EXPECT_EQ(settings.verbosity, Kind::Error);
+  EXPECT_DOUBLE_EQ(settings.max_rate, 5.0);
+  EXPECT_EQ(settings.queue_size, 32);
+  EXPECT_EQ(settings.max_verbosity(), Kind::Info);
+  EXPECT_TRUE(settings.accepts("RTPS_PARTICIPANT", Kind::Info));
+  EXPECT_FALSE(settings.accepts("XMLPARSER", Kind::Warning));
+  EXPECT_TRUE(settings.accepts("XMLPARSER", Kind::Error));
+
+  std::string bad = R"(<logging verbosity="chatty"/>)";
+  rapidxml::xml_document<> bad_doc;
+  bad_doc.parse<0>(bad.data());
+  EXPECT_THROW(ddsfmu::load_log_settings(bad_doc.first_node("logging")), std::runtime_error);
+}
@@ -0,0 +1,607 @@
+/*
+  Copyright 2023, SINTEF Ocean
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dlfcn.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <args.hxx>
+#include <fastdds/dds/domain/DomainParticipant.hpp>
+#include <fastdds/dds/domain/DomainParticipantFactory.hpp>
+#include <fastdds/dds/publisher/DataWriter.hpp>
+#include <fastdds/dds/publisher/Publisher.hpp>
+#include <fastdds/dds/subscriber/DataReader.hpp>
+#include <fastdds/dds/subscriber/DataReaderListener.hpp>
+#include <fastdds/dds/subscriber/SampleInfo.hpp>
+#include <fastdds/dds/subscriber/Subscriber.hpp>
+#include <fastdds/dds/topic/Topic.hpp>
+#include <fastrtps/types/DynamicDataFactory.h>
+#include <fastrtps/types/DynamicPubSubType.h>
+#include <fastrtps/types/DynamicTypeBuilder.h>
+#include <fastrtps/xmlparser/XMLProfileManager.h>
+#include <fmi2FunctionTypes.h>
+#include <xtypes/idl/idl.hpp>
+
+#include "Converter.hpp"
+#include "auxiliaries.hpp"
+
+/*
+  End-to-end loopback harness for dds-fmu on a single Linux host.
+
+  The harness loads the dds-fmu module with dlopen and drives it through the FMI C API like
+  a co-simulation master. Each DoStep publishes a `Ping` with an increasing sequence number
+  and its send time, taken from the monotonic clock before the DoStep, on the topic `ping`.
+  A forked fast-dds echo peer takes every `Ping`, records its latency from the send time,
+  which is exact since both processes share the clock, and writes it back on the topic
+  `pong`, which the FMU maps to its outputs.
+
+  `ping_latency_ns` and `ping_received` thus cover every sample taken by the peer. The FMU
+  outputs only show the latest echo after each step, so `rtt_step_ns` is measured from the
+  send time to the end of the DoStep that showed the echo, which rounds it up to the step,
+  and `echoes_seen` counts the echoes shown rather than those received.
+
+  DDS traffic is restricted to shared memory or UDP on the loopback interface, and the
+  results are printed as JSON for trend tracking.
+*/
+
+namespace fs = std::filesystem;
+
+namespace {
+
+namespace edds = eprosima::fastdds::dds;
+namespace etypes = eprosima::fastrtps::types;
+
+using Clock = std::chrono::steady_clock;
+
+/// @private
+struct Options {
+  fs::path module;
+  fs::path output;
+  std::string transport = "shm";
+  double rate = 1000.0; ///< DoStep rate in Hz, or 0 for free running
+  std::uint32_t steps = 10000;
+  std::uint32_t payload = 0; ///< Number of doubles in each Ping in addition to its sequence
+  std::uint32_t domain = 42;
+  double timeout = 10.0; ///< Seconds to wait for the echo peer to match
+  bool reliable = false;
+};
+
+/// @private FMI functions resolved from the dds-fmu module
+struct FmiApi {
+  explicit FmiApi(const fs::path& module) {
+    handle = dlopen(module.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle) { throw std::runtime_error(std::string("Unable to load module: ") + dlerror()); }
+
+    instantiate = resolve<fmi2InstantiateTYPE>("fmi2Instantiate");
+    free_instance = resolve<fmi2FreeInstanceTYPE>("fmi2FreeInstance");
+    setup_experiment = resolve<fmi2SetupExperimentTYPE>("fmi2SetupExperiment");
+    enter_initialization = resolve<fmi2EnterInitializationModeTYPE>("fmi2EnterInitializationMode");
+    exit_initialization = resolve<fmi2ExitInitializationModeTYPE>("fmi2ExitInitializationMode");
+    terminate = resolve<fmi2TerminateTYPE>("fmi2Terminate");
+    do_step = resolve<fmi2DoStepTYPE>("fmi2DoStep");
+    set_integer = resolve<fmi2SetIntegerTYPE>("fmi2SetInteger");
+    get_integer = resolve<fmi2GetIntegerTYPE>("fmi2GetInteger");
+    set_real = resolve<fmi2SetRealTYPE>("fmi2SetReal");
+    get_real = resolve<fmi2GetRealTYPE>("fmi2GetReal");
+  }
+
+  ~FmiApi() { dlclose(handle); }
+
+  FmiApi(const FmiApi&) = delete;
+  FmiApi& operator=(const FmiApi&) = delete;
+
+  template<typename T>
+  T* resolve(const char* name) {
+    auto* function = reinterpret_cast<T*>(dlsym(handle, name));
+    if (!function) { throw std::runtime_error(std::string("Missing FMI function: ") + name); }
+    return function;
+  }
+
+  void* handle;
+  fmi2InstantiateTYPE* instantiate;
+  fmi2FreeInstanceTYPE* free_instance;
+  fmi2SetupExperimentTYPE* setup_experiment;
+  fmi2EnterInitializationModeTYPE* enter_initialization;
+  fmi2ExitInitializationModeTYPE* exit_initialization;
+  fmi2TerminateTYPE* terminate;
+  fmi2DoStepTYPE* do_step;
+  fmi2SetIntegerTYPE* set_integer;
+  fmi2GetIntegerTYPE* get_integer;
+  fmi2SetRealTYPE* set_real;
+  fmi2GetRealTYPE* get_real;
+};
+
+/// @private Nearest-rank percentiles of a set of durations in nanoseconds
+struct Percentiles {
+  explicit Percentiles(std::vector<std::int64_t> values) : count(values.size()) {
+    if (values.empty()) { return; }
+    std::sort(values.begin(), values.end());
+    auto rank = [&](double p) {
+      auto index = static_cast<std::size_t>(std::ceil(p * static_cast<double>(count)));
+      return values[std::clamp<std::size_t>(index, 1, count) - 1];
+    };
+    p50 = rank(0.5);
+    p99 = rank(0.99);
+    p999 = rank(0.999);
+    max = values.back();
+    double sum = 0.0;
+    for (auto value : values) { sum += static_cast<double>(value); }
+    mean = sum / static_cast<double>(count);
+  }
+
+  std::string json() const {
+    std::ostringstream out;
+    out << "{\"count\": " << count << ", \"mean\": " << mean << ", \"p50\": " << p50
+        << ", \"p99\": " << p99 << ", \"p99.9\": " << p999 << ", \"max\": " << max << "}";
+    return out.str();
+  }
+
+  std::size_t count;
+  std::int64_t p50 = 0, p99 = 0, p999 = 0, max = 0;
+  double mean = 0.0;
+};
+
+/// Monotonic time in nanoseconds, which is the same clock in all processes of the host
+std::int64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch())
+    .count();
+}
+
+/// @private Latency of a `Ping` taken by the echo peer
+struct PeerSample {
+  std::int32_t seq;
+  std::int64_t latency_ns;
+};
+
+std::string ping_idl(std::uint32_t payload) {
+  std::ostringstream idl;
+  idl << "struct Ping {\n  int32 seq;\n  double sent_ns;\n";
+  if (payload > 0) { idl << "  double payload[" << payload << "];\n"; }
+  idl << "};\n";
+  return idl.str();
+}
+
+std::string dds_profile(const Options& options) {
+  std::ostringstream xml;
+  const std::string reliability = options.reliable ? "RELIABLE" : "BEST_EFFORT";
+
+  xml << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+      << "<dds xmlns=\"http://www.eprosima.com/XMLSchemas/fastRTPS_Profiles\">\n"
+      << "<profiles>\n"
+      << "  <transport_descriptors>\n"
+      << "    <transport_descriptor>\n"
+      << "      <transport_id>harness</transport_id>\n";
+  if (options.transport == "shm") {
+    xml << "      <type>SHM</type>\n";
+  } else {
+    xml << "      <type>UDPv4</type>\n"
+        << "      <interfaceWhiteList><address>127.0.0.1</address></interfaceWhiteList>\n";
+  }
+  xml << "    </transport_descriptor>\n"
+      << "  </transport_descriptors>\n"
+      << "  <participant profile_name=\"dds-fmu-default\">\n"
+      << "    <domainId>" << options.domain << "</domainId>\n"
+      << "    <rtps>\n"
+      << "      <name>dds-fmu-harness</name>\n"
+      << "      <userTransports><transport_id>harness</transport_id></userTransports>\n"
+      << "      <useBuiltinTransports>false</useBuiltinTransports>\n";
+  if (options.transport == "udp") {
+    xml << "      <builtin>\n"
+        << "        <initialPeersList>\n"
+        << "          <locator><udpv4><address>127.0.0.1</address></udpv4></locator>\n"
+        << "        </initialPeersList>\n"
+        << "      </builtin>\n";
+  }
+  xml << "    </rtps>\n"
+      << "  </participant>\n"
+      << "  <publisher profile_name=\"dds-fmu-default\" />\n"
+      << "  <subscriber profile_name=\"dds-fmu-default\" />\n";
+  for (const std::string topic : {"ping", "pong"}) {
+    xml << "  <data_writer profile_name=\"" << topic << "\">\n"
+        << "    <qos><reliability><kind>" << reliability << "</kind></reliability></qos>\n"
+        << "  </data_writer>\n"
+        << "  <data_reader profile_name=\"" << topic << "\">\n"
+        << "    <topic><historyQos><kind>KEEP_LAST</kind><depth>1</depth></historyQos></topic>\n"
+        << "    <qos><reliability><kind>" << reliability << "</kind></reliability></qos>\n"
+        << "  </data_reader>\n";
+  }
+  xml << "</profiles>\n"
+      << "</dds>\n";
+  return xml.str();
+}
+
+/// Writes FMU resources where the FMU publishes `ping` and subscribes to `pong`
+fs::path write_resources(const Options& options) {
+  auto resources = fs::current_path() / "harness_resources" / "resources";
+  fs::remove_all(resources);
+  fs::create_directories(resources / "config" / "idl");
+  fs::create_directories(resources / "config" / "dds");
+
+  std::ofstream(resources / "config" / "idl" / "dds-fmu.idl") << ping_idl(options.payload);
+  std::ofstream(resources / "config" / "dds" / "dds_profile.xml") << dds_profile(options);
+  std::ofstream(resources / "config" / "dds" / "ddsfmu_mapping.xml")
+    << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    << "<ddsfmu>\n"
+    << "  <fmu_in topic=\"ping\" type=\"Ping\" />\n"
+    << "  <fmu_out topic=\"pong\" type=\"Ping\" />\n"
+    << "</ddsfmu>\n";
+
+  return resources;
+}
+
+/// @private Records the latency of every received sample and writes it back on the other topic
+class EchoListener : public edds::DataReaderListener {
+public:
+  EchoListener(edds::DataWriter* writer, etypes::DynamicData* sample, std::size_t capacity)
+      : m_writer(writer), m_sample(sample) {
+    m_samples.reserve(capacity);
+  }
+
+  void on_data_available(edds::DataReader* reader) override {
+    edds::SampleInfo info;
+    while (reader->take_next_sample(m_sample, &info) == etypes::ReturnCode_t::RETCODE_OK) {
+      if (!info.valid_data) { continue; }
+      const auto sent = static_cast<std::int64_t>(m_sample->get_float64_value(1));
+      m_samples.push_back({m_sample->get_int32_value(0), now_ns() - sent});
+      m_writer->write(m_sample);
+    }
+  }
+
+  /// Samples taken so far, to be read once the reader is deleted
+  const std::vector<PeerSample>& samples() const { return m_samples; }
+
+private:
+  edds::DataWriter* m_writer;
+  etypes::DynamicData* m_sample;
+  std::vector<PeerSample> m_samples;
+};
+
+/**
+   @brief Runs the fast-dds echo peer until the parent closes the pipe
+
+   The latencies of all samples taken are written to the result pipe before returning.
+
+   @param [in] resources FMU resources with the DDS profile and IDL
+   @param [in] options Options of the harness
+   @param [in] pipe_read Read end of a pipe held open by the parent
+   @param [in] result_write Write end of a pipe read by the parent
+   @return Process exit code
+*/
+int run_echo_peer(
+  const fs::path& resources, const Options& options, int pipe_read, int result_write) {
+  auto profile = resources / "config" / "dds" / "dds_profile.xml";
+  if (eprosima::fastrtps::xmlparser::XMLP_ret::XML_OK
+      != eprosima::fastrtps::xmlparser::XMLProfileManager::loadXMLFile(profile.string())) {
+    std::cerr << "Echo peer cannot load XML file " << profile << std::endl;
+    return 1;
+  }
+
+  auto context = eprosima::xtypes::idl::parse(ping_idl(options.payload));
+  if (!context.success) {
+    std::cerr << "Echo peer cannot parse IDL" << std::endl;
+    return 1;
+  }
+  etypes::DynamicType_ptr dyn_type =
+    ddsfmu::Converter::create_builder(context.module().structure("Ping"))->build();
+  etypes::DynamicPubSubType type_support(dyn_type);
+  type_support.setName("Ping");
+  type_support.auto_fill_type_information(false);
+  type_support.auto_fill_type_object(false);
+
+  auto* factory = edds::DomainParticipantFactory::get_instance();
+  auto* participant = factory->create_participant_with_profile("dds-fmu-default");
+  if (!participant) {
+    std::cerr << "Echo peer cannot create participant" << std::endl;
+    return 1;
+  }
+  edds::TypeSupport(&type_support).register_type(participant);
+
+  auto* publisher = participant->create_publisher_with_profile("dds-fmu-default");
+  auto* subscriber = participant->create_subscriber_with_profile("dds-fmu-default");
+  auto* ping = participant->create_topic("ping", "Ping", edds::TOPIC_QOS_DEFAULT);
+  auto* pong = participant->create_topic("pong", "Ping", edds::TOPIC_QOS_DEFAULT);
+  auto* writer = publisher->create_datawriter_with_profile(pong, "pong");
+
+  etypes::DynamicData_ptr sample(etypes::DynamicDataFactory::get_instance()->create_data(dyn_type));
+  // Samples before the measured steps are taken as well, while the driver waits for a match
+  EchoListener listener(writer, sample.get(), 2 * static_cast<std::size_t>(options.steps));
+  auto* reader = subscriber->create_datareader_with_profile(ping, "ping", &listener);
+  if (!writer || !reader) {
+    std::cerr << "Echo peer cannot create DDS entities" << std::endl;
+    return 1;
+  }
+
+  // Blocks until the parent closes its end of the pipe or exits
+  char byte;
+  while (read(pipe_read, &byte, 1) > 0) {}
+
+  participant->delete_contained_entities();
+  factory->delete_participant(participant);
+
+  const auto& samples = listener.samples();
+  const auto* bytes = reinterpret_cast<const char*>(samples.data());
+  std::size_t remaining = samples.size() * sizeof(PeerSample);
+  while (remaining > 0) {
+    const auto written = write(result_write, bytes, remaining);
+    if (written <= 0) { return 1; }
+    bytes += written;
+    remaining -= static_cast<std::size_t>(written);
+  }
+  return 0;
+}
+
+/// Reads the samples written by run_echo_peer() until the peer closes the pipe
+std::vector<PeerSample> read_peer_samples(int result_read) {
+  std::vector<char> bytes;
+  char buffer[65536];
+  ssize_t count;
+  while ((count = read(result_read, buffer, sizeof(buffer))) > 0) {
+    bytes.insert(bytes.end(), buffer, buffer + count);
+  }
+  std::vector<PeerSample> samples(bytes.size() / sizeof(PeerSample));
+  std::copy_n(
+    bytes.data(), samples.size() * sizeof(PeerSample), reinterpret_cast<char*>(samples.data()));
+  return samples;
+}
+
+std::int64_t cpu_ns(const rusage& usage) {
+  auto to_ns = [](const timeval& time) {
+    return static_cast<std::int64_t>(time.tv_sec) * 1000000000 + time.tv_usec * 1000;
+  };
+  return to_ns(usage.ru_utime) + to_ns(usage.ru_stime);
+}
+
+void fmi_logger(fmi2ComponentEnvironment, fmi2String, fmi2Status, fmi2String, fmi2String, ...) {}
+
+/**
+   @brief Drives the FMU and writes the JSON results measured by the driver
+
+   @param [in] options Options of the harness
+   @param [in] resources FMU resources
+   @param [out] first_seq Sequence number of the first measured step
+   @return Process exit code
+*/
+int run_driver(const Options& options, const fs::path& resources, std::int32_t& first_seq) {
+  FmiApi fmi(options.module);
+  const fmi2CallbackFunctions callbacks = {fmi_logger, std::calloc, std::free, nullptr, nullptr};
+
+  auto guid =
+    ddsfmu::config::generate_uuid(ddsfmu::config::get_uuid_files(resources.parent_path(), true));
+  auto uri = "file://" + resources.generic_string();
+  fmi2Component component = fmi.instantiate(
+    "harness", fmi2CoSimulation, guid.c_str(), uri.c_str(), &callbacks, fmi2False, fmi2False);
+  if (!component) {
+    std::cerr << "Could not instantiate dds-fmu" << std::endl;
+    return 1;
+  }
+  fmi.setup_experiment(component, fmi2False, 0.0, 0.0, fmi2False, 0.0);
+  fmi.enter_initialization(component);
+  fmi.exit_initialization(component);
+
+  // Outputs are enumerated before inputs: integer 0 is pong.seq and integer 1 is ping.seq,
+  // real 0 is pong.sent_ns, followed by the pong payload, ping.sent_ns and the ping payload
+  const fmi2ValueReference pong_seq = 0, ping_seq = 1;
+  const fmi2ValueReference pong_sent = 0, ping_sent = options.payload + 1;
+  std::vector<fmi2ValueReference> ping_payload(options.payload);
+  for (std::uint32_t i = 0; i < options.payload; ++i) { ping_payload[i] = ping_sent + 1 + i; }
+  std::vector<fmi2Real> payload_values(options.payload, 1.0);
+
+  const fmi2Real step_size = options.rate > 0.0 ? 1.0 / options.rate : 1e-3;
+  fmi2Real time = 0.0, echoed_sent = 0.0;
+  fmi2Integer seq = 0, received_seq = 0;
+
+  auto step = [&]() {
+    ++seq;
+    fmi.set_integer(component, &ping_seq, 1, &seq);
+    if (!ping_payload.empty()) {
+      fmi.set_real(component, ping_payload.data(), ping_payload.size(), payload_values.data());
+    }
+    const auto sent = static_cast<fmi2Real>(now_ns());
+    fmi.set_real(component, &ping_sent, 1, &sent);
+    fmi.do_step(component, time, step_size, fmi2True);
+    fmi.get_integer(component, &pong_seq, 1, &received_seq);
+    fmi.get_real(component, &pong_sent, 1, &echoed_sent);
+    time += step_size;
+  };
+
+  // Step until the echo peer has matched and returns samples
+  const auto deadline = Clock::now() + std::chrono::duration<double>(options.timeout);
+  while (received_seq == 0) {
+    if (Clock::now() > deadline) {
+      std::cerr << "Timeout while waiting for echo peer" << std::endl;
+      fmi.free_instance(component);
+      return 1;
+    }
+    step();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  first_seq = seq + 1;
+  std::vector<std::int64_t> step_ns, rtt_step_ns;
+  step_ns.reserve(options.steps);
+  rtt_step_ns.reserve(options.steps);
+  fmi2Integer last_seq = 0;
+
+  const auto period = options.rate > 0.0
+                        ? std::chrono::duration_cast<Clock::duration>(
+                          std::chrono::duration<double>(1.0 / options.rate))
+                        : Clock::duration::zero();
+
+  rusage usage_begin, usage_end;
+  getrusage(RUSAGE_SELF, &usage_begin);
+  const auto begin = Clock::now();
+  auto next = begin;
+
+  for (std::uint32_t i = 0; i < options.steps; ++i) {
+    const auto start = now_ns();
+    step();
+    const auto end = now_ns();
+    step_ns.push_back(end - start);
+
+    // Only the latest echo is visible after a step, so intermediate samples are not timed
+    if (received_seq >= first_seq && received_seq > last_seq) {
+      rtt_step_ns.push_back(end - static_cast<std::int64_t>(echoed_sent));
+      last_seq = received_seq;
+    }
+
+    if (period != Clock::duration::zero()) {
+      next += period;
+      std::this_thread::sleep_until(next);
+    }
+  }
+
+  const auto elapsed = std::chrono::duration<double>(Clock::now() - begin).count();
+  getrusage(RUSAGE_SELF, &usage_end);
+
+  fmi.terminate(component);
+  fmi.free_instance(component);
+
+  const double cpu_percent =
+    100.0 * static_cast<double>(cpu_ns(usage_end) - cpu_ns(usage_begin)) / (elapsed * 1e9);
+
+  std::ostringstream json;
+  json << "{\n"
+       << "  \"transport\": \"" << options.transport << "\",\n"
+       << "  \"reliable\": " << std::boolalpha << options.reliable << ",\n"
+       << "  \"rate_hz\": " << options.rate << ",\n"
+       << "  \"payload_doubles\": " << options.payload << ",\n"
+       << "  \"steps\": " << options.steps << ",\n"
+       << "  \"elapsed_s\": " << elapsed << ",\n"
+       << "  \"step_ns\": " << Percentiles(step_ns).json() << ",\n"
+       << "  \"rtt_step_ns\": " << Percentiles(rtt_step_ns).json() << ",\n"
+       << "  \"sent\": " << options.steps << ",\n"
+       << "  \"sent_per_s\": " << options.steps / elapsed << ",\n"
+       << "  \"echoes_seen\": " << rtt_step_ns.size() << ",\n"
+       << "  \"cpu_percent\": " << cpu_percent;
+
+  if (options.output.empty()) {
+    std::cout << json.str();
+  } else {
+    std::ofstream(options.output) << json.str();
+  }
+  return 0;
+}
+
+}
+
+int main(int argc, const char* argv[]) {
+  args::ArgumentParser parser(
+    "dds-fmu loopback harness",
+    "Measures step time and round-trip latency of dds-fmu against a local echo peer.");
+  args::HelpFlag help(parser, "help", "Display this help menu", {'h', "help"});
+  args::ValueFlag<std::string> module(
+    parser, "PATH", "dds-fmu module (Default: built module)", {'m', "module"}, DDSFMU_MODULE);
+  args::ValueFlag<std::string> output(
+    parser, "FILENAME", "Write JSON results to file instead of stdout", {'o', "output"});
+  args::MapFlag<std::string, std::string> transport(
+    parser, "TRANSPORT", "Transport: shm or udp (Default: shm)", {'t', "transport"},
+    {{"shm", "shm"}, {"udp", "udp"}}, "shm");
+  args::ValueFlag<double> rate(
+    parser, "HZ", "DoStep rate in Hz, 0 for free running (Default: 1000)", {'r', "rate"}, 1000.0);
+  args::ValueFlag<std::uint32_t> steps(
+    parser, "N", "Number of measured steps (Default: 10000)", {'n', "steps"}, 10000);
+  args::ValueFlag<std::uint32_t> payload(
+    parser, "N", "Number of doubles in each sample (Default: 0)", {'p', "payload"}, 0);
+  args::ValueFlag<std::uint32_t> domain(
+    parser, "ID", "DDS domain id (Default: 42)", {'d', "domain"}, 42);
+  args::Flag reliable(parser, "reliable", "Use RELIABLE instead of BEST_EFFORT", {"reliable"});
+
+  try {
+    parser.ParseCLI(argc, argv);
+  } catch (const args::Help&) {
+    std::cout << parser;
+    return 0;
+  } catch (const args::Error& e) {
+    std::cerr << e.what() << std::endl << parser;
+    return 1;
+  }
+
+  Options options;
+  options.module = args::get(module);
+  options.output = args::get(output);
+  options.transport = args::get(transport);
+  options.rate = args::get(rate);
+  options.steps = std::max<std::uint32_t>(args::get(steps), 1);
+  options.payload = args::get(payload);
+  options.domain = args::get(domain);
+  options.reliable = reliable;
+
+  auto resources = write_resources(options);
+
+  // Fork before any DDS entity exists, such that the peer gets its own participant and threads
+  int pipe_fds[2], result_fds[2];
+  if (pipe(pipe_fds) != 0 || pipe(result_fds) != 0) {
+    std::cerr << "Unable to create pipe" << std::endl;
+    return 1;
+  }
+  const auto peer_begin = Clock::now();
+  pid_t peer = fork();
+  if (peer < 0) {
+    std::cerr << "Unable to fork echo peer" << std::endl;
+    return 1;
+  }
+  if (peer == 0) {
+    close(pipe_fds[1]);
+    close(result_fds[0]);
+    std::exit(run_echo_peer(resources, options, pipe_fds[0], result_fds[1]));
+  }
+  close(pipe_fds[0]);
+  close(result_fds[1]);
+
+  int result = 1;
+  std::int32_t first_seq = std::numeric_limits<std::int32_t>::max();
+  try {
+    result = run_driver(options, resources, first_seq);
+  } catch (const std::exception& e) { std::cerr << "ERROR: " << e.what() << std::endl; }
+
+  close(pipe_fds[1]);
+  const auto peer_samples = read_peer_samples(result_fds[0]);
+  close(result_fds[0]);
+  int status = 0;
+  rusage peer_usage{};
+  wait4(peer, &status, 0, &peer_usage);
+  const auto peer_elapsed = std::chrono::duration<double>(Clock::now() - peer_begin).count();
+
+  if (result == 0) {
+    // Only pings of the measured steps count, not those sent while waiting for the match
+    std::vector<std::int64_t> ping_latency_ns;
+    ping_latency_ns.reserve(peer_samples.size());
+    for (const auto& sample : peer_samples) {
+      if (sample.seq >= first_seq) { ping_latency_ns.push_back(sample.latency_ns); }
+    }
+
+    std::ostringstream tail;
+    tail << ",\n  \"ping_latency_ns\": " << Percentiles(ping_latency_ns).json()
+         << ",\n  \"ping_received\": " << ping_latency_ns.size()
+         << ",\n  \"peer_cpu_percent\": "
+         << 100.0 * static_cast<double>(cpu_ns(peer_usage)) / (peer_elapsed * 1e9) << "\n}\n";
+    if (options.output.empty()) {
+      std::cout << tail.str();
+    } else {
+      std::ofstream(options.output, std::ios::app) << tail.str();
+    }
+  }
+  return result != 0 ? result : (WIFEXITED(status) ? WEXITSTATUS(status) : 1);
+}
@@ -13,6 +13,7 @@
 #include <xtypes/idl/idl.hpp>
 
 #include "model-descriptor.hpp"
+#include "qos-profiles.hpp"
 
 
 TEST(ModelDescriptor, NameGenerator) {
@@ -74,7 +75,49 @@ TEST(ModelDescriptor, NameGenerator) {
   EXPECT_EQ(names[8], std::string("matrix[2,0]"));
   EXPECT_EQ(names[9], std::string("matrix[2,1]"));
 
-  // TODO: support sequence type, wstring type, map type
+  // TODO: support wstring type, map type
+}
+
+TEST(ModelDescriptor, SequenceNames) {
+  std::string my_idl = R"~~~(
+    struct Point
+    {
+        double x;
+    };
+
+    struct Cloud
+    {
+        sequence<Point, 2> points;
+        sequence<uint8, 2> bytes;
+    };
+)~~~";
+
+  eprosima::xtypes::idl::Context context;
+  context.preprocess = false;
+  context = eprosima::xtypes::idl::parse(my_idl, context);
+
+  eprosima::xtypes::DynamicData data(context.module().structure("Cloud"));
+  data["points"].resize(2);
+  data["bytes"].resize(2);
+
+  std::vector<std::string> names;
+  data.for_each([&](eprosima::xtypes::DynamicData::ReadableNode& node) {
+    bool is_leaf = node.type().is_primitive_type();
+    bool is_sequence = node.type().kind() == eprosima::xtypes::TypeKind::SEQUENCE_TYPE;
+    if (is_leaf || is_sequence) {
+      std::string ret;
+      ddsfmu::config::name_generator(ret, node);
+      names.push_back(ret);
+    }
+  });
+
+  ASSERT_EQ(names.size(), 6);
+  EXPECT_EQ(names[0], std::string("points"));
+  EXPECT_EQ(names[1], std::string("points[0].x"));
+  EXPECT_EQ(names[2], std::string("points[1].x"));
+  EXPECT_EQ(names[3], std::string("bytes"));
+  EXPECT_EQ(names[4], std::string("bytes[0]"));
+  EXPECT_EQ(names[5], std::string("bytes[1]"));
 }
 
 TEST(ModelDescriptor, ScalarVariable) {
@@ -111,3 +154,61 @@ TEST(ModelDescriptor, ModelStructure) {
     std::string("<ModelStructure>\n\t<Outputs>\n\t\t<Unknown index=\"1\"/>\n\t\t<Unknown index=\"2\"/>\n\t\t<Unknown index=\"3\"/>\n\t</Outputs>\n</ModelStructure>\n\n"));
   // clang-format on
 }
+
+TEST(ModelDescriptor, QosProfiles) {
+  std::string my_idl = R"~~~(
+    struct Trivial
+    {
+        double val;
+    };
+
+    struct Bounded
+    {
+        uint8 flag;
+        double x;
+        sequence<int16, 4> values;
+        string<10> name;
+    };
+
+    struct Unbounded
+    {
+        double x;
+        string name;
+    };
+)~~~";
+
+  eprosima::xtypes::idl::Context context;
+  context.preprocess = false;
+  context = eprosima::xtypes::idl::parse(my_idl, context);
+
+  namespace ddsconf = ddsfmu::config;
+
+  // Encapsulation header and padding of the double to 8 bytes
+  EXPECT_EQ(ddsconf::max_serialized_size(context.module().structure("Trivial")), 4 + 8);
+  EXPECT_EQ(
+    ddsconf::max_serialized_size(context.module().structure("Bounded")),
+    4 + (1 + 7) + 8 + (4 + 2 * 4) + (4 + 10 + 1));
+  EXPECT_FALSE(ddsconf::max_serialized_size(context.module().structure("Unbounded")));
+
+  EXPECT_EQ(ddsconf::parse_topic_kind("event"), ddsconf::TopicKind::Event);
+  EXPECT_THROW(ddsconf::parse_topic_kind("stream"), std::runtime_error);
+
+  std::vector<ddsconf::TopicProfile> profiles{
+    {"position", ddsconf::TopicKind::State, true, 12},
+    {"alarm", ddsconf::TopicKind::Event, false, std::nullopt},
+    {"setpoint", ddsconf::TopicKind::Command, true, 12}};
+  auto xml = ddsconf::generate_qos_profiles(profiles, {"data_writer:setpoint"});
+
+  EXPECT_NE(xml.find("<data_writer profile_name=\"position\">"), std::string::npos);
+  EXPECT_NE(xml.find("<kind>BEST_EFFORT</kind>"), std::string::npos);
+  EXPECT_NE(xml.find("<historyMemoryPolicy>PREALLOCATED</historyMemoryPolicy>"), std::string::npos);
+  EXPECT_NE(xml.find("<data_reader profile_name=\"alarm\">"), std::string::npos);
+  EXPECT_NE(xml.find("<depth>32</depth>"), std::string::npos);
+  EXPECT_NE(
+    xml.find("<historyMemoryPolicy>PREALLOCATED_WITH_REALLOC</historyMemoryPolicy>"),
+    std::string::npos);
+
+  // Profiles defined by the user are not overridden
+  EXPECT_EQ(xml.find("setpoint"), std::string::npos);
+  EXPECT_EQ(xml.find("TRANSIENT_LOCAL"), std::string::npos);
+}
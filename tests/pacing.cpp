@@ -0,0 +1,44 @@
+/*
+  Copyright 2023, SINTEF Ocean
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include <chrono>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "RealtimePacer.hpp"
+
+TEST(RealtimePacer, AbsoluteDeadlines) {
+  using Clock = ddsfmu::detail::RealtimePacer::Clock;
+  ddsfmu::detail::RealtimePacer pacer;
+  EXPECT_FALSE(pacer.enabled());
+
+  // Twice as fast as real time: 10 ms steps take 5 ms of wall-clock time
+  pacer.configure(2.0);
+  ASSERT_TRUE(pacer.enabled());
+
+  const auto begin = Clock::now();
+  for (int step = 0; step <= 10; ++step) { pacer.pace(0.01 * step); }
+  const auto elapsed = Clock::now() - begin;
+  EXPECT_GE(elapsed, std::chrono::milliseconds(50));
+  EXPECT_LT(elapsed, std::chrono::milliseconds(500));
+  EXPECT_EQ(0u, pacer.overruns());
+
+  // A late step is an overrun, and the next step is paced from it
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  pacer.pace(0.11);
+  EXPECT_EQ(1u, pacer.overruns());
+  EXPECT_GE(pacer.jitter_ns(), 10'000'000u);
+
+  const auto late = Clock::now();
+  pacer.pace(0.12);
+  EXPECT_GE(Clock::now() - late, std::chrono::milliseconds(4));
+  EXPECT_EQ(1u, pacer.overruns());
+
+  pacer.restart();
+  EXPECT_EQ(0u, pacer.overruns());
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+/*
+  Copyright 2023, SINTEF Ocean
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+/**
+   @brief Copies test resources to a scratch folder with a custom ddsfmu mapping
+
+   Tests for mapping options need their own ddsfmu_mapping.xml. This copies the test
+   resources to a folder next to them and overwrites the mapping with the given contents.
+
+   @param [in] name Name of scratch folder, unique for each test
+   @param [in] mapping Contents of ddsfmu_mapping.xml
+   @return Path to the scratch resources folder
+*/
+inline std::filesystem::path
+  scratch_resources(const std::string& name, const std::string& mapping) {
+  auto resources = std::filesystem::current_path() / "resources";
+  auto scratch = std::filesystem::current_path() / "scratch" / name;
+
+  std::filesystem::remove_all(scratch);
+  std::filesystem::create_directories(scratch);
+  std::filesystem::copy(resources, scratch, std::filesystem::copy_options::recursive);
+
+  std::ofstream(scratch / "config" / "dds" / "ddsfmu_mapping.xml", std::ios::trunc) << mapping;
+  return scratch;
+}
@@ -0,0 +1,117 @@
+/*
+  Copyright 2023, SINTEF Ocean
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Tracer.hpp"
+
+TEST(Tracer, RingOverwritesOldest) {
+  using ddsfmu::detail::TraceEvent;
+  using ddsfmu::detail::TraceRing;
+
+  TraceRing ring(1);
+  const std::uint64_t pushed = TraceRing::Capacity + 10;
+  for (std::uint64_t i = 0; i < pushed; ++i) {
+    ring.push({"event", i, 0, TraceEvent::NoInstance, TraceEvent::NoTopic, 'i'});
+  }
+
+  std::vector<TraceEvent> events;
+  ring.snapshot(events);
+
+  // The slot of the oldest event is reserved for the next push
+  ASSERT_EQ(events.size(), TraceRing::Capacity - 1);
+  EXPECT_EQ(events.front().begin_ns, pushed - TraceRing::Capacity + 1);
+  EXPECT_EQ(events.back().begin_ns, pushed - 1);
+}
+
+TEST(Tracer, SnapshotWhileRecording) {
+  using ddsfmu::detail::TraceEvent;
+  using ddsfmu::detail::TraceRing;
+
+  TraceRing ring(1);
+  std::atomic<bool> done{false};
+  std::thread recorder([&ring, &done]() {
+    for (std::uint64_t i = 0; i < 8 * TraceRing::Capacity; ++i) {
+      ring.push({"event", i, i, static_cast<std::uint32_t>(i), static_cast<std::uint32_t>(i), 'X'});
+    }
+    done = true;
+  });
+
+  // Events being overwritten are skipped, such that all copied events are consistent
+  std::vector<TraceEvent> events;
+  while (!done) {
+    events.clear();
+    ring.snapshot(events);
+    for (std::size_t i = 0; i < events.size(); ++i) {
+      ASSERT_EQ(events[i].begin_ns, events[i].duration_ns);
+      ASSERT_EQ(static_cast<std::uint32_t>(events[i].begin_ns), events[i].topic);
+      if (i > 0) { ASSERT_LT(events[i - 1].begin_ns, events[i].begin_ns); }
+    }
+  }
+  recorder.join();
+}
+
+TEST(Tracer, ChromeTraceJson) {
+  auto output = std::filesystem::temp_directory_path() / "ddsfmu_tracer_test.json";
+  std::filesystem::remove(output);
+
+  {
+    ddsfmu::detail::Tracer disabled("");
+    EXPECT_FALSE(disabled.enabled());
+    EXPECT_FALSE(disabled.dump());
+  }
+
+  {
+    // The tracer dumps on destruction as well
+    ddsfmu::detail::Tracer tracer(output);
+    ASSERT_TRUE(tracer.enabled());
+    const auto first = tracer.add_instance("first");
+    const auto second = tracer.add_instance("second");
+    ASSERT_NE(first, second);
+    // Data store indices of different instances are distinct topics
+    tracer.name_topic(first, 3, "my_topic");
+    tracer.name_topic(second, 3, "other_topic");
+
+    tracer.complete(
+      "DoStep", ddsfmu::detail::Tracer::now_ns(), first, ddsfmu::detail::TraceEvent::NoTopic);
+    std::thread receiver([&tracer, second]() { tracer.instant("filter.reject", second, 3); });
+    receiver.join();
+
+    ASSERT_TRUE(tracer.dump());
+  }
+
+  std::ifstream in(output);
+  std::stringstream json;
+  json << in.rdbuf();
+  const auto text = json.str();
+
+  EXPECT_NE(text.find(R"("traceEvents":[)"), std::string::npos);
+  EXPECT_NE(
+    text.find(R"("name":"process_name","ph":"M","pid":1,"args":{"name":"first"})"),
+    std::string::npos);
+  EXPECT_NE(
+    text.find(R"("name":"process_name","ph":"M","pid":2,"args":{"name":"second"})"),
+    std::string::npos);
+  EXPECT_NE(
+    text.find(R"("name":"DoStep","cat":"ddsfmu","ph":"X","pid":1,"tid":1)"), std::string::npos);
+  EXPECT_NE(
+    text.find(R"("name":"filter.reject","cat":"ddsfmu","ph":"i","pid":2,"tid":2)"),
+    std::string::npos);
+  EXPECT_NE(text.find(R"("args":{"topic":3,"topic_name":"other_topic"})"), std::string::npos);
+  EXPECT_EQ(text.find(R"("topic_name":"my_topic")"), std::string::npos);
+
+  std::filesystem::remove(output);
+}
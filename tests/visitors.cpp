@@ -5,8 +5,11 @@
   file, You can obtain one at http://mozilla.org/MPL/2.0/.
 */
 
+#include <cstddef>
 #include <filesystem>
 #include <functional>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
 #include <gtest/gtest.h>
@@ -14,7 +17,9 @@
 #include <xtypes/idl/idl.hpp>
 
 #include "DataMapper.hpp"
+#include "Interpolator.hpp"
 #include "model-descriptor.hpp"
+#include "scratch_resources.hpp"
 
 TEST(Visitors, Principle) {
   std::string my_idl = R"~~~(
@@ -113,6 +118,47 @@ TEST(Visitors, Principle) {
 }
 
 
+TEST(Visitors, StringVariable) {
+  std::string my_idl = R"~~~(
+    struct Named
+    {
+        string<8> bounded;
+        string unbounded;
+        char ch;
+    };
+)~~~";
+  eprosima::xtypes::idl::Context context;
+  context.preprocess = false;
+  context = eprosima::xtypes::idl::parse(my_idl, context);
+  ASSERT_TRUE(context.success) << "Successful parsing";
+
+  eprosima::xtypes::DynamicData data(context.module().structure("Named"));
+  ddsfmu::detail::StringVariable bounded(data["bounded"]);
+  ddsfmu::detail::StringVariable unbounded(data["unbounded"]);
+  ddsfmu::detail::StringVariable ch(data["ch"]);
+
+  // Bounded strings are truncated to their bound, and their capacity is reserved
+  bounded.set("Hello World");
+  EXPECT_STREQ(bounded.get(), "Hello Wo");
+  EXPECT_EQ(data["bounded"].value<std::string>(), "Hello Wo");
+  const char* before = bounded.get();
+  bounded.set("Hi");
+  EXPECT_EQ(before, bounded.get()) << "Assigning within the bound does not reallocate";
+  EXPECT_STREQ(bounded.get(), "Hi");
+
+  // Pointers refer to the data store, so they are stable while it is unmodified
+  unbounded.set(std::string(40, 'x').c_str());
+  const char* first = unbounded.get();
+  EXPECT_EQ(first, unbounded.get());
+  EXPECT_EQ(std::string(first), std::string(40, 'x'));
+
+  ch.set("!?");
+  EXPECT_STREQ(ch.get(), "!");
+  EXPECT_EQ(data["ch"].value<char>(), '!');
+  ch.set("");
+  EXPECT_STREQ(ch.get(), "");
+}
+
 TEST(DataMapper, Visitors) {
   // This test assumes that msg_read is the first listed <fmu_out> in ddsfmu_mapping, and that msg_write is the first <fmu_in>
   // It will fail otherwise
@@ -274,3 +320,121 @@ TEST(DataMapper, Visitors) {
   EXPECT_TRUE(dyn_data == dyn_data2)
     << "Dynamic data read and written to same data structures shall be equal";
 }
+
+TEST(DataMapper, ContiguousStores) {
+  ddsfmu::DataMapper data_mapper;
+  data_mapper.reset(std::filesystem::current_path() / "resources");
+
+  // Data stores are laid out in store index order within one block of memory
+  ASSERT_EQ(4u, data_mapper.store_count());
+  for (std::size_t store = 1; store < data_mapper.store_count(); ++store) {
+    const auto& previous = data_mapper.data_ref(store - 1);
+    const auto& current = data_mapper.data_ref(store);
+    EXPECT_EQ(
+      previous.instance_id() + previous.type().memory_size()
+        + (alignof(std::max_align_t) - previous.type().memory_size() % alignof(std::max_align_t))
+            % alignof(std::max_align_t),
+      current.instance_id());
+  }
+
+  // Dense store handles give the same data and offsets as topic lookup
+  auto store = data_mapper.store_index("msg_write", ddsfmu::DataMapper::Direction::Write);
+  EXPECT_EQ(
+    &data_mapper.data_ref("msg_write", ddsfmu::DataMapper::Direction::Write),
+    &data_mapper.data_ref(store));
+  EXPECT_EQ(
+    data_mapper.index_offsets("msg_write", ddsfmu::DataMapper::Direction::Write),
+    data_mapper.index_offsets(store));
+
+  // Soft reset keeps the instances in place
+  auto first = data_mapper.data_ref(0).instance_id();
+  data_mapper.soft_reset();
+  EXPECT_EQ(first, data_mapper.data_ref(0).instance_id());
+}
+
+TEST(Visitors, Interpolator) {
+  using ddsfmu::detail::Interpolation;
+  ddsfmu::detail::Interpolator linear(Interpolation::Linear, 2);
+  EXPECT_EQ(2u, linear.signals());
+
+  // Nothing to evaluate without samples, and a single sample is held
+  linear.output()[0] = 7.0;
+  linear.evaluate(1.0);
+  EXPECT_EQ(7.0, linear.output()[0]);
+
+  double* values = linear.sample(0.0);
+  values[0] = 0.0;
+  values[1] = 10.0;
+  linear.evaluate(0.5);
+  EXPECT_EQ(0.0, linear.output()[0]);
+  EXPECT_EQ(10.0, linear.output()[1]);
+
+  // Ramps from the previous to the latest sample over their interval
+  values = linear.sample(1.0);
+  values[0] = 2.0;
+  values[1] = 20.0;
+  EXPECT_EQ(2u, linear.samples());
+  linear.evaluate(1.0);
+  EXPECT_DOUBLE_EQ(0.0, linear.output()[0]);
+  linear.evaluate(1.5);
+  EXPECT_DOUBLE_EQ(1.0, linear.output()[0]);
+  EXPECT_DOUBLE_EQ(15.0, linear.output()[1]);
+  linear.evaluate(3.0);
+  EXPECT_DOUBLE_EQ(2.0, linear.output()[0]);
+
+  // A sample at the same time replaces the latest one
+  linear.sample(1.0)[0] = 4.0;
+  linear.evaluate(1.5);
+  EXPECT_DOUBLE_EQ(2.0, linear.output()[0]);
+
+  ddsfmu::detail::Interpolator extrapolate(Interpolation::Extrapolate, 1);
+  extrapolate.sample(0.0)[0] = 1.0;
+  extrapolate.sample(0.5)[0] = 2.0;
+  extrapolate.evaluate(1.0);
+  EXPECT_DOUBLE_EQ(3.0, extrapolate.output()[0]);
+
+  ddsfmu::detail::Interpolator hold(Interpolation::Hold, 1);
+  hold.sample(0.0)[0] = 1.0;
+  hold.sample(0.5)[0] = 2.0;
+  hold.evaluate(0.75);
+  EXPECT_EQ(2.0, hold.output()[0]);
+
+  // Clearing keeps the output until the next sample
+  hold.clear();
+  EXPECT_EQ(0u, hold.samples());
+  hold.evaluate(1.0);
+  EXPECT_EQ(2.0, hold.output()[0]);
+
+  EXPECT_THROW(ddsfmu::detail::parse_interpolation("cubic"), std::runtime_error);
+}
+
+TEST(DataMapper, Interpolation) {
+  auto resources = scratch_resources("interpolation", R"(<?xml version="1.0" encoding="UTF-8"?>
+<ddsfmu>
+  <fmu_out topic="interpolated" type="Trivial" interpolation="linear" />
+</ddsfmu>
+)");
+  ddsfmu::DataMapper data_mapper;
+  data_mapper.reset(resources);
+  ASSERT_TRUE(data_mapper.has_interpolation());
+
+  auto store = data_mapper.store_index("interpolated", ddsfmu::DataMapper::Direction::Read);
+  auto& dyn_read = data_mapper.data_ref(store);
+  double value = -1.0;
+
+  dyn_read["val"] = 1.0;
+  data_mapper.sample_taken(store, 0.0);
+  dyn_read["val"] = 3.0;
+  data_mapper.sample_taken(store, 1.0);
+
+  // The getter returns the interpolated value, while the data store keeps the sample
+  data_mapper.interpolate(1.5);
+  data_mapper.get_double(0, value);
+  EXPECT_DOUBLE_EQ(2.0, value);
+  EXPECT_EQ(3.0, dyn_read["val"].value<double>());
+
+  // After a soft reset the getter returns the data store again
+  data_mapper.soft_reset();
+  data_mapper.get_double(0, value);
+  EXPECT_EQ(dyn_read["val"].value<double>(), value);
+}
@@ -5,8 +5,11 @@
   file, You can obtain one at http://mozilla.org/MPL/2.0/.
 */
 
+#include <cstdint>
 #include <filesystem>
 #include <functional>
+#include <map>
+#include <string>
 #include <vector>
 
 #include <fastdds/dds/domain/DomainParticipant.hpp>
@@ -14,12 +17,16 @@
 #include <fastrtps/types/DynamicDataFactory.h>
 #include <fastrtps/types/DynamicPubSubType.h>
 #include <fastrtps/types/DynamicTypeBuilder.h>
+#include <fastrtps/types/DynamicTypeBuilderFactory.h>
+#include <fastrtps/types/DynamicTypeMember.h>
 #include <fastrtps/types/DynamicTypePtr.h>
+#include <fastrtps/types/TypeObjectFactory.h>
 #include <gtest/gtest.h>
 #include <xtypes/idl/idl.hpp>
 #include <xtypes/xtypes.hpp>
 
 #include "Converter.hpp"
+#include "TypeObjects.hpp"
 
 
 TEST(XTypes, BasicUsage) {
@@ -194,3 +201,297 @@ TEST(XTypes, FloatingTypes) {
   EXPECT_TRUE(context.success) << "IDL parsing successful";
 
 }
+
+TEST(XTypes, PrimitiveArrays) {
+  std::string my_idl = R"~~~(
+  enum Color { RED, GREEN, BLUE };
+  struct Grid
+  {
+    uint32 matrix[5][2];
+    double cube[2][3][4];
+    boolean flags[3];
+    Color colors[2];
+    string names[2];
+  };
+  )~~~";
+
+  eprosima::xtypes::idl::Context context;
+  context.preprocess = false;
+  context = eprosima::xtypes::idl::parse(my_idl, context);
+  ASSERT_TRUE(context.success) << "IDL parsing successful";
+
+  const auto& grid_type = context.module().structure("Grid");
+  eprosima::xtypes::DynamicData sent(grid_type);
+  for (std::uint32_t i = 0; i < 5; ++i) {
+    for (std::uint32_t j = 0; j < 2; ++j) { sent["matrix"][i][j] = i * 10 + j; }
+  }
+  for (std::uint32_t i = 0; i < 2; ++i) {
+    for (std::uint32_t j = 0; j < 3; ++j) {
+      for (std::uint32_t k = 0; k < 4; ++k) { sent["cube"][i][j][k] = i * 100.0 + j * 10.0 + k; }
+    }
+  }
+  sent["flags"][1] = true;
+  sent["colors"][1] = std::uint32_t(2);
+  sent["names"][1] = std::string("slow path");
+
+  namespace etypes = eprosima::fastrtps::types;
+  etypes::DynamicTypeBuilder* builder = ddsfmu::Converter::create_builder(grid_type);
+  ASSERT_NE(builder, nullptr);
+  etypes::DynamicData_ptr fastdds_data(
+    etypes::DynamicDataFactory::get_instance()->create_data(builder->build()));
+  ASSERT_TRUE(ddsfmu::Converter::xtypes_to_fastdds(sent, fastdds_data.get()));
+
+  // Flat ids of fast-dds arrays are row-major, as the memory of xtypes arrays
+  etypes::DynamicData* matrix =
+    fastdds_data->loan_value(fastdds_data->get_member_id_by_name("matrix"));
+  std::uint32_t value = 0;
+  matrix->get_uint32_value(value, matrix->get_array_index({3, 1}));
+  EXPECT_EQ(31u, value);
+  fastdds_data->return_loaned_value(matrix);
+
+  eprosima::xtypes::DynamicData received(grid_type);
+  ASSERT_TRUE(ddsfmu::Converter::fastdds_to_xtypes(fastdds_data.get(), received));
+  EXPECT_EQ(sent, received);
+  EXPECT_EQ(123.0, received["cube"][1][2][3].value<double>());
+
+  ddsfmu::Converter::clear_data_structures();
+}
+
+TEST(XTypes, PrimitiveContainers) {
+  std::string my_idl = R"~~~(
+  struct Series
+  {
+    sequence<double> values;
+    sequence<uint8> bytes;
+    map<int32, double> table;
+  };
+  )~~~";
+
+  eprosima::xtypes::idl::Context context;
+  context.preprocess = false;
+  context = eprosima::xtypes::idl::parse(my_idl, context);
+  ASSERT_TRUE(context.success) << "IDL parsing successful";
+
+  const auto& series_type = context.module().structure("Series");
+  const auto& key_type = eprosima::xtypes::primitive_type<std::int32_t>();
+
+  namespace etypes = eprosima::fastrtps::types;
+  etypes::DynamicTypeBuilder* builder = ddsfmu::Converter::create_builder(series_type);
+  ASSERT_NE(builder, nullptr);
+  etypes::DynamicData_ptr fastdds_data(
+    etypes::DynamicDataFactory::get_instance()->create_data(builder->build()));
+  eprosima::xtypes::DynamicData received(series_type);
+
+  // Samples grow, shrink and change keys, while both sides are reused between samples
+  auto round_trip = [&](std::size_t length, std::vector<std::int32_t> keys, double offset) {
+    eprosima::xtypes::DynamicData sent(series_type);
+    for (std::size_t i = 0; i < length; ++i) {
+      sent["values"].push(offset + static_cast<double>(i));
+      sent["bytes"].push(static_cast<std::uint8_t>(200 + i));
+    }
+    for (auto k : keys) {
+      eprosima::xtypes::DynamicData key(key_type);
+      key = k;
+      sent["table"][key] = offset + k;
+    }
+    ASSERT_TRUE(ddsfmu::Converter::xtypes_to_fastdds(sent, fastdds_data.get()));
+    ASSERT_TRUE(ddsfmu::Converter::fastdds_to_xtypes(fastdds_data.get(), received));
+    EXPECT_EQ(sent, received);
+  };
+
+  round_trip(5, {1, 2, 3}, 0.0);
+  round_trip(2, {1, 2, 3}, 10.0);
+  round_trip(7, {2, 4}, 20.0);
+  round_trip(0, {}, 30.0);
+
+  ddsfmu::Converter::clear_data_structures();
+}
+
+TEST(XTypes, SequenceLengths) {
+  std::string my_idl = R"~~~(
+  struct Bounded
+  {
+    sequence<double, 4> values;
+  };
+  )~~~";
+
+  eprosima::xtypes::idl::Context context;
+  context.preprocess = false;
+  context = eprosima::xtypes::idl::parse(my_idl, context);
+  ASSERT_TRUE(context.success) << "IDL parsing successful";
+  const auto& bounded_type = context.module().structure("Bounded");
+
+  namespace etypes = eprosima::fastrtps::types;
+  etypes::DynamicTypeBuilder* builder = ddsfmu::Converter::create_builder(bounded_type);
+  ASSERT_NE(builder, nullptr);
+  etypes::DynamicData_ptr fastdds_data(
+    etypes::DynamicDataFactory::get_instance()->create_data(builder->build()));
+
+  // Both sides keep their sequence at its bound, with lengths of their own
+  eprosima::xtypes::DynamicData sent(bounded_type), received(bounded_type);
+  sent["values"].resize(4);
+  received["values"].resize(4);
+  for (std::size_t i = 0; i < 4; ++i) { sent["values"][i] = static_cast<double>(i + 1); }
+  std::uint32_t sent_length = 2, received_length = 0;
+  ddsfmu::Converter::SequenceLengths sent_lengths{{sent["values"].instance_id(), &sent_length}};
+  ddsfmu::Converter::SequenceLengths received_lengths{
+    {received["values"].instance_id(), &received_length}};
+
+  ASSERT_TRUE(ddsfmu::Converter::xtypes_to_fastdds(sent, fastdds_data.get(), &sent_lengths));
+  etypes::DynamicData* values = fastdds_data->loan_value(0);
+  ASSERT_NE(values, nullptr);
+  EXPECT_EQ(2u, values->get_item_count());
+  fastdds_data->return_loaned_value(values);
+
+  ASSERT_TRUE(
+    ddsfmu::Converter::fastdds_to_xtypes(fastdds_data.get(), received, &received_lengths));
+  EXPECT_EQ(2u, received_length);
+  EXPECT_EQ(4u, received["values"].size());
+  EXPECT_EQ(1.0, received["values"][0].value<double>());
+  EXPECT_EQ(2.0, received["values"][1].value<double>());
+
+  // Without lengths, sequences are converted at their size
+  ASSERT_TRUE(ddsfmu::Converter::xtypes_to_fastdds(sent, fastdds_data.get()));
+  values = fastdds_data->loan_value(0);
+  ASSERT_NE(values, nullptr);
+  EXPECT_EQ(4u, values->get_item_count());
+  fastdds_data->return_loaned_value(values);
+
+  ddsfmu::Converter::clear_data_structures();
+}
+
+TEST(XTypes, TypeObjects) {
+  std::string my_idl = R"~~~(
+  enum Mode {
+    IDLE, ACTIVE, FAULT
+  };
+
+  union Command switch (int32)
+  {
+    case 1: double setpoint;
+    case 2: string<16> label;
+  };
+
+  struct Inner
+  {
+    double x;
+  };
+
+  module Space
+  {
+    struct Outer
+    {
+      @key uint32 id;
+      Mode mode;
+      Command command;
+      sequence<Inner> inners;
+      Inner pair[2];
+      string name;
+    };
+  };
+)~~~";
+
+  eprosima::xtypes::idl::Context context;
+  context.preprocess = false;
+  context = eprosima::xtypes::idl::parse(my_idl, context);
+
+  ddsfmu::detail::TypeObjectBundle bundle;
+  bundle.add(context.module().structure("Space::Outer"));
+
+  // Dependencies come first
+  ASSERT_EQ(bundle.entries().size(), 4);
+  EXPECT_EQ(bundle.entries()[0].name, "Mode");
+  EXPECT_EQ(bundle.entries()[1].name, "Command");
+  EXPECT_EQ(bundle.entries()[2].name, "Inner");
+  EXPECT_EQ(bundle.entries()[3].name, "Space::Outer");
+  EXPECT_TRUE(bundle.contains("Space::Outer"));
+  EXPECT_FALSE(bundle.contains("Outer"));
+
+  const auto& outer = bundle.entries()[3];
+  EXPECT_EQ(outer.complete_id._d(), eprosima::fastrtps::types::EK_COMPLETE);
+  EXPECT_EQ(outer.minimal_id._d(), eprosima::fastrtps::types::EK_MINIMAL);
+  ASSERT_EQ(outer.complete.complete().struct_type().member_seq().size(), 6);
+  EXPECT_TRUE(
+    outer.complete.complete().struct_type().member_seq()[0].common().member_flags().IS_KEY());
+  EXPECT_EQ(
+    outer.complete.complete().struct_type().member_seq()[1].common().member_type_id(),
+    bundle.entries()[0].complete_id);
+
+  // Identifiers are hashes of the type, so they are reproducible
+  ddsfmu::detail::TypeObjectBundle rebuilt;
+  rebuilt.add(context.module().structure("Space::Outer"));
+  EXPECT_EQ(rebuilt.entries()[3].complete_id, outer.complete_id);
+  EXPECT_EQ(rebuilt.entries()[3].minimal_id, outer.minimal_id);
+
+  auto file = std::filesystem::temp_directory_path() / "ddsfmu_type_objects_test.bin";
+  bundle.save(file);
+  auto loaded = ddsfmu::detail::TypeObjectBundle::load(file);
+  std::filesystem::remove(file);
+
+  ASSERT_EQ(loaded.entries().size(), bundle.entries().size());
+  for (std::size_t i = 0; i < loaded.entries().size(); ++i) {
+    EXPECT_EQ(loaded.entries()[i].name, bundle.entries()[i].name);
+    EXPECT_EQ(loaded.entries()[i].complete_id, bundle.entries()[i].complete_id);
+    EXPECT_EQ(loaded.entries()[i].complete, bundle.entries()[i].complete);
+    EXPECT_EQ(loaded.entries()[i].minimal_id, bundle.entries()[i].minimal_id);
+    EXPECT_EQ(loaded.entries()[i].minimal, bundle.entries()[i].minimal);
+  }
+
+  EXPECT_THROW(ddsfmu::detail::TypeObjectBundle::load(file), std::runtime_error);
+}
+
+TEST(XTypes, TypeObjectsMatchFastDds) {
+  // Fast-dds builds TypeObjects as fastddsgen for structures of primitives
+  namespace etypes = eprosima::fastrtps::types;
+  auto* builders = etypes::DynamicTypeBuilderFactory::get_instance();
+
+  etypes::DynamicTypeBuilder_ptr struct_builder = builders->create_struct_builder();
+  struct_builder->add_member(0, "id", builders->create_uint32_builder().get());
+  struct_builder->add_member(1, "value", builders->create_float64_builder().get());
+  struct_builder->add_member(2, "flag", builders->create_bool_builder().get());
+  struct_builder->add_member(3, "count", builders->create_int16_builder().get());
+  struct_builder->set_name("ReferencePrimitives");
+  etypes::DynamicType_ptr reference = struct_builder->build();
+
+  std::map<etypes::MemberId, etypes::DynamicTypeMember*> members_map;
+  reference->get_all_members(members_map);
+  std::vector<const etypes::MemberDescriptor*> members;
+  for (const auto& member : members_map) { members.push_back(member.second->get_descriptor()); }
+
+  etypes::TypeObject complete_object, minimal_object;
+  builders->build_type_object(reference->get_type_descriptor(), complete_object, &members, true);
+  builders->build_type_object(reference->get_type_descriptor(), minimal_object, &members, false);
+  const auto* complete_id =
+    etypes::TypeObjectFactory::get_instance()->get_type_identifier("ReferencePrimitives", true);
+  const auto* minimal_id =
+    etypes::TypeObjectFactory::get_instance()->get_type_identifier("ReferencePrimitives", false);
+  ASSERT_NE(complete_id, nullptr);
+  ASSERT_NE(minimal_id, nullptr);
+  const etypes::TypeIdentifier expected_complete = *complete_id;
+  const etypes::TypeIdentifier expected_minimal = *minimal_id;
+
+  std::string my_idl = R"~~~(
+    struct ReferencePrimitives
+    {
+      uint32 id;
+      double value;
+      boolean flag;
+      int16 count;
+    };
+  )~~~";
+
+  eprosima::xtypes::idl::Context context;
+  context.preprocess = false;
+  context = eprosima::xtypes::idl::parse(my_idl, context);
+
+  ddsfmu::detail::TypeObjectBundle bundle;
+  bundle.add(context.module().structure("ReferencePrimitives"));
+  ASSERT_EQ(bundle.entries().size(), 1);
+
+  // Peers compare the hashes, so they must be equal to interoperate
+  const auto& entry = bundle.entries()[0];
+  EXPECT_EQ(entry.complete, complete_object);
+  EXPECT_EQ(entry.minimal, minimal_object);
+  EXPECT_EQ(entry.complete_id, expected_complete);
+  EXPECT_EQ(entry.minimal_id, expected_minimal);
+}